@@ -0,0 +1,166 @@
+// Score-at-a-time по индексу в раскладке по вкладам: задержка и качество top-k
+// при разных бюджетах постингов и времени против точного подсчета по тем же вкладам.
+// Запуск: ./AnytimeBench [документов] [запросов] [k] [бит вклада]
+#include "BenchUtils.hpp"
+#include "core/InvertedIndex.hpp"
+#include "core/MappedIndex.hpp"
+#include "ranking/Scorer.hpp"
+#include "ranking/ImpactIndex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
+int main(int argc, char *argv[])
+{
+    const size_t docCount = bench::argOr(argc, argv, 1, 200000);
+    const size_t queryCount = bench::argOr(argc, argv, 2, 500);
+    const size_t k = bench::argOr(argc, argv, 3, 10);
+    const uint32_t bits = static_cast<uint32_t>(bench::argOr(argc, argv, 4, 8));
+    const size_t vocabularySize = 100000;
+
+    std::vector<std::string> vocabulary = bench::randomTerms(vocabularySize);
+
+    // Частоты слов по закону Ципфа, длины документов сильно разнятся
+    std::vector<double> cumulative(vocabularySize);
+    double sum = 0;
+    for (size_t i = 0; i < vocabularySize; ++i)
+    {
+        sum += 1.0 / (double)(i + 1);
+        cumulative[i] = sum;
+    }
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    std::uniform_int_distribution<size_t> length(20, 400);
+    auto randomRank = [&]()
+    {
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+        return std::min(rank, vocabularySize - 1);
+    };
+
+    InvertedIndex built;
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        size_t terms = length(rng);
+        for (size_t j = 0; j < terms; ++j)
+            built.addTerm(vocabulary[randomRank()], doc);
+        built.incrementDocCount();
+    }
+
+    const std::string tfPath = "anytime_bench_tf.bin";
+    const std::string impactPath = "anytime_bench_impacts.bin";
+    const std::string orderedPath = "anytime_bench_ordered.bin";
+    built.save(tfPath);
+    built.clear();
+    if (!ImpactIndex::build(tfPath, impactPath, bits) ||
+        !ImpactIndex::build(tfPath, orderedPath, bits, BlockCodec::VarByte, Bm25Scoring(), IndexLayout::ImpactOrdered))
+    {
+        std::fprintf(stderr, "Failed to build %u-bit impact indexes\n", bits);
+        return 1;
+    }
+
+    MappedIndex impacts, ordered;
+    impacts.open(impactPath);
+    ordered.open(orderedPath);
+
+    // Запросы автодополнения: 2-4 слова, первые - частые
+    std::vector<std::vector<std::string>> queries(queryCount);
+    for (auto &query : queries)
+    {
+        size_t words = 2 + rng() % 3;
+        for (size_t w = 0; w < words; ++w)
+            query.push_back(vocabulary[w < 2 ? randomRank() / 16 : randomRank()]);
+    }
+
+    // Эталон: точный top-k по вкладам и полные скоры для NDCG
+    std::vector<std::vector<SearchResult>> exactTop(queries.size());
+    std::vector<std::unordered_map<uint32_t, double>> exactScores(queries.size());
+    bench::Stopwatch exactTimer;
+    for (size_t q = 0; q < queries.size(); ++q)
+        exactTop[q] = BasicScorer<ImpactScoring>::search(queries[q], impacts, nullptr, k, QueryStrategy::MaxScore);
+    double exactMs = exactTimer.elapsedMs() / queries.size();
+    for (size_t q = 0; q < queries.size(); ++q)
+    {
+        for (const auto &result : BasicScorer<ImpactScoring>::search(queries[q], impacts))
+            exactScores[q][result.docId] = result.score;
+    }
+
+    auto dcg = [&](const std::vector<SearchResult> &ranking, const std::unordered_map<uint32_t, double> &gains)
+    {
+        double value = 0;
+        for (size_t i = 0; i < ranking.size(); ++i)
+        {
+            auto gain = gains.find(ranking[i].docId);
+            if (gain != gains.end())
+                value += gain->second / std::log2((double)i + 2);
+        }
+        return value;
+    };
+
+    std::printf("%zu docs, %u-bit impacts, %zu queries of 2-4 words, top-%zu\n\n", docCount, bits, queries.size(), k);
+    std::printf("  evaluation               ms/query   postings/query   stopped   overlap@k   NDCG@k\n");
+    std::printf("  %-24s %8.3f %16s %9s %11.4f %8.4f\n", "maxscore (exact)", exactMs, "-", "-", 1.0, 1.0);
+
+    struct Row
+    {
+        const char *name;
+        AnytimeBudget budget;
+    };
+    const Row rows[] = {
+        {"saat, no budget", {0, 0}},
+        {"saat, 100000 postings", {100000, 0}},
+        {"saat, 20000 postings", {20000, 0}},
+        {"saat, 5000 postings", {5000, 0}},
+        {"saat, 1000 postings", {1000, 0}},
+        {"saat, 1 ms", {0, 1.0}},
+        {"saat, 0.2 ms", {0, 0.2}},
+        {"saat, 0.05 ms", {0, 0.05}},
+    };
+
+    for (const Row &row : rows)
+    {
+        std::vector<std::vector<SearchResult>> results(queries.size());
+        size_t postings = 0, stopped = 0;
+        bench::Stopwatch timer;
+        for (size_t q = 0; q < queries.size(); ++q)
+        {
+            SearchStats stats;
+            results[q] = AnytimeScorer::search(queries[q], ordered, k, row.budget, &stats);
+            postings += stats.postingsScored;
+            stopped += stats.budgetExhausted;
+        }
+        double ms = timer.elapsedMs() / queries.size();
+
+        double overlap = 0, ndcg = 0;
+        for (size_t q = 0; q < queries.size(); ++q)
+        {
+            const auto &exact = exactTop[q];
+            if (exact.empty())
+            {
+                overlap += 1;
+                ndcg += 1;
+                continue;
+            }
+
+            size_t common = 0;
+            for (const auto &result : results[q])
+            {
+                for (const auto &reference : exact)
+                    common += result.docId == reference.docId;
+            }
+            overlap += (double)common / exact.size();
+            ndcg += dcg(results[q], exactScores[q]) / dcg(exact, exactScores[q]);
+        }
+
+        std::printf("  %-24s %8.3f %16.0f %8.1f%% %11.4f %8.4f\n", row.name, ms, (double)postings / queries.size(),
+                    100.0 * stopped / queries.size(), overlap / queries.size(), ndcg / queries.size());
+    }
+
+    impacts.close();
+    ordered.close();
+    for (const std::string &path : {tfPath, impactPath, orderedPath})
+    {
+        InvertedIndex::removeFiles(path);
+    }
+    return 0;
+}
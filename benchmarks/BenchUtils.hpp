@@ -0,0 +1,71 @@
+#ifndef BENCH_UTILS_HPP
+#define BENCH_UTILS_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    class Stopwatch
+    {
+    private:
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    public:
+        double elapsedMs() const
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    // Не даём компилятору выбросить результат замера
+    template <typename T>
+    inline void doNotOptimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Аргумент командной строки как число, либо значение по умолчанию
+    inline size_t argOr(int argc, char *argv[], int pos, size_t fallback)
+    {
+        return argc > pos ? std::strtoull(argv[pos], nullptr, 10) : fallback;
+    }
+
+    // Уникальные "слова" из кириллических букв в UTF-8, длиной как у реальных лемм
+    inline std::vector<std::string> randomTerms(size_t count, uint32_t seed = 42)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> length(3, 12);
+        std::uniform_int_distribution<int> letter(0, 31);
+
+        std::vector<std::string> terms;
+        terms.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string term;
+            int len = length(rng);
+            for (int j = 0; j < len; ++j)
+            {
+                // а..я: U+0430..U+044F
+                unsigned code = 0x0430 + letter(rng);
+                term.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                term.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            // Суффикс гарантирует уникальность
+            term += std::to_string(i);
+            terms.push_back(std::move(term));
+        }
+        return terms;
+    }
+
+    inline void printRow(const char *name, double ms, size_t ops)
+    {
+        std::printf("  %-34s %10.1f ms  %8.1f ns/op\n", name, ms, ms * 1e6 / (double)ops);
+    }
+}
+
+#endif
@@ -0,0 +1,211 @@
+// Булевы запросы: вычисление с промежуточными списками (копия списка на каждое слово,
+// новый вектор на каждый AND/OR/NOT) против дерева итераторов без копирования:
+// обход по одному документу (next) и выдача целиком пакетными ядрами (drain), а также
+// поконтейнерная алгебра над DocIdSet (Roaring) с отрицанием через флаг дополнения
+// Запуск: ./BooleanQueryBench [документов] [повторов]
+#include "BenchUtils.hpp"
+#include "core/BooleanIndex.hpp"
+#include "core/DocIdIterator.hpp"
+#include "core/DocIdSet.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+
+namespace
+{
+    using Docs = std::vector<uint32_t>;
+
+    // Вычисление с материализацией, как в старом QueryParser::parseBoolean.
+    // peak - наибольший суммарный размер живых промежуточных списков, байт
+    struct Materialized
+    {
+        BooleanIndex &index;
+        size_t live = 0;
+        size_t peak = 0;
+
+        Docs track(Docs docs)
+        {
+            live += docs.size() * sizeof(uint32_t);
+            peak = std::max(peak, live);
+            return docs;
+        }
+        void release(const Docs &docs) { live -= docs.size() * sizeof(uint32_t); }
+
+        Docs term(const std::string &word)
+        {
+            const DocIdSet *docs = index.getDocIds(word);
+            return track(docs ? docs->toVector() : Docs());
+        }
+        Docs opAnd(Docs a, Docs b)
+        {
+            Docs out;
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+            out = track(std::move(out));
+            release(a);
+            release(b);
+            return out;
+        }
+        Docs opOr(Docs a, Docs b)
+        {
+            Docs out;
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+            out = track(std::move(out));
+            release(a);
+            release(b);
+            return out;
+        }
+        Docs opNot(Docs a)
+        {
+            Docs out;
+            size_t pos = 0;
+            for (uint32_t doc = 0; doc < index.getTotalDocs(); ++doc)
+            {
+                if (pos < a.size() && a[pos] == doc)
+                    ++pos;
+                else
+                    out.push_back(doc);
+            }
+            out = track(std::move(out));
+            release(a);
+            return out;
+        }
+    };
+
+    std::vector<DocIdIteratorPtr> operands(DocIdIteratorPtr a, DocIdIteratorPtr b)
+    {
+        std::vector<DocIdIteratorPtr> list;
+        list.push_back(std::move(a));
+        list.push_back(std::move(b));
+        return list;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t docCount = bench::argOr(argc, argv, 1, 1000000);
+    const size_t repeats = bench::argOr(argc, argv, 2, 20);
+
+    // Слова разной частоты: в 50%, 20%, 5%, 0.5% и 0.01% документов
+    BooleanIndex index;
+    index.setTotalDocs(docCount);
+    const std::vector<std::pair<std::string, double>> words = {
+        {"half", 0.5}, {"fifth", 0.2}, {"twentieth", 0.05}, {"rare", 0.005}, {"unique", 0.0001}};
+    std::mt19937 rng(19);
+    for (const auto &[word, share] : words)
+    {
+        std::bernoulli_distribution pick(share);
+        for (uint32_t doc = 0; doc < docCount; ++doc)
+        {
+            if (pick(rng))
+                index.addTerm(word, doc);
+        }
+    }
+
+    struct Query
+    {
+        const char *text;
+        std::function<Docs(Materialized &)> materialized;
+        std::function<DocIdIteratorPtr()> tree;
+        std::function<DocIdSetExpr()> sets;
+    };
+    auto term = [&](const char *word)
+    { return index.openIterator(word); };
+    auto set = [&](const char *word)
+    { return index.openSet(word); };
+
+    const std::vector<Query> queries = {
+        {"half & rare",
+         [](Materialized &m)
+         { return m.opAnd(m.term("half"), m.term("rare")); },
+         [&]
+         { return std::make_unique<AndIterator>(operands(term("half"), term("rare"))); },
+         [&]
+         { return DocIdSetExpr::conjunction(set("half"), set("rare")); }},
+        {"(half | fifth) & unique",
+         [](Materialized &m)
+         { return m.opAnd(m.opOr(m.term("half"), m.term("fifth")), m.term("unique")); },
+         [&]
+         { return std::make_unique<AndIterator>(operands(std::make_unique<OrIterator>(operands(term("half"), term("fifth"))), term("unique"))); },
+         [&]
+         { return DocIdSetExpr::conjunction(DocIdSetExpr::disjunction(set("half"), set("fifth")), set("unique")); }},
+        {"twentieth & !fifth",
+         [](Materialized &m)
+         { return m.opAnd(m.term("twentieth"), m.opNot(m.term("fifth"))); },
+         [&]
+         { return std::make_unique<AndIterator>(operands(term("twentieth"), std::make_unique<NotIterator>(term("fifth"), docCount))); },
+         [&]
+         { return DocIdSetExpr::conjunction(set("twentieth"), DocIdSetExpr::negation(set("fifth"))); }},
+        {"fifth | twentieth",
+         [](Materialized &m)
+         { return m.opOr(m.term("fifth"), m.term("twentieth")); },
+         [&]
+         { return std::make_unique<OrIterator>(operands(term("fifth"), term("twentieth"))); },
+         [&]
+         { return DocIdSetExpr::disjunction(set("fifth"), set("twentieth")); }},
+        {"!rare",
+         [](Materialized &m)
+         { return m.opNot(m.term("rare")); },
+         [&]
+         { return std::make_unique<NotIterator>(term("rare"), docCount); },
+         [&]
+         { return DocIdSetExpr::negation(set("rare")); }},
+    };
+
+    // Размер постингов: простые списки (4 байта на документ) против контейнеров
+    index.runOptimize();
+    size_t listBytes = 0, setBytes = 0;
+    for (const auto &[word, share] : words)
+    {
+        listBytes += index.getDocIds(word)->size() * sizeof(uint32_t);
+        setBytes += index.getDocIds(word)->byteSize();
+    }
+
+    std::printf("Boolean queries, %zu docs, best of %zu runs\n", docCount, repeats);
+    std::printf("Postings: lists %.2f MB, containers %.2f MB\n\n", listBytes / 1048576.0, setBytes / 1048576.0);
+    std::printf("  query                       results   lists ms   lists peak MB   tree ms   drain ms   tree first-10 us   sets ms\n");
+    for (const Query &query : queries)
+    {
+        double listMs = 1e9, treeMs = 1e9, drainMs = 1e9, firstUs = 1e9, setMs = 1e9;
+        size_t peak = 0, results = 0, treeResults = 0, drainResults = 0, setResults = 0;
+        for (size_t r = 0; r < repeats; ++r)
+        {
+            Materialized m{index};
+            bench::Stopwatch listTimer;
+            Docs docs = query.materialized(m);
+            listMs = std::min(listMs, listTimer.elapsedMs());
+            peak = m.peak;
+            results = docs.size();
+
+            bench::Stopwatch treeTimer;
+            DocIdIteratorPtr tree = query.tree();
+            size_t count = 0;
+            for (; !tree->atEnd(); tree->next())
+                ++count;
+            treeMs = std::min(treeMs, treeTimer.elapsedMs());
+            treeResults = count;
+
+            bench::Stopwatch drainTimer;
+            drainResults = collectDocIds(*query.tree()).size();
+            drainMs = std::min(drainMs, drainTimer.elapsedMs());
+
+            // Показать первые 10 - дереву не нужно вычислять остальное
+            bench::Stopwatch firstTimer;
+            DocIdIteratorPtr top = query.tree();
+            for (size_t i = 0; i < 10 && !top->atEnd(); ++i)
+                top->next();
+            firstUs = std::min(firstUs, firstTimer.elapsedMs() * 1000);
+
+            // Дополнение не строится: размер считается по флагу
+            bench::Stopwatch setTimer;
+            setResults = query.sets().size(docCount);
+            setMs = std::min(setMs, setTimer.elapsedMs());
+        }
+
+        std::printf("  %-26s %9zu %10.3f %15.2f %9.3f %10.3f %18.1f %9.3f%s\n", query.text, results, listMs,
+                    peak / 1048576.0, treeMs, drainMs, firstUs, setMs,
+                    results == treeResults && results == drainResults && results == setResults ? "" : "   (results differ!)");
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Память и скорость поиска: распакованные постинги против сжатых (загруженный индекс)
+// Запуск: ./CompressedIndexBench [документов] [запросов]
+#include "BenchUtils.hpp"
+#include "core/InvertedIndex.hpp"
+#include "ranking/Scorer.hpp"
+#include <algorithm>
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    const size_t docCount = bench::argOr(argc, argv, 1, 100000);
+    const size_t queryCount = bench::argOr(argc, argv, 2, 2000);
+    const size_t termsPerDoc = 200;
+    const size_t vocabularySize = 100000;
+
+    std::vector<std::string> vocabulary = bench::randomTerms(vocabularySize);
+
+    // Частоты слов по закону Ципфа
+    std::vector<double> cumulative(vocabularySize);
+    double sum = 0;
+    for (size_t i = 0; i < vocabularySize; ++i)
+    {
+        sum += 1.0 / (double)(i + 1);
+        cumulative[i] = sum;
+    }
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    auto randomRank = [&]()
+    {
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+        return std::min(rank, vocabularySize - 1);
+    };
+
+    InvertedIndex built;
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        for (size_t j = 0; j < termsPerDoc; ++j)
+            built.addTerm(vocabulary[randomRank()], doc);
+        built.incrementDocCount();
+    }
+
+    const std::string path = "compressed_index_bench.bin";
+    built.save(path);
+    InvertedIndex loaded;
+    loaded.load(path);
+    InvertedIndex::removeFiles(path);
+
+    // Запросы из 2-4 слов; частые слова попадаются чаще, как в жизни
+    std::vector<std::vector<std::string>> queries(queryCount);
+    for (auto &query : queries)
+    {
+        size_t words = 2 + rng() % 3;
+        for (size_t w = 0; w < words; ++w)
+            query.push_back(vocabulary[randomRank() / 4]);
+    }
+
+    std::printf("InvertedIndex: %zu docs x %zu terms, %zu queries\n\n", docCount, termsPerDoc, queryCount);
+    std::printf("  memory: in-memory %.1f MB, loaded (compressed) %.1f MB\n\n",
+                built.memoryUsage() / 1048576.0, loaded.memoryUsage() / 1048576.0);
+
+    for (int round = 0; round < 2; ++round)
+    {
+        bench::Stopwatch plainTimer;
+        for (const auto &query : queries)
+            bench::doNotOptimize(Scorer::search(query, built).size());
+        bench::printRow("search, Posting lists", plainTimer.elapsedMs(), queryCount);
+
+        bench::Stopwatch packedTimer;
+        for (const auto &query : queries)
+            bench::doNotOptimize(Scorer::search(query, loaded).size());
+        bench::printRow("search, compressed cursors", packedTimer.elapsedMs(), queryCount);
+    }
+
+    return 0;
+}
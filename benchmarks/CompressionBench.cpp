@@ -0,0 +1,60 @@
+// Скорость распаковки и размер блочных кодеков на дельтах docId и TF
+// Запуск: ./CompressionBench [блоков] [повторов]
+#include "BenchUtils.hpp"
+#include "utils/Compression.hpp"
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    const size_t blockCount = bench::argOr(argc, argv, 1, 20000);
+    const size_t repeats = bench::argOr(argc, argv, 2, 20);
+    const size_t n = Compression::kMaxBlockValues;
+
+    // Дельты частого и редкого слова и TF: геометрические распределения разной ширины
+    struct Workload
+    {
+        const char *name;
+        double meanGap;
+    };
+    const Workload workloads[] = {{"dense deltas (mean 3)", 3}, {"sparse deltas (mean 300)", 300}, {"tf (mean 1.5)", 1.5}};
+
+    for (const auto &workload : workloads)
+    {
+        std::mt19937 rng(11);
+        std::geometric_distribution<uint32_t> gap(1.0 / workload.meanGap);
+        std::vector<uint32_t> values(blockCount * n);
+        for (auto &v : values)
+            v = gap(rng) + 1;
+
+        std::printf("%s, %zu x %zu values\n", workload.name, blockCount, n);
+        std::printf("  codec          bytes/int   decode ms   Mints/sec\n");
+        for (BlockCodec codec : {BlockCodec::VarByte, BlockCodec::StreamVByte, BlockCodec::BitPacking})
+        {
+            std::vector<uint8_t> encoded;
+            for (size_t b = 0; b < blockCount; ++b)
+                Compression::encodeBlock(codec, values.data() + b * n, n, encoded);
+
+            uint32_t decoded[Compression::kMaxBlockValues];
+            uint64_t checksum = 0;
+            bench::Stopwatch timer;
+            for (size_t r = 0; r < repeats; ++r)
+            {
+                size_t pos = 0;
+                for (size_t b = 0; b < blockCount; ++b)
+                {
+                    Compression::decodeBlock(codec, encoded.data(), encoded.size(), pos, decoded, n);
+                    checksum += decoded[b % n];
+                }
+            }
+            double ms = timer.elapsedMs();
+            bench::doNotOptimize(checksum);
+
+            double ints = (double)values.size() * repeats;
+            std::printf("  %-13s %10.2f %11.1f %11.0f\n", Compression::codecName(codec),
+                        (double)encoded.size() / values.size(), ms, ints / (ms * 1000.0));
+        }
+        std::printf("\n");
+    }
+
+    return 0;
+}
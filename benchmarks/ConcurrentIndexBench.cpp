@@ -0,0 +1,86 @@
+// Масштабирование ConcurrentInvertedIndex по числу потоков
+// Запуск: ./ConcurrentIndexBench [документов] [макс_потоков]
+#include "BenchUtils.hpp"
+#include "core/ConcurrentInvertedIndex.hpp"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    const size_t docCount = bench::argOr(argc, argv, 1, 100000);
+    const size_t maxThreads = std::max<size_t>(1, bench::argOr(argc, argv, 2, std::max(1u, std::thread::hardware_concurrency())));
+    const size_t termsPerDoc = 300;
+    const size_t vocabularySize = 200000;
+    const size_t docPool = 2000; // Документы повторяются по кругу, чтобы не тратить память
+
+    std::vector<std::string> vocabulary = bench::randomTerms(vocabularySize);
+
+    // Частоты слов по закону Ципфа, как в реальном корпусе
+    std::vector<double> cumulative(vocabularySize);
+    double sum = 0;
+    for (size_t i = 0; i < vocabularySize; ++i)
+    {
+        sum += 1.0 / (double)(i + 1);
+        cumulative[i] = sum;
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    std::vector<std::vector<std::string_view>> pool(docPool);
+    for (auto &doc : pool)
+    {
+        doc.reserve(termsPerDoc);
+        for (size_t j = 0; j < termsPerDoc; ++j)
+        {
+            size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+            doc.push_back(vocabulary[std::min(rank, vocabularySize - 1)]);
+        }
+    }
+
+    std::printf("ConcurrentInvertedIndex: %zu docs x %zu terms, vocabulary %zu\n\n",
+                docCount, termsPerDoc, vocabularySize);
+    std::printf("  threads   add ms   finalize ms     docs/sec   speedup\n");
+
+    // Степени двойки меньше maxThreads, последним шагом - ровно maxThreads
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    double baseline = 0;
+    for (size_t threads : threadCounts)
+    {
+        ConcurrentInvertedIndex index;
+        std::atomic<uint32_t> nextDoc{0};
+
+        bench::Stopwatch addTimer;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&]()
+                                 {
+                uint32_t docId;
+                while ((docId = nextDoc.fetch_add(1)) < docCount)
+                {
+                    index.addDocument(docId, pool[docId % docPool]);
+                    index.incrementDocCount();
+                } });
+        }
+        for (auto &w : workers)
+            w.join();
+        double addMs = addTimer.elapsedMs();
+
+        bench::Stopwatch finalizeTimer;
+        InvertedIndex result = index.finalize();
+        double finalizeMs = finalizeTimer.elapsedMs();
+        bench::doNotOptimize(result.getTermCount());
+
+        double docsPerSec = docCount / (addMs / 1000.0);
+        if (threads == 1)
+            baseline = docsPerSec;
+        std::printf("  %7zu %8.1f %13.1f %12.0f %8.2fx\n", threads, addMs, finalizeMs, docsPerSec, docsPerSec / baseline);
+    }
+
+    return 0;
+}
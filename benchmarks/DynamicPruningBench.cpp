@@ -0,0 +1,125 @@
+// Top-k по многословным запросам: полный обход против WAND, Block-Max WAND и MaxScore,
+// а также ранжированный AND (searchConjunctive, при нехватке документов - MaxScore по OR)
+// Запуск: ./DynamicPruningBench [документов] [запросов] [k]
+#include "BenchUtils.hpp"
+#include "core/InvertedIndex.hpp"
+#include "ranking/Scorer.hpp"
+#include <algorithm>
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    const size_t docCount = bench::argOr(argc, argv, 1, 200000);
+    const size_t queryCount = bench::argOr(argc, argv, 2, 500);
+    const size_t topK = bench::argOr(argc, argv, 3, 10);
+    const size_t termsPerDoc = 200;
+    const size_t vocabularySize = 100000;
+
+    std::vector<std::string> vocabulary = bench::randomTerms(vocabularySize);
+
+    // Частоты слов по закону Ципфа
+    std::vector<double> cumulative(vocabularySize);
+    double sum = 0;
+    for (size_t i = 0; i < vocabularySize; ++i)
+    {
+        sum += 1.0 / (double)(i + 1);
+        cumulative[i] = sum;
+    }
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    auto randomRank = [&]()
+    {
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+        return std::min(rank, vocabularySize - 1);
+    };
+
+    InvertedIndex built;
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        for (size_t j = 0; j < termsPerDoc; ++j)
+            built.addTerm(vocabulary[randomRank()], doc);
+        built.incrementDocCount();
+    }
+
+    const std::string path = "dynamic_pruning_bench.bin";
+    built.save(path);
+    InvertedIndex index;
+    index.load(path);
+    InvertedIndex::removeFiles(path);
+
+    // Короткие запросы из 2-5 слов: одно-два частых слова вперемешку с более редкими.
+    // Заголовки новостей из 8-12 слов: в основном частые слова, пара редких
+    std::vector<std::vector<std::string>> shortQueries(queryCount), headlines(queryCount);
+    for (auto &query : shortQueries)
+    {
+        size_t words = 2 + rng() % 4;
+        for (size_t w = 0; w < words; ++w)
+            query.push_back(vocabulary[w < 2 ? randomRank() / 64 : randomRank()]);
+    }
+    for (auto &query : headlines)
+    {
+        size_t words = 8 + rng() % 5;
+        for (size_t w = 0; w < words; ++w)
+            query.push_back(vocabulary[w < 2 ? randomRank() : randomRank() / 256]);
+    }
+
+    std::printf("Scorer::search top-%zu, %zu docs x %zu terms, %zu queries per set\n", topK, docCount, termsPerDoc, queryCount);
+
+    const std::pair<const char *, QueryStrategy> strategies[] = {
+        {"exhaustive", QueryStrategy::Exhaustive},
+        {"wand", QueryStrategy::Wand},
+        {"block-max wand", QueryStrategy::BlockMaxWand},
+        {"maxscore", QueryStrategy::MaxScore}};
+    for (const auto &[setName, queries] : {std::make_pair("2-5 words", &shortQueries), std::make_pair("headlines, 8-12 words", &headlines)})
+    {
+        std::printf("\n%s\n", setName);
+        std::printf("  strategy        ms/query   postings scored/query   mismatches\n");
+
+        std::vector<std::vector<SearchResult>> expected;
+        for (const auto &[name, strategy] : strategies)
+        {
+            size_t scored = 0;
+            size_t mismatches = 0;
+            std::vector<std::vector<SearchResult>> results(queries->size());
+
+            bench::Stopwatch timer;
+            for (size_t q = 0; q < queries->size(); ++q)
+            {
+                SearchStats stats;
+                results[q] = Scorer::search((*queries)[q], index, nullptr, topK, strategy, &stats);
+                scored += stats.postingsScored;
+            }
+            double ms = timer.elapsedMs();
+
+            if (expected.empty())
+                expected = results;
+            for (size_t q = 0; q < queries->size(); ++q)
+            {
+                bool same = results[q].size() == expected[q].size();
+                for (size_t i = 0; same && i < results[q].size(); ++i)
+                    same = results[q][i].docId == expected[q][i].docId && results[q][i].score == expected[q][i].score;
+                mismatches += !same;
+            }
+
+            std::printf("  %-15s %8.3f %23.0f %12zu\n", name, ms / queries->size(),
+                        (double)scored / queries->size(), mismatches);
+        }
+
+        // Выдача AND другая, поэтому вместо расхождений - число запросов, ушедших в OR
+        size_t scored = 0;
+        size_t fallbacks = 0;
+        bench::Stopwatch timer;
+        for (const auto &query : *queries)
+        {
+            SearchStats stats;
+            Scorer::searchConjunctive(query, index, topK, QueryStrategy::MaxScore, &stats);
+            scored += stats.postingsScored;
+            fallbacks += stats.conjunctiveFallback;
+        }
+        double ms = timer.elapsedMs();
+        std::printf("  %-15s %8.3f %23.0f %12s   (%zu fell back to OR)\n", "ranked and", ms / queries->size(),
+                    (double)scored / queries->size(), "-", fallbacks);
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Ранжирование с фильтром документов ("булев фильтр, затем ранжирование") при разной
+// доле разрешенных документов: список allowedDocIds против готового DocIdFilter, а также
+// булев запрос: список кандидатов и поиск по нему против ранжирования потока кандидатов
+// Запуск: ./FilteredSearchBench [документов] [запросов]
+#include "BenchUtils.hpp"
+#include "core/InvertedIndex.hpp"
+#include "ranking/Scorer.hpp"
+#include "core/BooleanQuery.hpp"
+#include <algorithm>
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    const size_t docCount = bench::argOr(argc, argv, 1, 200000);
+    const size_t queryCount = bench::argOr(argc, argv, 2, 300);
+    const size_t termsPerDoc = 150;
+    const size_t vocabularySize = 50000;
+
+    std::vector<std::string> vocabulary = bench::randomTerms(vocabularySize);
+
+    std::vector<double> cumulative(vocabularySize);
+    double sum = 0;
+    for (size_t i = 0; i < vocabularySize; ++i)
+    {
+        sum += 1.0 / (double)(i + 1);
+        cumulative[i] = sum;
+    }
+    std::mt19937 rng(18);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    auto randomRank = [&]()
+    {
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+        return std::min(rank, vocabularySize - 1);
+    };
+
+    InvertedIndex built;
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        for (size_t j = 0; j < termsPerDoc; ++j)
+            built.addTerm(vocabulary[randomRank()], doc);
+        built.incrementDocCount();
+    }
+
+    const std::string path = "filtered_search_bench.bin";
+    built.save(path);
+    built.clear();
+    InvertedIndex index;
+    index.load(path);
+    InvertedIndex::removeFiles(path);
+
+    // Частые слова: длинные списки постингов
+    std::vector<std::vector<std::string>> queries(queryCount);
+    for (auto &query : queries)
+    {
+        size_t words = 2 + rng() % 3;
+        for (size_t w = 0; w < words; ++w)
+            query.push_back(vocabulary[randomRank() / 32]);
+    }
+
+    std::printf("Scorer::search with a document filter, %zu docs x %zu terms, %zu queries\n\n", docCount, termsPerDoc, queryCount);
+    std::printf("  allowed    strategy     list ms/query   filter ms/query\n");
+
+    for (double share : {0.0001, 0.001, 0.01, 0.1, 0.5})
+    {
+        std::vector<uint32_t> allowed;
+        std::bernoulli_distribution pick(share);
+        for (uint32_t doc = 0; doc < docCount; ++doc)
+        {
+            if (pick(rng))
+                allowed.push_back(doc);
+        }
+        DocIdFilter filter(allowed);
+
+        for (const auto &[name, strategy, topK] : {std::make_tuple("all", QueryStrategy::Exhaustive, Scorer::kAllResults),
+                                                   std::make_tuple("top-10 bmw", QueryStrategy::BlockMaxWand, (size_t)10)})
+        {
+            size_t checksum = 0;
+            bench::Stopwatch listTimer;
+            for (const auto &query : queries)
+                checksum += Scorer::search(query, index, &allowed, topK, strategy).size();
+            double listMs = listTimer.elapsedMs() / queries.size();
+
+            bench::Stopwatch filterTimer;
+            for (const auto &query : queries)
+                checksum -= Scorer::search(query, index, filter, topK, strategy).size();
+            double filterMs = filterTimer.elapsedMs() / queries.size();
+
+            std::printf("  %6.2f%%    %-12s %13.3f %17.3f%s\n", share * 100, name, listMs, filterMs,
+                        checksum == 0 ? "" : "   (results differ!)");
+        }
+    }
+
+    // a & (b | c) & !d: кандидаты из итератора ранжируются по словам a, b, c
+    std::printf("\nBoolean filter a & (b | c) & !d, ranked by a, b, c\n\n");
+    std::printf("  results      two passes ms/query   one pass ms/query\n");
+    std::vector<BooleanNode> plans;
+    std::vector<std::vector<std::string>> rankingTerms;
+    for (size_t i = 0; i < queryCount; ++i)
+    {
+        BooleanNode query = BooleanNode::makeAnd(
+            BooleanNode::makeAnd(BooleanNode::makeTerm(vocabulary[randomRank() / 16]),
+                                 BooleanNode::makeOr(BooleanNode::makeTerm(vocabulary[randomRank() / 32]),
+                                                     BooleanNode::makeTerm(vocabulary[randomRank() / 32]))),
+            BooleanNode::makeNot(BooleanNode::makeTerm(vocabulary[randomRank()])));
+        rankingTerms.push_back(BooleanPlanner::rankingTerms(query));
+        plans.push_back(BooleanPlanner::plan(std::move(query), index));
+    }
+
+    for (size_t topK : {Scorer::kAllResults, (size_t)10})
+    {
+        size_t checksum = 0;
+        bench::Stopwatch twoPassTimer;
+        for (size_t q = 0; q < plans.size(); ++q)
+        {
+            std::vector<uint32_t> allowed = collectDocIds(*openBooleanIterator(plans[q], index));
+            checksum += Scorer::search(rankingTerms[q], index, &allowed, topK).size();
+        }
+        double twoPassMs = twoPassTimer.elapsedMs() / plans.size();
+
+        bench::Stopwatch onePassTimer;
+        for (size_t q = 0; q < plans.size(); ++q)
+        {
+            DocIdIteratorPtr candidates = openBooleanIterator(plans[q], index);
+            checksum -= Scorer::search(rankingTerms[q], index, *candidates, topK).size();
+        }
+        double onePassMs = onePassTimer.elapsedMs() / plans.size();
+
+        std::printf("  %-12s %19.3f %19.3f%s\n", topK == Scorer::kAllResults ? "all" : "top-10", twoPassMs, onePassMs,
+                    checksum == 0 ? "" : "   (results differ!)");
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Сравнение HashMap (открытая адресация) с прежней реализацией на цепочках
+// Запуск: ./HashMapBench [количество_терминов]
+#include "BenchUtils.hpp"
+#include "core/HashMap.hpp"
+#include <algorithm>
+
+// Прежняя реализация (вектор векторов, модуль по размеру таблицы, рехеш копированием)
+template <typename K, typename V>
+class ChainedHashMap
+{
+private:
+    struct Node
+    {
+        K key;
+        V value;
+        Node(K k, V v) : key(k), value(v) {}
+    };
+
+    std::vector<std::vector<Node>> buckets;
+    size_t tableSize;
+    size_t elementCount;
+    const float maxLoadFactor = 0.75f;
+
+    size_t hashFunction(const K &key) const { return std::hash<K>{}(key) % tableSize; }
+
+    void rehash()
+    {
+        size_t oldSize = tableSize;
+        tableSize *= 2;
+        auto oldBuckets = std::move(buckets);
+        buckets.assign(tableSize, std::vector<Node>());
+        elementCount = 0;
+        for (size_t i = 0; i < oldSize; ++i)
+            for (auto &node : oldBuckets[i])
+                insert(node.key, node.value);
+    }
+
+public:
+    ChainedHashMap(size_t initialSize = 1009) : tableSize(initialSize), elementCount(0)
+    {
+        buckets.resize(tableSize);
+    }
+
+    void insert(const K &key, const V &value)
+    {
+        if ((float)elementCount / tableSize > maxLoadFactor)
+            rehash();
+        size_t index = hashFunction(key);
+        for (auto &node : buckets[index])
+        {
+            if (node.key == key)
+            {
+                node.value = value;
+                return;
+            }
+        }
+        buckets[index].emplace_back(key, value);
+        elementCount++;
+    }
+
+    V *get(const K &key)
+    {
+        size_t index = hashFunction(key);
+        for (auto &node : buckets[index])
+            if (node.key == key)
+                return &node.value;
+        return nullptr;
+    }
+};
+
+template <typename Map, typename Lookup>
+void runStringSuite(const char *title, const std::vector<std::string> &terms,
+                    const std::vector<std::string> &probes, const std::vector<std::string> &misses,
+                    Lookup lookup)
+{
+    std::printf("%s\n", title);
+    Map map;
+
+    bench::Stopwatch insertTimer;
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+        // Как addTerm: сначала поиск, потом вставка
+        if (lookup(map, terms[i]) == nullptr)
+            map.insert(terms[i], (uint32_t)i);
+    }
+    bench::printRow("insert (get + insert)", insertTimer.elapsedMs(), terms.size());
+
+    uint64_t checksum = 0;
+    bench::Stopwatch hitTimer;
+    for (const auto &term : probes)
+        checksum += *lookup(map, term);
+    bench::printRow("lookup hit", hitTimer.elapsedMs(), probes.size());
+
+    bench::Stopwatch missTimer;
+    for (const auto &term : misses)
+        checksum += lookup(map, term) == nullptr;
+    bench::printRow("lookup miss", missTimer.elapsedMs(), misses.size());
+
+    bench::doNotOptimize(checksum);
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t termCount = bench::argOr(argc, argv, 1, 1000000);
+    std::printf("HashMap benchmark: %zu terms\n\n", termCount);
+
+    std::vector<std::string> terms = bench::randomTerms(termCount, 1);
+    std::vector<std::string> misses = bench::randomTerms(termCount, 2);
+    for (auto &term : misses)
+        term += "#"; // Гарантированно отсутствующие ключи
+
+    std::vector<std::string> probes = terms;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937(3));
+
+    runStringSuite<ChainedHashMap<std::string, uint32_t>>(
+        "ChainedHashMap<std::string, uint32_t> (old)", terms, probes, misses,
+        [](auto &map, const std::string &key)
+        { return map.get(key); });
+
+    runStringSuite<HashMap<std::string, uint32_t>>(
+        "HashMap<std::string, uint32_t> (open addressing)", terms, probes, misses,
+        [](auto &map, const std::string &key)
+        { return map.get(key); });
+
+    // Ключи запроса как string_view (так их получает парсер запроса)
+    runStringSuite<HashMap<std::string, uint32_t>>(
+        "HashMap<std::string, uint32_t> via std::string_view", terms, probes, misses,
+        [](auto &map, const std::string &key)
+        { return map.get(std::string_view(key)); });
+
+    // Аккумулятор скоров Scorer: плотные целые ключи
+    std::printf("uint32_t -> double (docScores)\n");
+    {
+        ChainedHashMap<uint32_t, double> chained;
+        bench::Stopwatch timer;
+        for (uint32_t i = 0; i < termCount; ++i)
+        {
+            double *score = chained.get(i % (termCount / 4 + 1));
+            if (score)
+                *score += 1.0;
+            else
+                chained.insert(i % (termCount / 4 + 1), 1.0);
+        }
+        bench::printRow("old accumulate", timer.elapsedMs(), termCount);
+    }
+    {
+        HashMap<uint32_t, double> open;
+        bench::Stopwatch timer;
+        for (uint32_t i = 0; i < termCount; ++i)
+        {
+            double *score = open.get(i % (termCount / 4 + 1));
+            if (score)
+                *score += 1.0;
+            else
+                open.insert(i % (termCount / 4 + 1), 1.0);
+        }
+        bench::printRow("new accumulate", timer.elapsedMs(), termCount);
+    }
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+// Насколько квантованные вклады (ImpactIndex) расходятся с точным BM25 при разной
+// разрядности: совпадение top-k, NDCG@k, размер файла и время запроса.
+// Запуск: ./ImpactDivergence [index.bin] [запросов] [k]
+// Без index.bin строится синтетическая коллекция (закон Ципфа).
+#include "BenchUtils.hpp"
+#include "core/InvertedIndex.hpp"
+#include "core/MappedIndex.hpp"
+#include "ranking/Scorer.hpp"
+#include "ranking/ImpactIndex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <unordered_map>
+
+namespace
+{
+    std::string buildSyntheticIndex()
+    {
+        const size_t docCount = 50000;
+        const size_t vocabularySize = 50000;
+        std::vector<std::string> vocabulary = bench::randomTerms(vocabularySize);
+
+        std::vector<double> cumulative(vocabularySize);
+        double sum = 0;
+        for (size_t i = 0; i < vocabularySize; ++i)
+        {
+            sum += 1.0 / (double)(i + 1);
+            cumulative[i] = sum;
+        }
+        std::mt19937 rng(21);
+        std::uniform_real_distribution<double> uniform(0.0, sum);
+        std::uniform_int_distribution<size_t> length(20, 600); // Длины страниц сильно разнятся
+
+        InvertedIndex index;
+        for (uint32_t doc = 0; doc < docCount; ++doc)
+        {
+            size_t terms = length(rng);
+            for (size_t j = 0; j < terms; ++j)
+            {
+                size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+                index.addTerm(vocabulary[std::min(rank, vocabularySize - 1)], doc);
+            }
+            index.incrementDocCount();
+        }
+
+        const std::string path = "impact_divergence_source.bin";
+        index.save(path);
+        return path;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const bool synthetic = argc < 2;
+    const std::string sourcePath = synthetic ? buildSyntheticIndex() : argv[1];
+    const size_t queryCount = bench::argOr(argc, argv, 2, 300);
+    const size_t k = bench::argOr(argc, argv, 3, 10);
+
+    MappedIndex source;
+    if (!source.open(sourcePath) || source.hasImpacts())
+    {
+        std::fprintf(stderr, "Cannot open %s as an index with term frequencies\n", sourcePath.c_str());
+        return 1;
+    }
+
+    // Запросы из 2-5 слов, встречающихся хотя бы в 0.1% документов
+    std::vector<uint32_t> candidates;
+    for (uint32_t termId = 0; termId < source.getTermCount(); ++termId)
+    {
+        if (source.getDocFrequency(termId) * 1000 >= source.getTotalDocs())
+            candidates.push_back(termId);
+    }
+    if (candidates.empty())
+    {
+        std::fprintf(stderr, "Index has no frequent enough terms\n");
+        return 1;
+    }
+
+    std::mt19937 rng(5);
+    std::vector<std::vector<std::string>> queries(queryCount);
+    for (auto &query : queries)
+    {
+        size_t words = 2 + rng() % 4;
+        for (size_t w = 0; w < words; ++w)
+            query.emplace_back(source.getTerm(candidates[rng() % candidates.size()]));
+    }
+
+    // Точный BM25: полная выдача нужна, чтобы оценить документы, не попавшие в точный top-k
+    std::vector<std::unordered_map<uint32_t, double>> exactScores(queries.size());
+    std::vector<std::vector<SearchResult>> exactTop(queries.size());
+    bench::Stopwatch exactTimer;
+    for (size_t q = 0; q < queries.size(); ++q)
+        exactTop[q] = Scorer::search(queries[q], source, nullptr, k);
+    double exactMs = exactTimer.elapsedMs() / queries.size();
+    for (size_t q = 0; q < queries.size(); ++q)
+    {
+        for (const auto &result : Scorer::search(queries[q], source))
+            exactScores[q][result.docId] = result.score;
+    }
+
+    auto dcg = [&](const std::vector<SearchResult> &ranking, const std::unordered_map<uint32_t, double> &gains)
+    {
+        double value = 0;
+        for (size_t i = 0; i < ranking.size(); ++i)
+        {
+            auto gain = gains.find(ranking[i].docId);
+            if (gain != gains.end())
+                value += gain->second / std::log2((double)i + 2);
+        }
+        return value;
+    };
+
+    std::printf("%s: %zu docs, %zu terms; %zu queries of 2-5 words, top-%zu\n\n",
+                synthetic ? "synthetic collection" : sourcePath.c_str(),
+                source.getTotalDocs(), source.getTermCount(), queries.size(), k);
+    std::printf("  bits   index MB   overlap@k   same order   NDCG@k   ms/query\n");
+    std::printf("  exact %9.1f %11.4f %12.4f %8.4f %10.3f\n",
+                std::filesystem::file_size(sourcePath) / 1048576.0, 1.0, 1.0, 1.0, exactMs);
+
+    const std::string impactPath = "impact_divergence.bin";
+    for (uint32_t bits : {4u, 6u, 8u, 10u, 12u, 16u})
+    {
+        if (!ImpactIndex::build(sourcePath, impactPath, bits))
+        {
+            std::fprintf(stderr, "Failed to build %u-bit impacts\n", bits);
+            return 1;
+        }
+
+        MappedIndex impacts;
+        impacts.open(impactPath);
+
+        std::vector<std::vector<SearchResult>> approximate(queries.size());
+        bench::Stopwatch timer;
+        for (size_t q = 0; q < queries.size(); ++q)
+            approximate[q] = BasicScorer<ImpactScoring>::search(queries[q], impacts, nullptr, k);
+        double ms = timer.elapsedMs() / queries.size();
+
+        double overlap = 0, sameOrder = 0, ndcg = 0;
+        for (size_t q = 0; q < queries.size(); ++q)
+        {
+            const auto &exact = exactTop[q];
+            const auto &approx = approximate[q];
+            if (exact.empty())
+            {
+                overlap += 1;
+                sameOrder += 1;
+                ndcg += 1;
+                continue;
+            }
+
+            size_t common = 0;
+            bool same = approx.size() == exact.size();
+            for (size_t i = 0; i < approx.size(); ++i)
+            {
+                same = same && approx[i].docId == exact[i].docId;
+                for (const auto &reference : exact)
+                    common += approx[i].docId == reference.docId;
+            }
+            overlap += (double)common / exact.size();
+            sameOrder += same;
+            ndcg += dcg(approx, exactScores[q]) / dcg(exact, exactScores[q]);
+        }
+
+        std::printf("  %-5u %9.1f %11.4f %12.4f %8.4f %10.3f\n", bits,
+                    std::filesystem::file_size(impactPath) / 1048576.0,
+                    overlap / queries.size(), sameOrder / queries.size(), ndcg / queries.size(), ms);
+
+        impacts.close();
+    }
+
+    InvertedIndex::removeFiles(impactPath);
+    if (synthetic)
+    {
+        InvertedIndex::removeFiles(sourcePath);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Пересечение и объединение отсортированных списков docId: std::set_* против ядер
+// SetOperations на каждом уровне SIMD при соотношениях длин от 1:1 до 1:10000
+// Запуск: ./SetOperationsBench [длина длинного списка] [повторов]
+#include "BenchUtils.hpp"
+#include "utils/SetOperations.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+namespace
+{
+    // size чисел из [0, universe) без повторов, по возрастанию
+    std::vector<uint32_t> randomList(size_t size, uint32_t universe, std::mt19937 &rng)
+    {
+        std::vector<uint32_t> values(size + size / 4 + 16);
+        for (auto &value : values)
+            value = rng() % universe;
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        std::shuffle(values.begin(), values.end(), rng);
+        values.resize(std::min(size, values.size()));
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+
+    template <typename Operation>
+    double bestMs(size_t repeats, Operation operation)
+    {
+        double best = 1e9;
+        for (size_t r = 0; r < repeats; ++r)
+        {
+            bench::Stopwatch timer;
+            operation();
+            best = std::min(best, timer.elapsedMs());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t longSize = bench::argOr(argc, argv, 1, 1000000);
+    const size_t repeats = bench::argOr(argc, argv, 2, 20);
+
+    std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+    if (SetOperations::detectedLevel() >= SimdLevel::Sse41)
+        levels.push_back(SimdLevel::Sse41);
+    if (SetOperations::detectedLevel() >= SimdLevel::Avx2)
+        levels.push_back(SimdLevel::Avx2);
+
+    std::printf("Sorted docId lists, long list %zu, best of %zu runs, detected level: %s\n\n", longSize, repeats,
+                SetOperations::levelName(SetOperations::detectedLevel()));
+    std::printf("  op          ratio     short   result   std ms");
+    for (SimdLevel level : levels)
+        std::printf("  %9s ms", SetOperations::levelName(level));
+    std::printf("\n");
+
+    std::mt19937 rng(20);
+    // Вселенная вчетверо больше длинного списка: совпадает примерно каждое четвертое число
+    const uint32_t universe = static_cast<uint32_t>(longSize * 4);
+    std::vector<uint32_t> longList = randomList(longSize, universe, rng);
+    std::vector<uint32_t> out(2 * longSize + SetOperations::kOutputPadding);
+
+    for (size_t ratio : {1, 10, 100, 1000, 10000})
+    {
+        std::vector<uint32_t> shortList = randomList(std::max<size_t>(1, longSize / ratio), universe, rng);
+        const size_t na = shortList.size(), nb = longList.size();
+
+        // Пересечение
+        size_t expected = 0;
+        double stdMs = bestMs(repeats, [&]
+                              { expected = std::set_intersection(shortList.begin(), shortList.end(), longList.begin(),
+                                                                 longList.end(), out.begin()) - out.begin();
+                                bench::doNotOptimize(out[0]); });
+        std::printf("  intersect   1:%-6zu %7zu %8zu %8.3f", ratio, na, expected, stdMs);
+        for (SimdLevel level : levels)
+        {
+            size_t found = 0;
+            double ms = bestMs(repeats, [&]
+                               { found = SetOperations::intersect(shortList.data(), na, longList.data(), nb, out.data(), level);
+                                 bench::doNotOptimize(out[0]); });
+            std::printf("  %12.3f%s", ms, found == expected ? "" : "!");
+        }
+        std::printf("\n");
+
+        // Объединение
+        stdMs = bestMs(repeats, [&]
+                       { expected = std::set_union(shortList.begin(), shortList.end(), longList.begin(), longList.end(),
+                                                   out.begin()) - out.begin();
+                         bench::doNotOptimize(out[0]); });
+        std::printf("  unite       1:%-6zu %7zu %8zu %8.3f", ratio, na, expected, stdMs);
+        for (SimdLevel level : levels)
+        {
+            size_t found = 0;
+            double ms = bestMs(repeats, [&]
+                               { found = SetOperations::unite(shortList.data(), na, longList.data(), nb, out.data(), level);
+                                 bench::doNotOptimize(out[0]); });
+            std::printf("  %12.3f%s", ms, found == expected ? "" : "!");
+        }
+        std::printf("\n");
+    }
+    std::printf("\n  ! - result size differs from std\n");
+
+    return 0;
+}
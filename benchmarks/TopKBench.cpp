@@ -0,0 +1,57 @@
+// Время поиска в зависимости от числа найденных документов: полная сортировка против top-k
+// Запуск: ./TopKBench [документов] [повторов]
+#include "BenchUtils.hpp"
+#include "core/InvertedIndex.hpp"
+#include "ranking/Scorer.hpp"
+#include <cstdio>
+
+int main(int argc, char *argv[])
+{
+    const size_t docCount = bench::argOr(argc, argv, 1, 1000000);
+    const size_t repeats = bench::argOr(argc, argv, 2, 20);
+
+    // Слово "df<p>" встречается в каждом p-м документе: от 100% до 0.01% коллекции
+    const std::vector<uint32_t> periods = {1, 3, 10, 100, 1000, 10000};
+    std::mt19937 rng(3);
+    InvertedIndex index;
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        for (uint32_t period : periods)
+        {
+            if (doc % period == 0)
+            {
+                uint32_t tf = 1 + rng() % 8;
+                for (uint32_t k = 0; k < tf; ++k)
+                    index.addTerm("df" + std::to_string(period), doc);
+            }
+        }
+        index.incrementDocCount();
+    }
+    index.finishDocumentStats();
+
+    std::printf("Scorer::search, %zu docs, %zu repeats per query\n\n", docCount, repeats);
+    std::printf("  matches      full sort ms   top-10 ms   top-100 ms\n");
+    for (uint32_t period : periods)
+    {
+        std::vector<std::string> query = {"df" + std::to_string(period)};
+
+        double timings[3];
+        const size_t ks[3] = {Scorer::kAllResults, 10, 100};
+        size_t matches = 0;
+        for (int variant = 0; variant < 3; ++variant)
+        {
+            bench::Stopwatch timer;
+            for (size_t r = 0; r < repeats; ++r)
+            {
+                auto results = Scorer::search(query, index, nullptr, ks[variant]);
+                if (variant == 0)
+                    matches = results.size();
+                bench::doNotOptimize(results.data());
+            }
+            timings[variant] = timer.elapsedMs() / repeats;
+        }
+        std::printf("  %8zu %15.2f %11.2f %12.2f\n", matches, timings[0], timings[1], timings[2]);
+    }
+
+    return 0;
+}
@@ -2,112 +2,105 @@
 #define BOOLEAN_INDEX_HPP
 
 #include "HashMap.hpp"
+#include "DocIdIterator.hpp"
+#include "DocIdSet.hpp"
+#include "BooleanQuery.hpp"
 #include <vector>
 #include <string>
-#include <fstream>
-#include <iostream>
+#include <string_view>
 #include <algorithm>
 
+// Булев индекс в памяти: для каждого слова DocIdSet (контейнеры Roaring: массив,
+// битмап или отрезки). Поиск в продукте идет по постингам index.bin; этот индекс -
+// эталон поконтейнерной алгебры для тестов и BooleanQueryBench
 class BooleanIndex
 {
 private:
-    // Для каждого термина храним просто список ID документов (без TF и сжатия)
-    HashMap<std::string, std::vector<uint32_t>> index;
+    // Для каждого термина - множество ID документов (без TF)
+    HashMap<std::string, DocIdSet> index;
     size_t totalDocs = 0;
 
 public:
-    void addTerm(const std::string &term, uint32_t docId)
+    void addTerm(std::string_view term, uint32_t docId)
     {
-        std::vector<uint32_t> *list = index.get(term);
-        if (list == nullptr)
-        {
-            std::vector<uint32_t> newList;
-            newList.push_back(docId);
-            index.insert(term, newList);
-        }
-        else
-        {
-            // Избегаем дубликатов
-            if (list->empty() || list->back() != docId)
-            {
-                list->push_back(docId);
-            }
-        }
+        index.getOrInsert(term).add(docId);
     }
 
-    std::vector<uint32_t> *getDocIds(const std::string &term)
+    const DocIdSet *getDocIds(std::string_view term)
     {
         return index.get(term);
     }
 
-    void setTotalDocs(size_t docs) { totalDocs = docs; }
-    size_t getTotalDocs() const { return totalDocs; }
-
-    bool save(const std::string &filename)
+    size_t documentFrequency(std::string_view term) const
     {
-        std::ofstream out(filename, std::ios::binary);
-        if (!out.is_open())
-            return false;
-
-        out.write(reinterpret_cast<const char *>(&totalDocs), sizeof(totalDocs));
-
-        size_t termCount = index.size();
-        out.write(reinterpret_cast<const char *>(&termCount), sizeof(termCount));
-
-        index.traverse([&](const std::string &term, const std::vector<uint32_t> &docIds)
-                       {
-            // 1. Пишем слово
-            size_t termLen = term.size();
-            out.write(reinterpret_cast<const char*>(&termLen), sizeof(termLen));
-            out.write(term.c_str(), termLen);
-
-            // 2. Пишем количество документов и сами ID документов
-            size_t docCount = docIds.size();
-            out.write(reinterpret_cast<const char*>(&docCount), sizeof(docCount));
-            for (const auto &docId : docIds)
-            {
-                out.write(reinterpret_cast<const char*>(&docId), sizeof(docId));
-            } });
-
-        out.close();
-        return true;
+        const DocIdSet *docIds = index.get(term);
+        return docIds ? docIds->size() : 0;
     }
 
-    bool load(const std::string &filename)
+    // Итератор по документам термина прямо поверх контейнеров (пустой, если термина нет)
+    DocIdIteratorPtr openIterator(std::string_view term) const
     {
-        std::ifstream in(filename, std::ios::binary);
-        if (!in.is_open())
-            return false;
-
-        index.clear();
-        in.read(reinterpret_cast<char *>(&totalDocs), sizeof(totalDocs));
+        const DocIdSet *docIds = index.get(term);
+        if (docIds == nullptr)
+            return std::make_unique<DocListIterator>(nullptr, 0);
+        return std::make_unique<DocIdSetIterator>(*docIds);
+    }
 
-        size_t termCount = 0;
-        in.read(reinterpret_cast<char *>(&termCount), sizeof(termCount));
+    // Лист булевой алгебры: множество термина без копирования (пустое, если термина нет)
+    DocIdSetExpr openSet(std::string_view term) const
+    {
+        const DocIdSet *docIds = index.get(term);
+        return docIds ? DocIdSetExpr::reference(*docIds) : DocIdSetExpr::owning(DocIdSet());
+    }
 
-        for (size_t i = 0; i < termCount; ++i)
+    // План BooleanPlanner поконтейнерной алгеброй: операнды AND в порядке плана,
+    // пересечение останавливается, как только стало пустым; вычитаемые - после всех
+    DocIdSetExpr evaluate(const BooleanNode &plan) const
+    {
+        switch (plan.kind)
         {
-            // 1. Читаем слово
-            size_t termLen = 0;
-            in.read(reinterpret_cast<char *>(&termLen), sizeof(termLen));
-            std::string term(termLen, '\0');
-            in.read(&term[0], termLen);
-
-            // 2. Читаем документы
-            size_t docCount = 0;
-            in.read(reinterpret_cast<char *>(&docCount), sizeof(docCount));
-            std::vector<uint32_t> docIds(docCount);
-            for (size_t j = 0; j < docCount; ++j)
-            {
-                in.read(reinterpret_cast<char *>(&docIds[j]), sizeof(docIds[j]));
-            }
-
-            index.insert(term, docIds);
+        case BooleanNode::Kind::Term:
+            return openSet(plan.term);
+        case BooleanNode::Kind::Not:
+            return DocIdSetExpr::negation(evaluate(plan.children[0]));
+        case BooleanNode::Kind::And:
+        {
+            DocIdSetExpr result = evaluate(plan.children[0]);
+            auto exhausted = [&]
+            { return !result.complement && result.set->empty(); };
+            for (size_t i = 1; i < plan.children.size() && !exhausted(); ++i)
+                result = DocIdSetExpr::conjunction(result, evaluate(plan.children[i]));
+            for (size_t i = 0; i < plan.excluded.size() && !exhausted(); ++i)
+                result = DocIdSetExpr::conjunction(result, DocIdSetExpr::negation(evaluate(plan.excluded[i])));
+            return result;
         }
+        case BooleanNode::Kind::Or:
+        {
+            DocIdSetExpr result = evaluate(plan.children[0]);
+            for (size_t i = 1; i < plan.children.size(); ++i)
+                result = DocIdSetExpr::disjunction(result, evaluate(plan.children[i]));
+            return result;
+        }
+        default:
+            return DocIdSetExpr::owning(DocIdSet());
+        }
+    }
 
-        in.close();
-        return true;
+    // Тот же план ленивым деревом итераторов
+    DocIdIteratorPtr openIterator(const BooleanNode &plan) const
+    {
+        return openBooleanIterator(plan, *this);
+    }
+
+    // Каждый блок каждого термина - в самый компактный контейнер
+    void runOptimize()
+    {
+        index.traverse([](const std::string &, DocIdSet &docIds)
+                       { docIds.runOptimize(); });
     }
+
+    void setTotalDocs(size_t docs) { totalDocs = docs; }
+    size_t getTotalDocs() const { return totalDocs; }
 };
 
 #endif
@@ -0,0 +1,426 @@
+#ifndef BOOLEAN_QUERY_HPP
+#define BOOLEAN_QUERY_HPP
+
+#include "DocIdIterator.hpp"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+// Узел булева запроса. Разбор строит дерево как записано (And/Or бинарные, Not где
+// угодно), BooleanPlanner::plan переписывает его в план для выполнения
+struct BooleanNode
+{
+    enum class Kind
+    {
+        Term,
+        And,   // Пересечение children минус каждый из excluded (ANDNOT)
+        Or,
+        Not,   // Дополнение единственного children[0] до всех документов
+        Empty, // Заведомо пустой результат (например, слова нет в индексе)
+    };
+
+    Kind kind = Kind::Empty;
+    std::string term; // Term; у Empty - слово, из которого он получился (для explain)
+    std::vector<BooleanNode> children;
+    std::vector<BooleanNode> excluded;
+
+    // Заполняются планировщиком
+    size_t estimate = 0; // Оценка числа документов результата
+    double cost = 0;     // Оценка числа docId, которые придется прочитать
+
+    static BooleanNode makeTerm(std::string word)
+    {
+        BooleanNode node;
+        node.kind = Kind::Term;
+        node.term = std::move(word);
+        return node;
+    }
+
+    static BooleanNode makeNot(BooleanNode operand)
+    {
+        BooleanNode node;
+        node.kind = Kind::Not;
+        node.children.push_back(std::move(operand));
+        return node;
+    }
+
+    static BooleanNode makeAnd(BooleanNode a, BooleanNode b) { return combine(Kind::And, std::move(a), std::move(b)); }
+    static BooleanNode makeOr(BooleanNode a, BooleanNode b) { return combine(Kind::Or, std::move(a), std::move(b)); }
+
+    // Каноническая запись: операнды AND/OR упорядочены, так что a & b и b & a совпадают
+    std::string key() const
+    {
+        switch (kind)
+        {
+        case Kind::Term:
+            return term;
+        case Kind::Empty:
+            return "{}";
+        case Kind::Not:
+            return "!" + children[0].key();
+        default:
+        {
+            std::vector<std::string> keys;
+            for (const auto &child : children)
+                keys.push_back(child.key());
+            for (const auto &child : excluded)
+                keys.push_back("!" + child.key());
+            std::sort(keys.begin(), keys.end());
+            std::string out = kind == Kind::And ? "&(" : "|(";
+            for (size_t i = 0; i < keys.size(); ++i)
+                out += (i ? " " : "") + keys[i];
+            return out + ")";
+        }
+        }
+    }
+
+private:
+    static BooleanNode combine(Kind kind, BooleanNode a, BooleanNode b)
+    {
+        BooleanNode node;
+        node.kind = kind;
+        node.children.push_back(std::move(a));
+        node.children.push_back(std::move(b));
+        return node;
+    }
+};
+
+// Планировщик булевых запросов. Переписывания:
+//   - NOT опускается к словам по де Моргану, двойное отрицание снимается;
+//   - вложенные AND и OR сливаются в n-арные, повторы операндов убираются;
+//   - отрицания внутри AND становятся вычитаемыми (ANDNOT), AND из одних отрицаний -
+//     NOT(OR), OR с отрицаниями - NOT(ANDNOT): полное дополнение не строится нигде;
+//   - слово, которого нет в индексе, - Empty: x & Empty = Empty, x | Empty = x;
+//   - операнды AND идут по возрастанию df, первым самый редкий, OR - тоже.
+// Index: documentFrequency(term) и getTotalDocs().
+// Стоимость AND: ведущий читается целиком, каждый следующий операнд - не больше
+// своей длины и не больше running * log2(2 + size / running) (галоп по длинному),
+// где running - оценка текущего пересечения.
+class BooleanPlanner
+{
+private:
+    using Kind = BooleanNode::Kind;
+
+    // Отрицание к листьям (negate - нужно ли отрицать node)
+    static BooleanNode pushNot(BooleanNode node, bool negate)
+    {
+        if (node.kind == Kind::Not)
+            return pushNot(std::move(node.children[0]), !negate);
+        if (node.kind == Kind::Term || node.kind == Kind::Empty)
+            return negate ? BooleanNode::makeNot(std::move(node)) : std::move(node);
+
+        if (negate)
+            node.kind = node.kind == Kind::And ? Kind::Or : Kind::And;
+        for (auto &child : node.children)
+            child = pushNot(std::move(child), negate);
+        return node;
+    }
+
+    static bool isEverything(const BooleanNode &node)
+    {
+        return node.kind == Kind::Not && node.children[0].kind == Kind::Empty;
+    }
+
+    static BooleanNode everything(size_t totalDocs)
+    {
+        BooleanNode node = BooleanNode::makeNot(BooleanNode());
+        node.estimate = totalDocs;
+        return node;
+    }
+
+    // Повторы по канонической записи
+    static void dedupe(std::vector<BooleanNode> &nodes)
+    {
+        std::vector<std::string> seen;
+        size_t kept = 0;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            std::string key = nodes[i].key();
+            if (std::find(seen.begin(), seen.end(), key) != seen.end())
+                continue;
+            seen.push_back(std::move(key));
+            if (kept != i)
+                nodes[kept] = std::move(nodes[i]);
+            ++kept;
+        }
+        nodes.resize(kept);
+    }
+
+    static void sortByEstimate(std::vector<BooleanNode> &nodes)
+    {
+        std::stable_sort(nodes.begin(), nodes.end(), [](const BooleanNode &a, const BooleanNode &b)
+                         { return a.estimate < b.estimate; });
+    }
+
+    template <typename Index>
+    static BooleanNode simplifyAnd(BooleanNode node, const Index &index)
+    {
+        // Слияние вложенных AND и разбор отрицаний в вычитаемые
+        std::vector<BooleanNode> positive, negative;
+        for (auto &child : node.children)
+        {
+            BooleanNode simple = simplify(std::move(child), index);
+            if (simple.kind == Kind::And)
+            {
+                std::move(simple.children.begin(), simple.children.end(), std::back_inserter(positive));
+                std::move(simple.excluded.begin(), simple.excluded.end(), std::back_inserter(negative));
+            }
+            else if (simple.kind == Kind::Not)
+                negative.push_back(std::move(simple.children[0]));
+            else
+                positive.push_back(std::move(simple));
+        }
+        for (auto &child : node.excluded)
+            negative.push_back(simplify(std::move(child), index));
+
+        // x & Empty = Empty, x ANDNOT Empty = x
+        for (const auto &child : positive)
+        {
+            if (child.kind == Kind::Empty)
+                return child;
+        }
+        negative.erase(std::remove_if(negative.begin(), negative.end(), [](const BooleanNode &child)
+                                      { return child.kind == Kind::Empty; }),
+                       negative.end());
+        dedupe(positive);
+        dedupe(negative);
+
+        // x & !x = Empty
+        for (const auto &child : negative)
+        {
+            std::string key = child.key();
+            for (const auto &other : positive)
+            {
+                if (other.key() == key)
+                    return BooleanNode();
+            }
+        }
+
+        // Одни отрицания: !a & !b = !(a | b)
+        if (positive.empty())
+        {
+            BooleanNode either;
+            either.kind = Kind::Or;
+            either.children = std::move(negative);
+            return simplify(BooleanNode::makeNot(std::move(either)), index);
+        }
+        if (positive.size() == 1 && negative.empty())
+            return std::move(positive[0]);
+
+        sortByEstimate(positive);
+        sortByEstimate(negative);
+        node.children = std::move(positive);
+        node.excluded = std::move(negative);
+
+        size_t running = node.children[0].estimate;
+        node.cost = node.children[0].cost;
+        auto step = [&](const BooleanNode &child)
+        {
+            double probes = running * std::log2(2.0 + (double)child.estimate / std::max<size_t>(running, 1));
+            node.cost += std::min(child.cost, probes);
+        };
+        for (size_t i = 1; i < node.children.size(); ++i)
+        {
+            step(node.children[i]);
+            running = std::min(running, node.children[i].estimate);
+        }
+        for (const auto &child : node.excluded)
+            step(child);
+        node.estimate = running;
+        return node;
+    }
+
+    template <typename Index>
+    static BooleanNode simplifyOr(BooleanNode node, const Index &index)
+    {
+        std::vector<BooleanNode> positive, negative;
+        for (auto &child : node.children)
+        {
+            BooleanNode simple = simplify(std::move(child), index);
+            if (isEverything(simple))
+                return everything(index.getTotalDocs());
+            if (simple.kind == Kind::Or)
+                std::move(simple.children.begin(), simple.children.end(), std::back_inserter(positive));
+            else if (simple.kind == Kind::Not)
+                negative.push_back(std::move(simple.children[0]));
+            else if (simple.kind != Kind::Empty)
+                positive.push_back(std::move(simple));
+        }
+
+        // a | !b = !(b ANDNOT a): дополнение остается флагом над вычитанием
+        if (!negative.empty())
+        {
+            BooleanNode both;
+            both.kind = Kind::And;
+            both.children = std::move(negative);
+            both.excluded = std::move(positive);
+            return simplify(BooleanNode::makeNot(std::move(both)), index);
+        }
+
+        dedupe(positive);
+        if (positive.empty())
+            return BooleanNode();
+        if (positive.size() == 1)
+            return std::move(positive[0]);
+
+        sortByEstimate(positive);
+        node.children = std::move(positive);
+        node.estimate = 0;
+        node.cost = 0;
+        for (const auto &child : node.children)
+        {
+            node.estimate += child.estimate;
+            node.cost += child.cost;
+        }
+        node.estimate = std::min<size_t>(node.estimate, index.getTotalDocs());
+        return node;
+    }
+
+    template <typename Index>
+    static BooleanNode simplify(BooleanNode node, const Index &index)
+    {
+        switch (node.kind)
+        {
+        case Kind::Term:
+        {
+            size_t df = index.documentFrequency(node.term);
+            if (df == 0)
+            {
+                node.kind = Kind::Empty;
+                return node;
+            }
+            node.estimate = df;
+            node.cost = (double)df;
+            return node;
+        }
+        case Kind::Not:
+        {
+            BooleanNode child = simplify(std::move(node.children[0]), index);
+            if (child.kind == Kind::Not)
+                return std::move(child.children[0]);
+            node.children[0] = std::move(child);
+            node.estimate = index.getTotalDocs() - std::min<size_t>(index.getTotalDocs(), node.children[0].estimate);
+            node.cost = node.children[0].cost;
+            return node;
+        }
+        case Kind::And:
+            return simplifyAnd(std::move(node), index);
+        case Kind::Or:
+            return simplifyOr(std::move(node), index);
+        default:
+            return node;
+        }
+    }
+
+    static void explainNode(const BooleanNode &node, size_t depth, std::string &out)
+    {
+        out.append(2 * depth + 2, ' ');
+        switch (node.kind)
+        {
+        case Kind::Term:
+            out += "TERM " + node.term;
+            break;
+        case Kind::Empty:
+            out += node.term.empty() ? "EMPTY" : "EMPTY (" + node.term + " not in index)";
+            break;
+        case Kind::Not:
+            out += isEverything(node) ? "ALL" : "NOT (complement flag)";
+            break;
+        case Kind::And:
+            out += node.excluded.empty() ? "AND" : "AND-NOT";
+            break;
+        case Kind::Or:
+            out += "OR";
+            break;
+        }
+        out += "  ~" + std::to_string(node.estimate) + " docs, cost " + std::to_string((size_t)std::llround(node.cost)) + "\n";
+
+        if (isEverything(node))
+            return;
+        for (const auto &child : node.children)
+            explainNode(child, depth + 1, out);
+        for (const auto &child : node.excluded)
+        {
+            out.append(2 * depth + 4, ' ');
+            out += "minus\n";
+            explainNode(child, depth + 2, out);
+        }
+    }
+
+    // negated - под нечетным числом отрицаний (NOT и вычитаемые AND)
+    static void collectRankingTerms(const BooleanNode &node, bool negated, std::vector<std::string> &terms)
+    {
+        if (node.kind == Kind::Term)
+        {
+            if (!negated && std::find(terms.begin(), terms.end(), node.term) == terms.end())
+                terms.push_back(node.term);
+            return;
+        }
+        bool childNegated = node.kind == Kind::Not ? !negated : negated;
+        for (const auto &child : node.children)
+            collectRankingTerms(child, childNegated, terms);
+        for (const auto &child : node.excluded)
+            collectRankingTerms(child, !negated, terms);
+    }
+
+public:
+    template <typename Index>
+    static BooleanNode plan(BooleanNode root, const Index &index)
+    {
+        return simplify(pushNot(std::move(root), false), index);
+    }
+
+    // План деревом: вид узла, оценка числа документов и стоимость
+    static std::string explain(const BooleanNode &plan)
+    {
+        std::string out = "Plan (estimated cost " + std::to_string((size_t)std::llround(plan.cost)) + " postings):\n";
+        explainNode(plan, 0, out);
+        return out;
+    }
+
+    // Слова запроса без отрицания, каждое один раз: по ним ранжируются документы,
+    // прошедшие булев фильтр. Берутся из разобранного дерева до plan: в плане слово
+    // без отрицания может оказаться под NOT ("a | !b" = !(b ANDNOT a)), а слово,
+    // которого нет в индексе, - стать Empty
+    static std::vector<std::string> rankingTerms(const BooleanNode &query)
+    {
+        std::vector<std::string> terms;
+        collectRankingTerms(query, false, terms);
+        return terms;
+    }
+};
+
+// План как ленивое дерево итераторов над любым индексом с openIterator(term) и
+// getTotalDocs(): вычитаемые AND - отрицания внутри пересечения
+template <typename Index>
+DocIdIteratorPtr openBooleanIterator(const BooleanNode &plan, const Index &index)
+{
+    switch (plan.kind)
+    {
+    case BooleanNode::Kind::Term:
+        return index.openIterator(plan.term);
+    case BooleanNode::Kind::Not:
+        return std::make_unique<NotIterator>(openBooleanIterator(plan.children[0], index), index.getTotalDocs());
+    case BooleanNode::Kind::And:
+    case BooleanNode::Kind::Or:
+    {
+        std::vector<DocIdIteratorPtr> operands;
+        for (const auto &child : plan.children)
+            operands.push_back(openBooleanIterator(child, index));
+        if (plan.kind == BooleanNode::Kind::Or)
+            return std::make_unique<OrIterator>(std::move(operands));
+        for (const auto &child : plan.excluded)
+            operands.push_back(std::make_unique<NotIterator>(openBooleanIterator(child, index), index.getTotalDocs()));
+        return std::make_unique<AndIterator>(std::move(operands));
+    }
+    default:
+        return std::make_unique<DocListIterator>(nullptr, 0);
+    }
+}
+
+#endif
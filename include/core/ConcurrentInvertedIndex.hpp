@@ -0,0 +1,150 @@
+#ifndef CONCURRENT_INVERTED_INDEX_HPP
+#define CONCURRENT_INVERTED_INDEX_HPP
+
+#include "InvertedIndex.hpp"
+#include "TermDictionary.hpp"
+#include <vector>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+
+// Индекс для построения из нескольких потоков.
+// Словарь разбит на шарды по хешу термина, у каждого шарда свой мьютекс,
+// поэтому потоки, добавляющие разные документы, почти не мешают друг другу.
+// Документы приходят в произвольном порядке, так что списки упорядочиваются
+// по docId только в finalize().
+class ConcurrentInvertedIndex
+{
+private:
+    struct Shard
+    {
+        std::mutex mutex;
+        TermDictionary dictionary;
+        std::vector<PostingsList> postings; // по локальному termId шарда
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardMask;
+    std::atomic<size_t> totalDocs{0};
+
+    size_t shardOf(std::string_view term) const
+    {
+        // Старшие биты перемешанного хеша - младшие использует сама хеш-таблица шарда
+        uint64_t h = static_cast<uint64_t>(std::hash<std::string_view>{}(term)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h >> 40) & shardMask;
+    }
+
+public:
+    // shardCount округляется вверх до степени двойки
+    explicit ConcurrentInvertedIndex(size_t shardCount = 64)
+    {
+        size_t count = 1;
+        while (count < shardCount)
+            count *= 2;
+
+        shardMask = count - 1;
+        shards.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            shards.push_back(std::make_unique<Shard>());
+    }
+
+    // Добавляет все слова одного документа (потокобезопасно).
+    // Один документ должен добавляться целиком и ровно один раз:
+    // TF считается здесь же, и каждый шард блокируется один раз на документ.
+    void addDocument(uint32_t docId, const std::vector<std::string_view> &terms)
+    {
+        if (terms.empty())
+            return;
+
+        // Группируем слова по шарду, одинаковые слова оказываются рядом
+        std::vector<std::pair<size_t, std::string_view>> grouped;
+        grouped.reserve(terms.size());
+        for (std::string_view term : terms)
+            grouped.emplace_back(shardOf(term), term);
+        std::sort(grouped.begin(), grouped.end());
+
+        size_t i = 0;
+        while (i < grouped.size())
+        {
+            Shard &shard = *shards[grouped[i].first];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            const size_t shardId = grouped[i].first;
+            while (i < grouped.size() && grouped[i].first == shardId)
+            {
+                std::string_view term = grouped[i].second;
+                uint32_t tf = 0;
+                while (i < grouped.size() && grouped[i].first == shardId && grouped[i].second == term)
+                {
+                    tf++;
+                    i++;
+                }
+
+                uint32_t termId = shard.dictionary.getOrAdd(term);
+                if (termId == shard.postings.size())
+                    shard.postings.emplace_back();
+                shard.postings[termId].emplace_back(docId, tf);
+            }
+        }
+    }
+
+    void incrementDocCount() { totalDocs.fetch_add(1, std::memory_order_relaxed); }
+    size_t getTotalDocs() const { return totalDocs.load(std::memory_order_relaxed); }
+
+    size_t getTermCount() const
+    {
+        size_t count = 0;
+        for (const auto &shard : shards)
+            count += shard->postings.size();
+        return count;
+    }
+
+    // Собирает обычный InvertedIndex (вызывать после завершения всех потоков).
+    // Результат детерминирован: списки отсортированы по docId, а termId выдаются
+    // в лексикографическом порядке терминов, независимо от порядка работы потоков.
+    InvertedIndex finalize()
+    {
+        struct TermRef
+        {
+            std::string_view term;
+            uint32_t shard;
+            uint32_t localId;
+        };
+
+        std::vector<TermRef> refs;
+        refs.reserve(getTermCount());
+        for (uint32_t s = 0; s < shards.size(); ++s)
+        {
+            for (uint32_t localId = 0; localId < shards[s]->postings.size(); ++localId)
+                refs.push_back({shards[s]->dictionary.term(localId), s, localId});
+        }
+        std::sort(refs.begin(), refs.end(), [](const TermRef &a, const TermRef &b)
+                  { return a.term < b.term; });
+
+        InvertedIndex index;
+        index.reserveTerms(refs.size());
+        for (const auto &ref : refs)
+        {
+            PostingsList &list = shards[ref.shard]->postings[ref.localId];
+            std::sort(list.begin(), list.end(), [](const Posting &a, const Posting &b)
+                      { return a.docId < b.docId; });
+
+            index.getPostingsById(index.internTerm(ref.term)) = std::move(list);
+        }
+        index.setTotalDocs(getTotalDocs());
+        index.rebuildDocumentStats();
+
+        for (auto &shard : shards)
+        {
+            shard->dictionary.clear();
+            shard->postings.clear();
+        }
+        totalDocs = 0;
+        return index;
+    }
+};
+
+#endif
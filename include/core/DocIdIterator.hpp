@@ -0,0 +1,426 @@
+#ifndef DOC_ID_ITERATOR_HPP
+#define DOC_ID_ITERATOR_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include "PostingCursor.hpp"
+#include "../utils/SetOperations.hpp"
+
+// Дерево булева запроса: каждый узел - поток docId по возрастанию. Листья читают
+// постинги термина на месте, узлы AND/OR/NOT сливают потоки детей по одному
+// документу, не копируя списков и не создавая промежуточных результатов: память
+// на запрос зависит от размера дерева, а не от длины постингов.
+//
+//   for (auto it = parser.compileBoolean(query, index); !it->atEnd(); it->next())
+//       use(it->docId());
+//
+// Для выдачи целиком есть drain: узлы обрабатывают списки детей пакетно
+// (SetOperations), а не по одному документу через виртуальные next/advance.
+class DocIdIterator
+{
+public:
+    // docId исчерпанного итератора: больше любого настоящего номера документа
+    static constexpr uint32_t kEndDoc = UINT32_MAX;
+
+protected:
+    uint32_t current = kEndDoc;
+
+public:
+    virtual ~DocIdIterator() = default;
+
+    bool atEnd() const { return current == kEndDoc; }
+    uint32_t docId() const { return current; }
+
+    virtual void next() = 0;
+
+    // Первый документ >= target; назад не ходит
+    virtual void advance(uint32_t target) = 0;
+
+    // Оценка числа документов потока - по ней AND ставит вперед самый короткий
+    virtual size_t cost() const = 0;
+
+    // Дописывает в out все оставшиеся документы (начиная с текущего) и исчерпывает итератор
+    virtual void drain(std::vector<uint32_t> &out)
+    {
+        for (; !atEnd(); next())
+            out.push_back(current);
+    }
+
+    // Число оставшихся документов (начиная с текущего); исчерпывает итератор, не храня их
+    virtual size_t countRemaining()
+    {
+        size_t total = 0;
+        for (; !atEnd(); next())
+            total++;
+        return total;
+    }
+};
+
+using DocIdIteratorPtr = std::unique_ptr<DocIdIterator>;
+
+// Лист: отсортированный массив docId без копирования. Данные должны жить дольше итератора
+class DocListIterator : public DocIdIterator
+{
+private:
+    const uint32_t *docs;
+    size_t count;
+    size_t position = 0;
+
+public:
+    DocListIterator(const uint32_t *docIds, size_t docCount) : docs(docIds), count(docCount)
+    {
+        current = count ? docs[0] : kEndDoc;
+    }
+
+    void next() override
+    {
+        current = ++position < count ? docs[position] : kEndDoc;
+    }
+
+    void advance(uint32_t target) override
+    {
+        if (target <= current)
+            return;
+
+        // Галоп от текущей позиции, затем бинарный поиск в найденном окне
+        size_t low = position + 1;
+        size_t step = 1;
+        while (low + step < count && docs[low + step] < target)
+        {
+            low += step;
+            step *= 2;
+        }
+        size_t high = std::min(count, low + step + 1);
+        position = std::lower_bound(docs + low, docs + high, target) - docs;
+        current = position < count ? docs[position] : kEndDoc;
+    }
+
+    size_t cost() const override { return count; }
+
+    // Непрочитанная часть списка, начиная с текущего документа
+    const uint32_t *remainingData() const { return docs + position; }
+    size_t remainingCount() const { return position < count ? count - position : 0; }
+
+    void drain(std::vector<uint32_t> &out) override
+    {
+        out.insert(out.end(), remainingData(), remainingData() + remainingCount());
+        position = count;
+        current = kEndDoc;
+    }
+
+    size_t countRemaining() override
+    {
+        size_t total = remainingCount();
+        position = count;
+        current = kEndDoc;
+        return total;
+    }
+};
+
+// Лист: постинги термина через PostingCursor (список в памяти или сжатые блоки
+// index.bin), TF не распаковываются. advance перескакивает блоки по таблице пропусков
+class PostingIterator : public DocIdIterator
+{
+private:
+    static_assert(PostingCursor::kEndDoc == kEndDoc, "end markers must match");
+
+    PostingCursor cursor;
+
+public:
+    explicit PostingIterator(PostingCursor postings) : cursor(std::move(postings))
+    {
+        cursor.ignoreTermFrequencies();
+        current = cursor.docId();
+    }
+
+    void next() override
+    {
+        cursor.next();
+        current = cursor.docId();
+    }
+
+    void advance(uint32_t target) override
+    {
+        if (target <= current)
+            return;
+        cursor.advance(target);
+        current = cursor.docId();
+    }
+
+    size_t cost() const override { return cursor.size(); }
+};
+
+// Пересечение: ведущий - самый короткий поток, остальные догоняют его через advance
+class AndIterator : public DocIdIterator
+{
+private:
+    std::vector<DocIdIteratorPtr> children;
+
+    // Первый общий документ всех детей, не меньше target
+    void converge(uint32_t target)
+    {
+        uint32_t candidate = target;
+        while (true)
+        {
+            children[0]->advance(candidate);
+            candidate = children[0]->docId();
+            if (candidate == kEndDoc)
+            {
+                current = kEndDoc;
+                return;
+            }
+
+            bool agreed = true;
+            for (size_t i = 1; i < children.size(); ++i)
+            {
+                children[i]->advance(candidate);
+                if (children[i]->docId() != candidate)
+                {
+                    candidate = children[i]->docId(); // kEndDoc тоже закончит цикл на ведущем
+                    agreed = false;
+                    break;
+                }
+            }
+            if (agreed)
+            {
+                current = candidate;
+                return;
+            }
+        }
+    }
+
+public:
+    // Вложенные AND раскрываются: все операнды цепочки a & b & c упорядочены вместе
+    explicit AndIterator(std::vector<DocIdIteratorPtr> operands)
+    {
+        for (auto &operand : operands)
+        {
+            if (auto *nested = dynamic_cast<AndIterator *>(operand.get()))
+                std::move(nested->children.begin(), nested->children.end(), std::back_inserter(children));
+            else
+                children.push_back(std::move(operand));
+        }
+        if (children.empty())
+            return;
+
+        std::stable_sort(children.begin(), children.end(), [](const DocIdIteratorPtr &a, const DocIdIteratorPtr &b)
+                         { return a->cost() < b->cost(); });
+        converge(0);
+    }
+
+    void next() override
+    {
+        if (!atEnd())
+            converge(current + 1);
+    }
+
+    void advance(uint32_t target) override
+    {
+        if (target > current)
+            converge(target);
+    }
+
+    size_t cost() const override { return children.empty() ? 0 : children[0]->cost(); }
+
+    // Ведущий выдается целиком, затем пересекается с остальными ядрами SetOperations.
+    // Узел длиннее кандидатов в kDrainRatio раз и больше (например, NOT) выдавать
+    // целиком дороже - он проверяет каждого кандидата через advance
+    static constexpr size_t kDrainRatio = 4;
+
+    void drain(std::vector<uint32_t> &out) override
+    {
+        if (atEnd())
+            return;
+        std::vector<uint32_t> candidates, buffer, childDocs;
+        children[0]->drain(candidates);
+        for (size_t i = 1; i < children.size() && !candidates.empty(); ++i)
+        {
+            auto *leaf = dynamic_cast<DocListIterator *>(children[i].get());
+            if (leaf == nullptr && children[i]->cost() / candidates.size() >= kDrainRatio)
+            {
+                size_t kept = 0;
+                for (uint32_t doc : candidates)
+                {
+                    children[i]->advance(doc);
+                    if (children[i]->docId() == doc)
+                        candidates[kept++] = doc;
+                }
+                candidates.resize(kept);
+                continue;
+            }
+
+            const uint32_t *docs = nullptr;
+            size_t docCount = 0;
+            if (leaf != nullptr)
+            {
+                docs = leaf->remainingData();
+                docCount = leaf->remainingCount();
+            }
+            else
+            {
+                childDocs.clear();
+                children[i]->drain(childDocs);
+                docs = childDocs.data();
+                docCount = childDocs.size();
+            }
+            buffer.resize(candidates.size() + SetOperations::kOutputPadding);
+            buffer.resize(SetOperations::intersect(candidates.data(), candidates.size(), docs, docCount, buffer.data()));
+            candidates.swap(buffer);
+        }
+        out.insert(out.end(), candidates.begin(), candidates.end());
+        current = kEndDoc;
+    }
+};
+
+// Объединение: текущий документ - наименьший среди детей
+class OrIterator : public DocIdIterator
+{
+private:
+    std::vector<DocIdIteratorPtr> children;
+
+    void updateCurrent()
+    {
+        current = kEndDoc;
+        for (const auto &child : children)
+            current = std::min(current, child->docId());
+    }
+
+public:
+    explicit OrIterator(std::vector<DocIdIteratorPtr> operands) : children(std::move(operands))
+    {
+        updateCurrent();
+    }
+
+    void next() override
+    {
+        if (atEnd())
+            return;
+        for (auto &child : children)
+        {
+            if (child->docId() == current)
+                child->next();
+        }
+        updateCurrent();
+    }
+
+    void advance(uint32_t target) override
+    {
+        if (target <= current)
+            return;
+        for (auto &child : children)
+            child->advance(target);
+        updateCurrent();
+    }
+
+    size_t cost() const override
+    {
+        size_t total = 0;
+        for (const auto &child : children)
+            total += child->cost();
+        return total;
+    }
+
+    // Дети выдаются целиком и сливаются попарно
+    void drain(std::vector<uint32_t> &out) override
+    {
+        if (atEnd())
+            return;
+        std::vector<uint32_t> merged, part, buffer;
+        for (auto &child : children)
+        {
+            part.clear();
+            child->drain(part);
+            if (merged.empty())
+            {
+                merged.swap(part);
+                continue;
+            }
+            SetOperations::unite(merged, part, buffer);
+            merged.swap(buffer);
+        }
+        out.insert(out.end(), merged.begin(), merged.end());
+        current = kEndDoc;
+    }
+};
+
+// Дополнение до всех документов 0..totalDocs-1: документы ребенка пропускаются на лету
+class NotIterator : public DocIdIterator
+{
+private:
+    DocIdIteratorPtr child;
+    uint32_t totalDocs;
+
+    void skipExcluded(uint32_t candidate)
+    {
+        for (; candidate < totalDocs; ++candidate)
+        {
+            if (child->docId() < candidate)
+                child->advance(candidate);
+            if (child->docId() != candidate)
+            {
+                current = candidate;
+                return;
+            }
+        }
+        current = kEndDoc;
+    }
+
+public:
+    NotIterator(DocIdIteratorPtr operand, size_t docCount)
+        : child(std::move(operand)), totalDocs(static_cast<uint32_t>(std::min<size_t>(docCount, kEndDoc)))
+    {
+        skipExcluded(0);
+    }
+
+    void next() override
+    {
+        if (!atEnd())
+            skipExcluded(current + 1);
+    }
+
+    void advance(uint32_t target) override
+    {
+        if (target > current)
+            skipExcluded(target);
+    }
+
+    size_t cost() const override { return totalDocs - std::min<size_t>(totalDocs, child->cost()); }
+
+    // Исключаемые документы выдаются целиком, дополнение строится одним проходом
+    void drain(std::vector<uint32_t> &out) override
+    {
+        if (atEnd())
+            return;
+        std::vector<uint32_t> excluded;
+        child->drain(excluded);
+        size_t k = out.size();
+        out.resize(k + (totalDocs - current));
+        uint32_t doc = current;
+        for (uint32_t skip : excluded)
+        {
+            if (skip >= totalDocs)
+                break;
+            for (; doc < skip; ++doc)
+                out[k++] = doc;
+            doc = skip + 1;
+        }
+        for (; doc < totalDocs; ++doc)
+            out[k++] = doc;
+        out.resize(k);
+        current = kEndDoc;
+    }
+};
+
+// Все документы итератора по порядку (для выдачи целиком)
+inline std::vector<uint32_t> collectDocIds(DocIdIterator &iterator)
+{
+    std::vector<uint32_t> docIds;
+    iterator.drain(docIds);
+    return docIds;
+}
+
+#endif
@@ -0,0 +1,699 @@
+#ifndef DOC_ID_SET_HPP
+#define DOC_ID_SET_HPP
+
+#include "DocIdIterator.hpp"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+
+// Множество docId в стиле Roaring. Номер делится на старшие 16 бит (ключ блока) и
+// младшие 16 бит; каждый блок хранится контейнером, который для него компактнее:
+//   Array  - отсортированные младшие половины, до kArrayLimit чисел (2 байта на число);
+//   Bitmap - 2^16 бит (8 КБ) для плотных блоков;
+//   Run    - пары (начало, длина - 1) для длинных отрезков подряд идущих номеров.
+// add переводит переполненный массив в битмап, runOptimize выбирает для каждого
+// блока самое компактное представление.
+// AND/OR/ANDNOT считаются поконтейнерно: блоки только одного множества не
+// пересчитываются, пара битмапов обрабатывается пословно.
+class DocIdSet
+{
+public:
+    enum class ContainerType : uint8_t
+    {
+        Array = 0,
+        Bitmap = 1,
+        Run = 2,
+    };
+
+    static constexpr uint32_t kArrayLimit = 4096;
+    static constexpr size_t kBitmapWords = 1024;
+
+private:
+    friend class DocIdSetIterator;
+
+    struct Container
+    {
+        uint16_t key = 0;
+        ContainerType type = ContainerType::Array;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> values; // Array - числа, Run - пары (начало, длина - 1)
+        std::vector<uint64_t> bits;   // Bitmap
+    };
+
+    std::vector<Container> containers; // По возрастанию ключа
+    size_t total = 0;
+
+    // ---------- Контейнеры ----------
+
+    // Индекс первого отрезка Run-контейнера, который заканчивается не раньше low
+    static size_t findRun(const Container &c, size_t from, uint32_t low)
+    {
+        size_t lo = from, hi = c.values.size() / 2;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (uint32_t(c.values[2 * mid]) + c.values[2 * mid + 1] < low)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    // Первое число битмапа >= low, либо 65536
+    static uint32_t nextBit(const std::vector<uint64_t> &bits, uint32_t low)
+    {
+        size_t word = low >> 6;
+        if (word >= kBitmapWords)
+            return 1u << 16;
+        uint64_t value = bits[word] & (~0ull << (low & 63));
+        while (value == 0)
+        {
+            if (++word == kBitmapWords)
+                return 1u << 16;
+            value = bits[word];
+        }
+        return static_cast<uint32_t>(word * 64 + __builtin_ctzll(value));
+    }
+
+    static bool containerContains(const Container &c, uint16_t low)
+    {
+        switch (c.type)
+        {
+        case ContainerType::Array:
+            return std::binary_search(c.values.begin(), c.values.end(), low);
+        case ContainerType::Bitmap:
+            return (c.bits[low >> 6] >> (low & 63)) & 1;
+        default:
+        {
+            size_t run = findRun(c, 0, low);
+            return run < c.values.size() / 2 && c.values[2 * run] <= low;
+        }
+        }
+    }
+
+    template <typename Visit>
+    static void forEachValue(const Container &c, Visit visit)
+    {
+        switch (c.type)
+        {
+        case ContainerType::Array:
+            for (uint16_t value : c.values)
+                visit(value);
+            break;
+        case ContainerType::Bitmap:
+            for (size_t word = 0; word < kBitmapWords; ++word)
+            {
+                for (uint64_t bits = c.bits[word]; bits != 0; bits &= bits - 1)
+                    visit(static_cast<uint16_t>(word * 64 + __builtin_ctzll(bits)));
+            }
+            break;
+        default:
+            for (size_t r = 0; r < c.values.size(); r += 2)
+            {
+                for (uint32_t value = c.values[r]; value <= uint32_t(c.values[r]) + c.values[r + 1]; ++value)
+                    visit(static_cast<uint16_t>(value));
+            }
+        }
+    }
+
+    // Отрезок [first, last] в битмапе
+    static void setRange(std::vector<uint64_t> &bits, uint32_t first, uint32_t last)
+    {
+        for (uint32_t word = first >> 6; word <= last >> 6; ++word)
+        {
+            uint64_t mask = ~0ull;
+            if (word == first >> 6)
+                mask &= ~0ull << (first & 63);
+            if (word == last >> 6)
+                mask &= ~0ull >> (63 - (last & 63));
+            bits[word] |= mask;
+        }
+    }
+
+    static std::vector<uint64_t> bitsOf(const Container &c)
+    {
+        if (c.type == ContainerType::Bitmap)
+            return c.bits;
+        std::vector<uint64_t> bits(kBitmapWords, 0);
+        if (c.type == ContainerType::Array)
+        {
+            for (uint16_t value : c.values)
+                bits[value >> 6] |= 1ull << (value & 63);
+        }
+        else
+        {
+            for (size_t r = 0; r < c.values.size(); r += 2)
+                setRange(bits, c.values[r], uint32_t(c.values[r]) + c.values[r + 1]);
+        }
+        return bits;
+    }
+
+    // Битмап в контейнер; если чисел мало - массив
+    static Container fromBits(uint16_t key, std::vector<uint64_t> bits)
+    {
+        Container c;
+        c.key = key;
+        c.type = ContainerType::Bitmap;
+        c.bits = std::move(bits);
+        for (uint64_t word : c.bits)
+            c.cardinality += __builtin_popcountll(word);
+        if (c.cardinality <= kArrayLimit)
+        {
+            std::vector<uint16_t> values;
+            values.reserve(c.cardinality);
+            forEachValue(c, [&](uint16_t value)
+                         { values.push_back(value); });
+            c.type = ContainerType::Array;
+            c.values = std::move(values);
+            c.bits = {};
+        }
+        return c;
+    }
+
+    // Отсортированные числа в контейнер; если их много - битмап
+    static Container fromValues(uint16_t key, std::vector<uint16_t> values)
+    {
+        Container c;
+        c.key = key;
+        c.cardinality = static_cast<uint32_t>(values.size());
+        c.values = std::move(values);
+        if (c.cardinality > kArrayLimit)
+            toBitmap(c);
+        return c;
+    }
+
+    static void toBitmap(Container &c)
+    {
+        c.bits = bitsOf(c);
+        c.values = {};
+        c.type = ContainerType::Bitmap;
+    }
+
+    static size_t countRuns(const Container &c)
+    {
+        if (c.type == ContainerType::Run)
+            return c.values.size() / 2;
+        size_t runs = 0;
+        uint32_t previous = UINT32_MAX;
+        forEachValue(c, [&](uint16_t value)
+                     {
+            if (value != previous + 1)
+                ++runs;
+            previous = value; });
+        return runs;
+    }
+
+    // Самое компактное представление блока
+    static void optimize(Container &c)
+    {
+        size_t runBytes = 4 * countRuns(c);
+        size_t arrayBytes = c.cardinality <= kArrayLimit ? 2 * size_t(c.cardinality) : SIZE_MAX;
+        size_t bitmapBytes = kBitmapWords * sizeof(uint64_t);
+
+        ContainerType best = arrayBytes <= bitmapBytes ? ContainerType::Array : ContainerType::Bitmap;
+        if (runBytes < std::min(arrayBytes, bitmapBytes))
+            best = ContainerType::Run;
+        if (best == c.type)
+            return;
+
+        Container converted;
+        converted.key = c.key;
+        converted.type = best;
+        converted.cardinality = c.cardinality;
+        if (best == ContainerType::Bitmap)
+            converted.bits = bitsOf(c);
+        else if (best == ContainerType::Array)
+        {
+            converted.values.reserve(c.cardinality);
+            forEachValue(c, [&](uint16_t value)
+                         { converted.values.push_back(value); });
+        }
+        else
+        {
+            forEachValue(c, [&](uint16_t value)
+                         {
+                if (!converted.values.empty() &&
+                    uint32_t(converted.values[converted.values.size() - 2]) + converted.values.back() + 1 == value)
+                    ++converted.values.back();
+                else
+                {
+                    converted.values.push_back(value);
+                    converted.values.push_back(0);
+                } });
+        }
+        c = std::move(converted);
+    }
+
+    // true, если числа в блоке еще не было
+    static bool addToContainer(Container &c, uint16_t low)
+    {
+        switch (c.type)
+        {
+        case ContainerType::Array:
+            if (c.values.empty() || c.values.back() < low)
+                c.values.push_back(low);
+            else
+            {
+                auto it = std::lower_bound(c.values.begin(), c.values.end(), low);
+                if (*it == low)
+                    return false;
+                c.values.insert(it, low);
+            }
+            if (++c.cardinality > kArrayLimit)
+                toBitmap(c);
+            return true;
+        case ContainerType::Bitmap:
+            if ((c.bits[low >> 6] >> (low & 63)) & 1)
+                return false;
+            c.bits[low >> 6] |= 1ull << (low & 63);
+            ++c.cardinality;
+            return true;
+        default:
+        {
+            uint32_t lastEnd = c.values.empty() ? 0 : uint32_t(c.values[c.values.size() - 2]) + c.values.back();
+            if (!c.values.empty() && low == lastEnd + 1)
+                ++c.values.back();
+            else if (c.values.empty() || low > lastEnd + 1)
+            {
+                c.values.push_back(low);
+                c.values.push_back(0);
+            }
+            else
+            {
+                // Вставка внутрь отрезков - через битмап
+                if (containerContains(c, low))
+                    return false;
+                toBitmap(c);
+                c.bits[low >> 6] |= 1ull << (low & 63);
+            }
+            ++c.cardinality;
+            return true;
+        }
+        }
+    }
+
+    static Container intersectContainers(const Container &a, const Container &b)
+    {
+        if (a.type == ContainerType::Array || b.type == ContainerType::Array)
+        {
+            const Container &small = a.type == ContainerType::Array ? a : b;
+            const Container &other = &small == &a ? b : a;
+            std::vector<uint16_t> values;
+            if (other.type == ContainerType::Array)
+                std::set_intersection(small.values.begin(), small.values.end(), other.values.begin(), other.values.end(),
+                                      std::back_inserter(values));
+            else
+            {
+                for (uint16_t value : small.values)
+                {
+                    if (containerContains(other, value))
+                        values.push_back(value);
+                }
+            }
+            return fromValues(a.key, std::move(values));
+        }
+
+        std::vector<uint64_t> bits = bitsOf(a);
+        std::vector<uint64_t> other = b.type == ContainerType::Bitmap ? std::vector<uint64_t>() : bitsOf(b);
+        const uint64_t *right = b.type == ContainerType::Bitmap ? b.bits.data() : other.data();
+        for (size_t w = 0; w < kBitmapWords; ++w)
+            bits[w] &= right[w];
+        return fromBits(a.key, std::move(bits));
+    }
+
+    static Container uniteContainers(const Container &a, const Container &b)
+    {
+        if (a.type == ContainerType::Array && b.type == ContainerType::Array)
+        {
+            std::vector<uint16_t> values;
+            values.reserve(a.values.size() + b.values.size());
+            std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), std::back_inserter(values));
+            return fromValues(a.key, std::move(values));
+        }
+
+        // Битмап (если есть) копируется, второй операнд доливается в него
+        const Container &base = a.type == ContainerType::Bitmap || b.type == ContainerType::Array ? a : b;
+        const Container &added = &base == &a ? b : a;
+        std::vector<uint64_t> bits = bitsOf(base);
+        if (added.type == ContainerType::Array)
+        {
+            for (uint16_t value : added.values)
+                bits[value >> 6] |= 1ull << (value & 63);
+        }
+        else
+        {
+            std::vector<uint64_t> other = bitsOf(added);
+            for (size_t w = 0; w < kBitmapWords; ++w)
+                bits[w] |= other[w];
+        }
+        return fromBits(a.key, std::move(bits));
+    }
+
+    static Container subtractContainers(const Container &a, const Container &b)
+    {
+        if (a.type == ContainerType::Array)
+        {
+            std::vector<uint16_t> values;
+            for (uint16_t value : a.values)
+            {
+                if (!containerContains(b, value))
+                    values.push_back(value);
+            }
+            return fromValues(a.key, std::move(values));
+        }
+
+        std::vector<uint64_t> bits = bitsOf(a);
+        if (b.type == ContainerType::Array)
+        {
+            for (uint16_t value : b.values)
+                bits[value >> 6] &= ~(1ull << (value & 63));
+        }
+        else
+        {
+            std::vector<uint64_t> other = bitsOf(b);
+            for (size_t w = 0; w < kBitmapWords; ++w)
+                bits[w] &= ~other[w];
+        }
+        return fromBits(a.key, std::move(bits));
+    }
+
+    void append(Container c)
+    {
+        if (c.cardinality == 0)
+            return;
+        total += c.cardinality;
+        containers.push_back(std::move(c));
+    }
+
+public:
+    // docId в любом порядке; по возрастанию - быстрее всего (дописывание в конец)
+    void add(uint32_t docId)
+    {
+        uint16_t key = static_cast<uint16_t>(docId >> 16);
+        if (containers.empty() || containers.back().key < key)
+        {
+            containers.emplace_back();
+            containers.back().key = key;
+        }
+
+        Container *c = &containers.back();
+        if (c->key != key)
+        {
+            auto it = std::lower_bound(containers.begin(), containers.end(), key, [](const Container &container, uint16_t k)
+                                       { return container.key < k; });
+            if (it->key != key)
+            {
+                it = containers.emplace(it);
+                it->key = key;
+            }
+            c = &*it;
+        }
+        if (addToContainer(*c, static_cast<uint16_t>(docId & 0xFFFF)))
+            ++total;
+    }
+
+    bool contains(uint32_t docId) const
+    {
+        uint16_t key = static_cast<uint16_t>(docId >> 16);
+        auto it = std::lower_bound(containers.begin(), containers.end(), key, [](const Container &container, uint16_t k)
+                                   { return container.key < k; });
+        return it != containers.end() && it->key == key && containerContains(*it, static_cast<uint16_t>(docId & 0xFFFF));
+    }
+
+    size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    size_t containerCount() const { return containers.size(); }
+    ContainerType containerType(size_t i) const { return containers[i].type; }
+
+    // Каждый блок - в самое компактное из трех представлений
+    void runOptimize()
+    {
+        for (auto &c : containers)
+            optimize(c);
+    }
+
+    std::vector<uint32_t> toVector() const
+    {
+        std::vector<uint32_t> docIds;
+        docIds.reserve(total);
+        for (const auto &c : containers)
+        {
+            uint32_t high = uint32_t(c.key) << 16;
+            forEachValue(c, [&](uint16_t value)
+                         { docIds.push_back(high | value); });
+        }
+        return docIds;
+    }
+
+    static DocIdSet intersect(const DocIdSet &a, const DocIdSet &b)
+    {
+        DocIdSet result;
+        size_t i = 0, j = 0;
+        while (i < a.containers.size() && j < b.containers.size())
+        {
+            if (a.containers[i].key < b.containers[j].key)
+                ++i;
+            else if (b.containers[j].key < a.containers[i].key)
+                ++j;
+            else
+                result.append(intersectContainers(a.containers[i++], b.containers[j++]));
+        }
+        return result;
+    }
+
+    static DocIdSet unite(const DocIdSet &a, const DocIdSet &b)
+    {
+        DocIdSet result;
+        size_t i = 0, j = 0;
+        while (i < a.containers.size() || j < b.containers.size())
+        {
+            if (j == b.containers.size() || (i < a.containers.size() && a.containers[i].key < b.containers[j].key))
+                result.append(a.containers[i++]);
+            else if (i == a.containers.size() || b.containers[j].key < a.containers[i].key)
+                result.append(b.containers[j++]);
+            else
+                result.append(uniteContainers(a.containers[i++], b.containers[j++]));
+        }
+        return result;
+    }
+
+    // a без b (ANDNOT)
+    static DocIdSet subtract(const DocIdSet &a, const DocIdSet &b)
+    {
+        DocIdSet result;
+        size_t j = 0;
+        for (const auto &c : a.containers)
+        {
+            while (j < b.containers.size() && b.containers[j].key < c.key)
+                ++j;
+            if (j < b.containers.size() && b.containers[j].key == c.key)
+                result.append(subtractContainers(c, b.containers[j]));
+            else
+                result.append(c);
+        }
+        return result;
+    }
+
+    // Объем контейнеров, байт: ключ, тип и мощность блока плюс его содержимое
+    size_t byteSize() const
+    {
+        size_t bytes = 0;
+        for (const auto &c : containers)
+        {
+            bytes += sizeof(c.key) + sizeof(c.type) + sizeof(c.cardinality);
+            if (c.type == ContainerType::Bitmap)
+                bytes += kBitmapWords * sizeof(uint64_t);
+            else
+                bytes += c.values.size() * sizeof(uint16_t);
+        }
+        return bytes;
+    }
+};
+
+// Обход DocIdSet по возрастанию; advance пропускает блоки целиком по ключу
+class DocIdSetIterator : public DocIdIterator
+{
+private:
+    std::shared_ptr<const DocIdSet> owner; // Пуст, если множество живет дольше итератора
+    const DocIdSet &set;
+    size_t block = 0;
+    size_t position = 0; // Array - индекс числа, Run - индекс отрезка
+
+    // Первое число текущего блока >= low
+    bool seekInBlock(uint32_t low)
+    {
+        const DocIdSet::Container &c = set.containers[block];
+        uint32_t value;
+        if (c.type == DocIdSet::ContainerType::Array)
+        {
+            position = std::lower_bound(c.values.begin() + position, c.values.end(), low) - c.values.begin();
+            if (position == c.values.size())
+                return false;
+            value = c.values[position];
+        }
+        else if (c.type == DocIdSet::ContainerType::Bitmap)
+        {
+            value = DocIdSet::nextBit(c.bits, low);
+            if (value > 0xFFFF)
+                return false;
+        }
+        else
+        {
+            position = DocIdSet::findRun(c, position, low);
+            if (position == c.values.size() / 2)
+                return false;
+            value = std::max<uint32_t>(c.values[2 * position], low);
+        }
+        current = (uint32_t(c.key) << 16) | value;
+        return true;
+    }
+
+    // Первый документ >= low в блоке from или дальше
+    void settle(size_t from, uint32_t low)
+    {
+        for (; from < set.containers.size(); ++from, low = 0)
+        {
+            if (from != block)
+            {
+                block = from;
+                position = 0;
+            }
+            if (seekInBlock(low))
+                return;
+        }
+        current = kEndDoc;
+    }
+
+public:
+    explicit DocIdSetIterator(const DocIdSet &docIds) : set(docIds)
+    {
+        settle(0, 0);
+    }
+
+    explicit DocIdSetIterator(std::shared_ptr<const DocIdSet> docIds) : owner(std::move(docIds)), set(*owner)
+    {
+        settle(0, 0);
+    }
+
+    void next() override
+    {
+        if (atEnd())
+            return;
+        const DocIdSet::Container &c = set.containers[block];
+        if (c.type == DocIdSet::ContainerType::Array)
+        {
+            if (++position < c.values.size())
+                current = (uint32_t(c.key) << 16) | c.values[position];
+            else
+                settle(block + 1, 0);
+            return;
+        }
+        settle(block, (current & 0xFFFF) + 1);
+    }
+
+    void advance(uint32_t target) override
+    {
+        if (target <= current)
+            return;
+        uint16_t key = static_cast<uint16_t>(target >> 16);
+        if (key == set.containers[block].key)
+        {
+            settle(block, target & 0xFFFF);
+            return;
+        }
+        auto it = std::lower_bound(set.containers.begin() + block + 1, set.containers.end(), key,
+                                   [](const DocIdSet::Container &container, uint16_t k)
+                                   { return container.key < k; });
+        size_t found = it - set.containers.begin();
+        settle(found, found < set.containers.size() && it->key == key ? target & 0xFFFF : 0);
+    }
+
+    size_t cost() const override { return set.size(); }
+
+    void drain(std::vector<uint32_t> &out) override
+    {
+        if (atEnd())
+            return;
+        uint32_t first = current;
+        for (; block < set.containers.size(); ++block)
+        {
+            const DocIdSet::Container &c = set.containers[block];
+            uint32_t high = uint32_t(c.key) << 16;
+            DocIdSet::forEachValue(c, [&](uint16_t value)
+                                   {
+                if ((high | value) >= first)
+                    out.push_back(high | value); });
+        }
+        current = kEndDoc;
+    }
+};
+
+// Результат булевой алгебры над DocIdSet: множество или его дополнение до всех
+// документов. NOT только переключает complement, дополнение не строится никогда:
+// x & !y считается как ANDNOT, !x & !y - как !(x | y), x | !y - как !(y ANDNOT x).
+// Листья ссылаются на множества индекса без копирования
+struct DocIdSetExpr
+{
+    std::shared_ptr<const DocIdSet> set;
+    bool complement = false;
+
+    static DocIdSetExpr reference(const DocIdSet &docIds)
+    {
+        return {std::shared_ptr<const DocIdSet>(std::shared_ptr<const DocIdSet>(), &docIds), false};
+    }
+
+    static DocIdSetExpr owning(DocIdSet docIds, bool complemented = false)
+    {
+        return {std::make_shared<const DocIdSet>(std::move(docIds)), complemented};
+    }
+
+    static DocIdSetExpr negation(DocIdSetExpr operand)
+    {
+        operand.complement = !operand.complement;
+        return operand;
+    }
+
+    static DocIdSetExpr conjunction(const DocIdSetExpr &a, const DocIdSetExpr &b)
+    {
+        if (!a.complement && !b.complement)
+            return owning(DocIdSet::intersect(*a.set, *b.set));
+        if (!a.complement)
+            return owning(DocIdSet::subtract(*a.set, *b.set));
+        if (!b.complement)
+            return owning(DocIdSet::subtract(*b.set, *a.set));
+        return owning(DocIdSet::unite(*a.set, *b.set), true);
+    }
+
+    static DocIdSetExpr disjunction(const DocIdSetExpr &a, const DocIdSetExpr &b)
+    {
+        if (!a.complement && !b.complement)
+            return owning(DocIdSet::unite(*a.set, *b.set));
+        if (!a.complement)
+            return owning(DocIdSet::subtract(*b.set, *a.set), true);
+        if (!b.complement)
+            return owning(DocIdSet::subtract(*a.set, *b.set), true);
+        return owning(DocIdSet::intersect(*a.set, *b.set), true);
+    }
+
+    // Число документов результата среди 0..totalDocs-1
+    size_t size(size_t totalDocs) const
+    {
+        return complement ? totalDocs - std::min(totalDocs, set->size()) : set->size();
+    }
+
+    // Дополнение выдается на лету через NotIterator
+    DocIdIteratorPtr openIterator(size_t totalDocs) const
+    {
+        auto iterator = std::make_unique<DocIdSetIterator>(set);
+        if (!complement)
+            return iterator;
+        return std::make_unique<NotIterator>(std::move(iterator), totalDocs);
+    }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef DOCUMENT_STATS_HPP
+#define DOCUMENT_STATS_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Статистика документов для нормализации по длине (BM25): длина документа в
+// токенах (леммах), по docId. Считается при индексации и хранится рядом с
+// индексом в файле <индекс>.docs:
+//
+//   [DocumentStatsHeader] uint32_t length[docCount]
+//
+// Документ без токенов имеет длину 0 и в среднюю длину не входит.
+constexpr char kDocumentStatsMagic[8] = {'I', 'R', 'D', 'O', 'C', 'S', '\0', '\0'};
+constexpr uint32_t kDocumentStatsVersion = 1;
+
+struct DocumentStatsHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t docCount;
+};
+
+class DocumentStats
+{
+private:
+    std::vector<uint32_t> lengths;
+    uint64_t totalLength = 0;
+    size_t nonEmptyDocs = 0;
+    // Наименьшая ненулевая длина. addTokens только помечает ее устаревшей: длина документа
+    // растет по токену, и промежуточные длины не должны попадать в минимум
+    uint32_t shortest = 0;
+    bool shortestStale = false;
+
+    static uint32_t shortestOf(const std::vector<uint32_t> &lengths)
+    {
+        uint32_t result = 0;
+        for (uint32_t length : lengths)
+        {
+            if (length != 0)
+                result = result == 0 ? length : std::min(result, length);
+        }
+        return result;
+    }
+
+public:
+    // Пересчитывает сводные величины по длинам, в том числе наименьшую длину после addTokens
+    void recount()
+    {
+        totalLength = 0;
+        nonEmptyDocs = 0;
+        for (uint32_t length : lengths)
+        {
+            totalLength += length;
+            nonEmptyDocs += length != 0;
+        }
+        shortest = shortestOf(lengths);
+        shortestStale = false;
+    }
+
+    // Файл статистики рядом с файлом индекса
+    static std::string pathFor(const std::string &indexFile) { return indexFile + ".docs"; }
+
+    // IDF термина в BM25 (Робертсон - Спарк Джонс, сдвинутый в неотрицательные значения):
+    // log(1 + (N - df + 0.5) / (df + 0.5))
+    static double idf(size_t totalDocs, uint32_t docFrequency)
+    {
+        double n = (double)std::max<size_t>(totalDocs, docFrequency);
+        return std::log(1.0 + (n - docFrequency + 0.5) / (docFrequency + 0.5));
+    }
+
+    // Еще count токенов документа docId
+    void addTokens(uint32_t docId, uint32_t count = 1)
+    {
+        if (docId >= lengths.size())
+            lengths.resize(static_cast<size_t>(docId) + 1, 0);
+
+        if (lengths[docId] == 0 && count > 0)
+            nonEmptyDocs++;
+        lengths[docId] += count;
+        totalLength += count;
+        shortestStale = true;
+    }
+
+    // Добавляет длины документов другой части (наборы документов не пересекаются)
+    void merge(const DocumentStats &other)
+    {
+        if (other.lengths.size() > lengths.size())
+            lengths.resize(other.lengths.size(), 0);
+        for (size_t docId = 0; docId < other.lengths.size(); ++docId)
+            lengths[docId] += other.lengths[docId];
+        recount();
+    }
+
+    uint32_t length(uint32_t docId) const { return docId < lengths.size() ? lengths[docId] : 0; }
+    const uint32_t *data() const { return lengths.data(); }
+
+    // Число docId, для которых есть запись (max docId + 1)
+    size_t size() const { return lengths.size(); }
+    bool empty() const { return nonEmptyDocs == 0; }
+
+    double averageLength() const { return nonEmptyDocs ? (double)totalLength / (double)nonEmptyDocs : 0.0; }
+
+    // До recount() после addTokens считается заново при каждом вызове (проход по всем длинам),
+    // ничего не меняя: читать статистику можно из нескольких потоков
+    uint32_t minLength() const { return shortestStale ? shortestOf(lengths) : shortest; }
+
+    size_t memoryUsage() const { return lengths.capacity() * sizeof(uint32_t); }
+
+    void clear()
+    {
+        std::vector<uint32_t>().swap(lengths);
+        recount();
+    }
+
+    bool save(const std::string &filename) const
+    {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            return false;
+
+        DocumentStatsHeader header{};
+        std::memcpy(header.magic, kDocumentStatsMagic, sizeof(kDocumentStatsMagic));
+        header.version = kDocumentStatsVersion;
+        header.docCount = lengths.size();
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(lengths.data()), lengths.size() * sizeof(uint32_t));
+        return !out.fail();
+    }
+
+    // false, если файла нет или он поврежден (статистика при этом пустая)
+    bool load(const std::string &filename)
+    {
+        clear();
+        std::ifstream in(filename, std::ios::binary | std::ios::ate);
+        if (!in.is_open())
+            return false;
+
+        uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+        in.seekg(0);
+        DocumentStatsHeader header{};
+        in.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!in || std::memcmp(header.magic, kDocumentStatsMagic, sizeof(kDocumentStatsMagic)) != 0 ||
+            header.version != kDocumentStatsVersion ||
+            header.docCount > (fileSize - sizeof(header)) / sizeof(uint32_t))
+            return false;
+
+        lengths.resize(header.docCount);
+        in.read(reinterpret_cast<char *>(lengths.data()), lengths.size() * sizeof(uint32_t));
+        if (!in)
+        {
+            clear();
+            return false;
+        }
+
+        recount();
+        return true;
+    }
+};
+
+#endif
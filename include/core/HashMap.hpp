@@ -3,129 +3,391 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <functional>
-#include <stdexcept>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
 
-// Элемент хеш-таблицы (пара Ключ-Значение)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHMAP_USE_SSE2 1
+#endif
+
+// Элемент хеш-таблицы (пара Ключ-Значение + сохранённый полный хеш)
 template <typename K, typename V>
 struct HashNode
 {
     K key;
     V value;
-    HashNode(K k, V v) : key(k), value(v) {}
+    size_t hash; // При рехеше хеш не пересчитываем, при поиске сравниваем его до ключа
+};
+
+// Как хешировать ключ и каким типом его можно искать.
+// Для строк поиск идёт по std::string_view, чтобы запрос не создавал временную std::string.
+template <typename K>
+struct HashMapKeyTraits
+{
+    using LookupType = K;
+    static size_t hash(const K &key) { return std::hash<K>{}(key); }
+};
+
+template <>
+struct HashMapKeyTraits<std::string>
+{
+    using LookupType = std::string_view;
+    // std::hash<std::string> и std::hash<std::string_view> по стандарту совпадают
+    static size_t hash(std::string_view key) { return std::hash<std::string_view>{}(key); }
 };
 
+// Хеш-таблица с открытой адресацией (в стиле SwissTable):
+// - ёмкость всегда степень двойки, слоты разбиты на группы по 16;
+// - на каждый слот один контрольный байт: EMPTY или 7 младших бит хеша (H2);
+// - группа из 16 контрольных байт сравнивается одной SSE2-инструкцией,
+//   ключ сравнивается только у кандидатов с совпавшим H2 и полным хешем;
+// - группы перебираются треугольными шагами, что обходит все группы таблицы.
 template <typename K, typename V>
 class HashMap
 {
-private:
-    // Используем вектор векторов для метода цепочек
-    // std::vector<HashNode> внутри - это "цепочка" при коллизии
-    std::vector<std::vector<HashNode<K, V>>> buckets;
-    size_t tableSize;
-    size_t elementCount;
-    const float maxLoadFactor = 0.75f;
+public:
+    using Node = HashNode<K, V>;
+    using Traits = HashMapKeyTraits<K>;
+    using LookupType = typename Traits::LookupType;
 
-    // Хеш-функция (для строк используем стандартную или DJB2)
-    size_t hashFunction(const K &key) const
-    {
-        return std::hash<K>{}(key) % tableSize;
-    }
+private:
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr int8_t kEmpty = -128; // 0b10000000, у заполненных слотов старший бит 0
 
-    // Метод изменения размера таблицы при достижении Load Factor
-    void rehash()
+    // Маска слотов группы, у которых контрольный байт равен заданному
+    struct Group
     {
-        size_t oldSize = tableSize;
-        tableSize *= 2;
-        auto oldBuckets = std::move(buckets);
+#ifdef HASHMAP_USE_SSE2
+        __m128i ctrl;
+        explicit Group(const int8_t *pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
 
-        buckets.assign(tableSize, std::vector<HashNode<K, V>>());
-        elementCount = 0;
+        uint32_t match(int8_t value) const
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), ctrl)));
+        }
+#else
+        const int8_t *ctrl;
+        explicit Group(const int8_t *pos) : ctrl(pos) {}
 
-        for (size_t i = 0; i < oldSize; ++i)
+        uint32_t match(int8_t value) const
         {
-            for (auto &node : oldBuckets[i])
+            uint32_t mask = 0;
+            for (size_t i = 0; i < kGroupWidth; ++i)
             {
-                insert(node.key, node.value);
+                if (ctrl[i] == value)
+                    mask |= 1u << i;
             }
+            return mask;
         }
+#endif
+        uint32_t matchEmpty() const { return match(kEmpty); }
+    };
+
+    std::unique_ptr<int8_t[]> ctrl;
+    Node *slots = nullptr;
+    size_t capacity = 0; // Всегда степень двойки и кратна kGroupWidth
+    size_t elementCount = 0;
+
+    // Перемешиваем биты: std::hash для целых - тождественная функция,
+    // а нам нужны "хорошие" и младшие (H2), и старшие (H1) биты
+    static size_t mix(size_t h)
+    {
+        uint64_t x = static_cast<uint64_t>(h);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
     }
 
-public:
-    HashMap(size_t initialSize = 1009) : tableSize(initialSize), elementCount(0)
+    static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    static size_t h1(size_t hash) { return hash >> 7; }
+
+    static int lowestBit(uint32_t mask) { return __builtin_ctz(mask); }
+
+    // Максимальная заполненность 7/8
+    static size_t maxElementsFor(size_t cap) { return cap - cap / 8; }
+
+    static size_t capacityFor(size_t expectedElements)
+    {
+        size_t cap = kGroupWidth;
+        while (maxElementsFor(cap) < expectedElements)
+            cap *= 2;
+        return cap;
+    }
+
+    void allocate(size_t newCapacity)
     {
-        buckets.resize(tableSize);
+        capacity = newCapacity;
+        ctrl.reset(new int8_t[capacity]);
+        std::memset(ctrl.get(), kEmpty, capacity);
+        slots = std::allocator<Node>().allocate(capacity);
     }
 
-    void insert(const K &key, const V &value)
+    void destroyAll()
     {
-        if ((float)elementCount / tableSize > maxLoadFactor)
+        if (!slots)
+            return;
+        for (size_t i = 0; i < capacity; ++i)
         {
-            rehash();
+            if (ctrl[i] != kEmpty)
+                slots[i].~Node();
         }
+        std::allocator<Node>().deallocate(slots, capacity);
+        slots = nullptr;
+        ctrl.reset();
+        capacity = 0;
+        elementCount = 0;
+    }
+
+    // Индекс слота с ключом или -1, если ключа нет
+    template <typename Q>
+    ptrdiff_t find(const Q &key, size_t hash) const
+    {
+        if (capacity == 0)
+            return -1;
+
+        const size_t groupMask = capacity / kGroupWidth - 1;
+        const int8_t tag = h2(hash);
+        size_t group = h1(hash) & groupMask;
 
-        size_t index = hashFunction(key);
-        // Проверяем, существует ли ключ, чтобы обновить значение
-        for (auto &node : buckets[index])
+        for (size_t step = 1;; ++step)
         {
-            if (node.key == key)
+            const size_t base = group * kGroupWidth;
+            Group g(ctrl.get() + base);
+
+            for (uint32_t mask = g.match(tag); mask != 0; mask &= mask - 1)
             {
-                node.value = value;
-                return;
+                size_t index = base + lowestBit(mask);
+                if (slots[index].hash == hash && slots[index].key == key)
+                    return static_cast<ptrdiff_t>(index);
             }
+
+            // Пустой слот в группе означает, что дальше по цепочке проб ключа нет
+            if (g.matchEmpty() != 0)
+                return -1;
+
+            group = (group + step) & groupMask;
         }
+    }
+
+    // Первый свободный слот на цепочке проб (ключа в таблице заведомо нет)
+    size_t findEmptySlot(size_t hash) const
+    {
+        const size_t groupMask = capacity / kGroupWidth - 1;
+        size_t group = h1(hash) & groupMask;
 
-        buckets[index].emplace_back(key, value);
+        for (size_t step = 1;; ++step)
+        {
+            Group g(ctrl.get() + group * kGroupWidth);
+            uint32_t mask = g.matchEmpty();
+            if (mask != 0)
+                return group * kGroupWidth + lowestBit(mask);
+
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // Метод изменения размера таблицы: узлы переносятся перемещением,
+    // позиция считается по сохранённому хешу без обращения к ключу
+    void rehash(size_t newCapacity)
+    {
+        std::unique_ptr<int8_t[]> oldCtrl = std::move(ctrl);
+        Node *oldSlots = slots;
+        size_t oldCapacity = capacity;
+
+        allocate(newCapacity);
+
+        for (size_t i = 0; i < oldCapacity; ++i)
+        {
+            if (oldCtrl[i] == kEmpty)
+                continue;
+
+            Node &node = oldSlots[i];
+            size_t index = findEmptySlot(node.hash);
+            ctrl[index] = h2(node.hash);
+            new (slots + index) Node(std::move(node));
+            node.~Node();
+        }
+
+        if (oldSlots)
+            std::allocator<Node>().deallocate(oldSlots, oldCapacity);
+    }
+
+    // Находит свободный слот под новый ключ (с расширением таблицы при необходимости).
+    // Слот помечается занятым только после успешного конструирования узла.
+    size_t prepareInsert(size_t hash)
+    {
+        if (elementCount + 1 > maxElementsFor(capacity))
+            rehash(capacity == 0 ? kGroupWidth : capacity * 2);
+
+        return findEmptySlot(hash);
+    }
+
+    void commitInsert(size_t index, size_t hash)
+    {
+        ctrl[index] = h2(hash);
         elementCount++;
     }
 
-    // Возвращает указатель на значение, или nullptr если не найдено
-    V *get(const K &key)
+public:
+    // initialSize - ожидаемое количество элементов
+    HashMap(size_t initialSize = kGroupWidth)
     {
-        size_t index = hashFunction(key);
-        for (auto &node : buckets[index])
+        allocate(capacityFor(initialSize));
+    }
+
+    HashMap(const HashMap &other)
+    {
+        if (other.capacity == 0)
+            return;
+
+        allocate(other.capacity);
+        for (size_t i = 0; i < capacity; ++i)
         {
-            if (node.key == key)
-            {
-                return &node.value;
-            }
+            if (other.ctrl[i] == kEmpty)
+                continue;
+            ctrl[i] = other.ctrl[i];
+            new (slots + i) Node(other.slots[i]);
         }
-        return nullptr;
+        elementCount = other.elementCount;
     }
 
-    bool contains(const K &key) const
+    HashMap(HashMap &&other) noexcept
+        : ctrl(std::move(other.ctrl)), slots(other.slots),
+          capacity(other.capacity), elementCount(other.elementCount)
     {
-        size_t index = hashFunction(key);
-        for (const auto &node : buckets[index])
+        other.slots = nullptr;
+        other.capacity = 0;
+        other.elementCount = 0;
+    }
+
+    HashMap &operator=(HashMap other) noexcept
+    {
+        std::swap(ctrl, other.ctrl);
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
+        std::swap(elementCount, other.elementCount);
+        return *this;
+    }
+
+    ~HashMap() { destroyAll(); }
+
+    // Вставка, если ключа нет: значение конструируется на месте из args.
+    // Если ключ уже есть, ничего не происходит (args не используются).
+    // Возвращает указатель на значение и флаг "вставлено".
+    template <typename KK, typename... Args>
+    std::pair<V *, bool> try_emplace(KK &&key, Args &&...args)
+    {
+        size_t hash;
+        ptrdiff_t found;
         {
-            if (node.key == key)
-                return true;
+            const LookupType &lookup = key;
+            hash = mix(Traits::hash(lookup));
+            found = find(lookup, hash);
         }
-        return false;
+        if (found >= 0)
+            return {&slots[found].value, false};
+
+        size_t index = prepareInsert(hash);
+        new (slots + index) Node{K(std::forward<KK>(key)), V(std::forward<Args>(args)...), hash};
+        commitInsert(index, hash);
+        return {&slots[index].value, true};
+    }
+
+    // Как try_emplace, но существующее значение заменяется новым
+    template <typename KK, typename... Args>
+    std::pair<V *, bool> emplace(KK &&key, Args &&...args)
+    {
+        auto result = try_emplace(std::forward<KK>(key), std::forward<Args>(args)...);
+        if (!result.second)
+            *result.first = V(std::forward<Args>(args)...);
+        return result;
+    }
+
+    // Вставка или обновление значения
+    void insert(const K &key, const V &value) { emplace(key, value); }
+    void insert(K &&key, V &&value) { emplace(std::move(key), std::move(value)); }
+
+    // Ссылка на значение по ключу; если ключа нет - вставляет V() за один проход по таблице.
+    // Ссылка действительна до следующей вставки.
+    V &getOrInsert(const LookupType &key)
+    {
+        return *try_emplace(key).first;
+    }
+
+    // Возвращает указатель на значение, или nullptr если не найдено
+    V *get(const LookupType &key)
+    {
+        ptrdiff_t found = find(key, mix(Traits::hash(key)));
+        return found >= 0 ? &slots[found].value : nullptr;
+    }
+
+    const V *get(const LookupType &key) const
+    {
+        ptrdiff_t found = find(key, mix(Traits::hash(key)));
+        return found >= 0 ? &slots[found].value : nullptr;
+    }
+
+    bool contains(const LookupType &key) const
+    {
+        return find(key, mix(Traits::hash(key))) >= 0;
     }
 
     size_t size() const { return elementCount; }
 
+    // Объем памяти таблицы в байтах (без динамической памяти внутри ключей и значений)
+    size_t memoryUsage() const { return capacity * (sizeof(Node) + 1); }
+
+    // Заранее расширяет таблицу под expectedElements элементов
+    void reserve(size_t expectedElements)
+    {
+        size_t needed = capacityFor(expectedElements);
+        if (needed > capacity)
+            rehash(needed);
+    }
+
     // Метод для обхода всех элементов (нужен для сохранения на диск)
-    void traverse(std::function<void(const K &key, const V &value)> callback) const
+    template <typename Callback>
+    void traverse(Callback &&callback) const
     {
-        for (const auto &bucket : buckets)
+        for (size_t i = 0; i < capacity; ++i)
         {
-            for (const auto &node : bucket)
-            {
-                callback(node.key, node.value);
-            }
+            if (ctrl[i] != kEmpty)
+                callback(slots[i].key, slots[i].value);
+        }
+    }
+
+    // То же с изменяемыми значениями (ключи менять нельзя)
+    template <typename Callback>
+    void traverse(Callback &&callback)
+    {
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            if (ctrl[i] != kEmpty)
+                callback(static_cast<const K &>(slots[i].key), slots[i].value);
         }
     }
 
     void clear()
     {
-        for (auto &bucket : buckets)
+        for (size_t i = 0; i < capacity; ++i)
         {
-            bucket.clear();
+            if (ctrl[i] != kEmpty)
+            {
+                slots[i].~Node();
+                ctrl[i] = kEmpty;
+            }
         }
         elementCount = 0;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,79 @@
+#ifndef IMPACT_SEGMENTS_HPP
+#define IMPACT_SEGMENTS_HPP
+
+#include "IndexFormat.hpp"
+#include "../utils/Compression.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Постинги термина в раскладке по вкладам (IndexLayout::ImpactOrdered, см.
+// IndexFormat.hpp): сегменты с равным вкладом, от большего вклада к меньшему.
+// Сегмент распаковывается блоками по kPostingsBlockSize docId. Данные должны
+// жить дольше объекта.
+//
+//   for (uint32_t s = 0; s < segments.size(); ++s)
+//       segments.forEachBlock(s, [&](const uint32_t *docIds, uint32_t count) { ...; return true; });
+class ImpactSegments
+{
+private:
+    const uint8_t *table = nullptr;
+    const uint8_t *docs = nullptr;
+    uint32_t docsSize = 0;
+    uint32_t count = 0;
+    BlockCodec codec = BlockCodec::VarByte;
+
+public:
+    // Термина нет
+    ImpactSegments() = default;
+
+    // Постинги термина: size байт (таблица сегментов и docId)
+    ImpactSegments(const uint8_t *data, uint32_t size, uint32_t segmentCount, BlockCodec blockCodec)
+        : codec(blockCodec)
+    {
+        size_t tableBytes = (size_t)segmentCount * sizeof(IndexSegmentEntry);
+        if (tableBytes > size)
+            return;
+
+        table = data;
+        docs = data + tableBytes;
+        docsSize = static_cast<uint32_t>(size - tableBytes);
+        count = segmentCount;
+    }
+
+    // Число сегментов
+    uint32_t size() const { return count; }
+
+    IndexSegmentEntry segment(uint32_t index) const
+    {
+        IndexSegmentEntry entry;
+        std::memcpy(&entry, table + index * sizeof(IndexSegmentEntry), sizeof(entry));
+        return entry;
+    }
+
+    // visit(docIds, n) для блоков сегмента по порядку; false из visit - хватит
+    template <typename Visitor>
+    void forEachBlock(uint32_t index, Visitor &&visit) const
+    {
+        IndexSegmentEntry entry = segment(index);
+        size_t pos = index > 0 ? segment(index - 1).endOffset : 0;
+        size_t end = std::min<size_t>(entry.endOffset, docsSize);
+
+        uint32_t block[kPostingsBlockSize];
+        uint32_t docId = 0;
+        for (uint32_t start = 0; start < entry.docCount; start += kPostingsBlockSize)
+        {
+            uint32_t length = std::min(kPostingsBlockSize, entry.docCount - start);
+            Compression::decodeBlock(codec, docs, end, pos, block, length);
+            for (uint32_t i = 0; i < length; ++i)
+            {
+                docId += block[i];
+                block[i] = docId;
+            }
+            if (!visit(static_cast<const uint32_t *>(block), length))
+                return;
+        }
+    }
+};
+
+#endif
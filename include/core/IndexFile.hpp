@@ -0,0 +1,236 @@
+#ifndef INDEX_FILE_HPP
+#define INDEX_FILE_HPP
+
+#include "Posting.hpp"
+#include "IndexFormat.hpp"
+#include "MappedIndex.hpp"
+#include "../utils/Compression.hpp"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <algorithm>
+
+// Потоковая запись и чтение файла индекса (index.bin и временные прогоны SPIMI).
+// Формат описан в IndexFormat.hpp. Термины записываются строго по возрастанию,
+// поэтому по словарю можно искать бинарным поиском, а файлы - сливать за один проход.
+
+class IndexFileWriter
+{
+private:
+    std::ofstream out;
+    IndexFileHeader header{};
+    uint64_t position = 0;
+
+    // Словарь копится в памяти и дописывается в конце файла
+    std::vector<IndexTermEntry> entries;
+    std::string termPool;
+
+    std::vector<uint8_t> blocks;
+    std::vector<IndexSkipEntry> skips;
+    std::vector<IndexSegmentEntry> segments;
+    PostingsList byImpact;
+    BlockCodec codec = BlockCodec::VarByte;
+    uint32_t values[kPostingsBlockSize];
+
+    // Постинги по сегментам равного вклада (в termFrequency), от большего к меньшему
+    void writeImpactSegments(std::string_view term, const PostingsList &postings)
+    {
+        // Устойчивая сортировка: внутри сегмента docId остаются по возрастанию
+        byImpact.assign(postings.begin(), postings.end());
+        std::stable_sort(byImpact.begin(), byImpact.end(), [](const Posting &a, const Posting &b)
+                         { return a.termFrequency > b.termFrequency; });
+
+        blocks.clear();
+        segments.clear();
+        for (size_t begin = 0, end = 0; begin < byImpact.size(); begin = end)
+        {
+            uint32_t impact = byImpact[begin].termFrequency;
+            while (end < byImpact.size() && byImpact[end].termFrequency == impact)
+                ++end;
+
+            uint32_t previousDocId = 0;
+            for (size_t start = begin; start < end; start += kPostingsBlockSize)
+            {
+                size_t blockEnd = std::min(end, start + kPostingsBlockSize);
+                for (size_t i = start; i < blockEnd; ++i)
+                {
+                    values[i - start] = byImpact[i].docId - previousDocId;
+                    previousDocId = byImpact[i].docId;
+                }
+                Compression::encodeBlock(codec, values, blockEnd - start, blocks);
+            }
+            segments.push_back({impact, static_cast<uint32_t>(end - begin), static_cast<uint32_t>(blocks.size())});
+        }
+
+        size_t tableBytes = segments.size() * sizeof(IndexSegmentEntry);
+
+        IndexTermEntry entry{};
+        entry.postingsOffset = position;
+        entry.termOffset = static_cast<uint32_t>(termPool.size());
+        entry.termLength = static_cast<uint32_t>(term.size());
+        entry.docFrequency = static_cast<uint32_t>(postings.size());
+        entry.postingsSize = static_cast<uint32_t>(tableBytes + blocks.size());
+        entry.maxTf = segments.empty() ? 0 : segments.front().impact;
+        entry.segmentCount = static_cast<uint32_t>(segments.size());
+        entries.push_back(entry);
+        termPool.append(term);
+
+        out.write(reinterpret_cast<const char *>(segments.data()), tableBytes);
+        out.write(reinterpret_cast<const char *>(blocks.data()), blocks.size());
+        position += tableBytes + blocks.size();
+    }
+
+public:
+    bool open(const std::string &filename, size_t totalDocs, BlockCodec blockCodec = BlockCodec::VarByte)
+    {
+        out.open(filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            return false;
+
+        header = IndexFileHeader{};
+        std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+        header.version = kIndexFormatVersion;
+        header.codec = static_cast<uint32_t>(blockCodec);
+        codec = blockCodec;
+        header.totalDocs = totalDocs;
+        header.postingsOffset = sizeof(IndexFileHeader);
+        entries.clear();
+        termPool.clear();
+
+        // Смещения пока неизвестны - заголовок перепишем в close()
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        position = sizeof(header);
+        return true;
+    }
+
+    // В termFrequency записываемых постингов - квантованные вклады (см. IndexFormat.hpp).
+    // Можно вызвать в любой момент до close()
+    void setImpactQuantization(uint32_t bits, double scale)
+    {
+        header.impactBits = bits;
+        header.impactScale = scale;
+    }
+
+    // Раскладка по вкладам (см. IndexFormat.hpp) - только вместе с setImpactQuantization.
+    // Вызывается до первого writeTerm
+    void setLayout(IndexLayout layout)
+    {
+        header.layout = static_cast<uint32_t>(layout);
+    }
+
+    void writeTerm(std::string_view term, const PostingsList &postings)
+    {
+        if (header.layout == static_cast<uint32_t>(IndexLayout::ImpactOrdered))
+        {
+            writeImpactSegments(term, postings);
+            return;
+        }
+
+        // 1. Сжимаем блоки: дельты DocID, затем TF (см. IndexFormat.hpp)
+        blocks.clear();
+        skips.clear();
+
+        uint32_t previousDocId = 0;
+        uint32_t termMaxTf = 0;
+        for (size_t start = 0; start < postings.size(); start += kPostingsBlockSize)
+        {
+            size_t end = std::min(postings.size(), start + kPostingsBlockSize);
+            for (size_t i = start; i < end; ++i)
+            {
+                values[i - start] = postings[i].docId - previousDocId;
+                previousDocId = postings[i].docId;
+            }
+            Compression::encodeBlock(codec, values, end - start, blocks);
+
+            uint32_t blockMaxTf = 0;
+            for (size_t i = start; i < end; ++i)
+            {
+                values[i - start] = postings[i].termFrequency;
+                blockMaxTf = std::max(blockMaxTf, postings[i].termFrequency);
+            }
+            Compression::encodeBlock(codec, values, end - start, blocks);
+
+            skips.push_back({previousDocId, static_cast<uint32_t>(blocks.size()), blockMaxTf});
+            termMaxTf = std::max(termMaxTf, blockMaxTf);
+        }
+
+        // Для единственного блока таблица пропусков не нужна
+        size_t skipBytes = skips.size() > 1 ? skips.size() * sizeof(IndexSkipEntry) : 0;
+
+        // 2. Запись словаря
+        IndexTermEntry entry{};
+        entry.postingsOffset = position;
+        entry.termOffset = static_cast<uint32_t>(termPool.size());
+        entry.termLength = static_cast<uint32_t>(term.size());
+        entry.docFrequency = static_cast<uint32_t>(postings.size());
+        entry.postingsSize = static_cast<uint32_t>(skipBytes + blocks.size());
+        entry.maxTf = termMaxTf;
+        entries.push_back(entry);
+        termPool.append(term);
+
+        // 3. Пишем таблицу пропусков и сами блоки
+        out.write(reinterpret_cast<const char *>(skips.data()), skipBytes);
+        out.write(reinterpret_cast<const char *>(blocks.data()), blocks.size());
+        position += skipBytes + blocks.size();
+    }
+
+    bool close()
+    {
+        // Строки терминов
+        header.termsOffset = position;
+        out.write(termPool.data(), termPool.size());
+        position += termPool.size();
+
+        // Выравниваем словарь, чтобы читать его из mmap напрямую
+        static const char zeros[alignof(IndexTermEntry)] = {};
+        size_t padding = (alignof(IndexTermEntry) - position % alignof(IndexTermEntry)) % alignof(IndexTermEntry);
+        out.write(zeros, padding);
+        position += padding;
+
+        header.dictionaryOffset = position;
+        header.termCount = entries.size();
+        out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(IndexTermEntry));
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.close();
+        return !out.fail();
+    }
+};
+
+// Последовательное чтение всех терминов файла (загрузка в память, слияние прогонов)
+class IndexFileReader
+{
+private:
+    MappedIndex index;
+    uint32_t nextTermId = 0;
+
+public:
+    bool open(const std::string &filename)
+    {
+        if (!index.open(filename, false))
+            return false;
+
+        index.adviseSequential();
+        nextTermId = 0;
+        return true;
+    }
+
+    size_t getTotalDocs() const { return index.getTotalDocs(); }
+    size_t getTermCount() const { return index.getTermCount(); }
+
+    // Читает следующий термин; false, когда термины закончились
+    bool next(std::string &term, PostingsList &postings)
+    {
+        if (nextTermId >= index.getTermCount())
+            return false;
+
+        term.assign(index.getTerm(nextTermId));
+        index.decodePostings(nextTermId, postings);
+        nextTermId++;
+        return true;
+    }
+};
+
+#endif
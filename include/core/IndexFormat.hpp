@@ -0,0 +1,99 @@
+#ifndef INDEX_FORMAT_HPP
+#define INDEX_FORMAT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include "../utils/Compression.hpp"
+
+// Формат файла индекса (index.bin), рассчитанный на отображение в память (mmap):
+//
+//   [IndexFileHeader]
+//   [постинги]   для каждого термина: [таблица пропусков] [блоки]
+//   [строки]     тексты всех терминов подряд, без разделителей
+//   [словарь]    IndexTermEntry[termCount], по возрастанию термина (бинарный поиск)
+//
+// Постинги термина разбиты на блоки по kPostingsBlockSize документов. Блок - это
+// дельты DocID (первая - от последнего docId предыдущего блока), затем TF; оба
+// массива сжаты кодеком из заголовка (BlockCodec, по умолчанию VarByte).
+// Перед блоками лежит таблица пропусков IndexSkipEntry[число блоков]: по ней
+// advance(docId) перескакивает блоки, не распаковывая их. У терминов из одного
+// блока (а таких большинство) таблицы нет. Максимальные TF блока и термина -
+// верхние границы скора для динамического отсечения (WAND, Block-Max WAND).
+//
+// В индексе квантованных вкладов (impactBits > 0, см. ranking/ImpactIndex.hpp)
+// вместо TF в постингах лежат целые вклады термина в скор, 1..2^impactBits - 1;
+// квант равен impactScale единиц исходного скора. Формат блоков тот же.
+//
+// Индекс вкладов можно записать и в раскладке по вкладам (layout = ImpactOrdered):
+// постинги термина сгруппированы в сегменты с равным вкладом, от большего к меньшему:
+//   [IndexSegmentEntry[segmentCount]] [docId сегментов]
+// Вклад хранится один раз на сегмент, docId сегмента - по возрастанию, дельтами
+// (первая - от нуля) блоками по kPostingsBlockSize. Такой индекс читает только
+// подсчет score-at-a-time (AnytimeScorer): курсоров по docId у него нет.
+//
+// Постинги идут первыми, поэтому файл пишется потоково: словарь и строки
+// дописываются в конце, а смещения проставляются в заголовке при закрытии.
+// Числа хранятся в порядке байт машины (little-endian на всех наших платформах).
+
+constexpr char kIndexMagic[8] = {'I', 'R', 'I', 'N', 'D', 'E', 'X', '\0'};
+constexpr uint32_t kIndexFormatVersion = 5;
+constexpr uint32_t kPostingsBlockSize = 128;
+static_assert(kPostingsBlockSize <= Compression::kMaxBlockValues, "block does not fit the codecs");
+
+// Порядок постингов внутри списка термина
+enum class IndexLayout : uint32_t
+{
+    DocumentOrdered = 0, // По docId, блоки с таблицей пропусков
+    ImpactOrdered = 1,   // Сегменты по убыванию вклада (только для индекса вкладов)
+};
+
+struct IndexFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t codec; // BlockCodec; 0 - VarByte
+    uint64_t totalDocs;
+    uint64_t termCount;
+    uint64_t postingsOffset;
+    uint64_t termsOffset;
+    uint64_t dictionaryOffset; // Выровнено на 8 байт
+    uint32_t impactBits;       // 0 - в постингах TF
+    uint32_t layout;           // IndexLayout
+    double impactScale;        // Цена одного кванта вклада
+};
+
+struct IndexTermEntry
+{
+    uint64_t postingsOffset; // От начала файла
+    uint32_t termOffset;     // От начала области строк
+    uint32_t termLength;
+    uint32_t docFrequency;
+    uint32_t postingsSize; // Байт постингов вместе с таблицей пропусков
+    uint32_t maxTf;        // Наибольший TF термина
+    uint32_t segmentCount; // Сегментов вклада (только в раскладке ImpactOrdered)
+};
+
+struct IndexSkipEntry
+{
+    uint32_t lastDocId; // Последний docId блока
+    uint32_t endOffset; // Конец блока от начала области блоков (после таблицы)
+    uint32_t maxTf;     // Наибольший TF в блоке
+};
+
+struct IndexSegmentEntry
+{
+    uint32_t impact;    // Вклад всех постингов сегмента
+    uint32_t docCount;
+    uint32_t endOffset; // Конец сегмента от начала области docId (после таблицы)
+};
+
+inline bool isValidIndexHeader(const IndexFileHeader &header)
+{
+    return std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+           header.version == kIndexFormatVersion &&
+           Compression::isKnownCodec(header.codec) &&
+           (header.layout == static_cast<uint32_t>(IndexLayout::DocumentOrdered) ||
+            (header.layout == static_cast<uint32_t>(IndexLayout::ImpactOrdered) && header.impactBits != 0));
+}
+
+#endif
@@ -1,231 +1,454 @@
 #ifndef INVERTED_INDEX_HPP
 #define INVERTED_INDEX_HPP
 
-#include "HashMap.hpp"
-#include "../utils/Compression.hpp"
+#include "TermDictionary.hpp"
+#include "Posting.hpp"
+#include "IndexFile.hpp"
+#include "PostingCursor.hpp"
+#include "MappedIndex.hpp"
+#include "DocumentStats.hpp"
+#include "DocIdIterator.hpp"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <iostream>
+#include <cstdio>
+#include <cassert>
 #include <algorithm>
 #include <utility>
 
-struct Posting
-{
-    uint32_t docId;
-    uint32_t termFrequency;
-    Posting(uint32_t id, uint32_t tf) : docId(id), termFrequency(tf) {}
-    Posting() : docId(0), termFrequency(0) {}
-};
-
-using PostingsList = std::vector<Posting>;
-
 class InvertedIndex
 {
 private:
-    HashMap<std::string, PostingsList> index;
+    // Термин -> плотный termId, постинги лежат в массиве по termId
+    TermDictionary dictionary;
+    std::vector<PostingsList> postings;
     size_t totalDocs = 0;
+    size_t postingBytes = 0; // Память под списки постингов (по capacity) - для бюджета SPIMI
+    DocumentStats documents; // Длины документов, сохраняются рядом с индексом
+
+    // Индекс, загруженный из файла, только для чтения: постинги остаются сжатыми,
+    // как в файле, и читаются через PostingCursor. У построенного в памяти индекса пусто.
+    struct CompressedTerm
+    {
+        uint64_t offset; // В compressedPostings
+        uint32_t docFrequency;
+        uint32_t size;
+        uint32_t maxTf;
+    };
+    std::vector<uint8_t> compressedPostings;
+    std::vector<CompressedTerm> compressedTerms;
+    BlockCodec compressedCodec = BlockCodec::VarByte;
+    std::vector<double> termIdf; // IDF по termId, считается один раз при загрузке
+    uint32_t impactBits = 0;     // Загружен индекс квантованных вкладов (см. IndexFormat.hpp)
+    double impactScale = 0;
+
+    // Запись CSV для закона Ципфа: Rank,Term,Frequency (по убыванию частоты)
+    static bool writeFrequencyCsv(std::vector<std::pair<std::string, uint64_t>> &stats, const std::string &filename)
+    {
+        std::ofstream out(filename);
+        if (!out.is_open())
+            return false;
+
+        // Сортируем по убыванию частоты (самые частые — в начале)
+        std::sort(stats.begin(), stats.end(),
+                  [](const auto &a, const auto &b)
+                  {
+                      return a.second > b.second;
+                  });
+
+        out << "Rank,Term,Frequency\n";
+        size_t rank = 1;
+        for (const auto &pair : stats)
+        {
+            out << rank << "," << pair.first << "," << pair.second << "\n";
+            rank++;
+        }
+
+        out.close();
+        if (!out)
+            return false;
+        std::cout << "Zipf stats exported to " << filename << std::endl;
+        return true;
+    }
+
+    // Служебная часть блока кучи под каждый выделенный список (размер и выравнивание malloc)
+    static constexpr size_t kHeapBlockOverhead = 2 * sizeof(void *);
+
+    static size_t listBytes(size_t capacity)
+    {
+        return capacity ? capacity * sizeof(Posting) + kHeapBlockOverhead : 0;
+    }
+
+    void recountPostingBytes()
+    {
+        postingBytes = 0;
+        for (const auto &list : postings)
+            postingBytes += listBytes(list.capacity());
+    }
+
+    static uint64_t collectionFrequency(PostingCursor cursor)
+    {
+        uint64_t frequency = 0;
+        for (; !cursor.atEnd(); cursor.next())
+            frequency += cursor.tf();
+        return frequency;
+    }
 
 public:
-    void addTerm(const std::string &term, uint32_t docId)
+    static constexpr uint32_t kNoTerm = TermDictionary::kNoTerm;
+
+    // Номер термина (заводит новый, если слова еще нет). Только для индекса, строящегося в памяти:
+    // загруженный из файла индекс (isCompressed()) только для чтения, для него - kNoTerm
+    uint32_t internTerm(std::string_view term)
+    {
+        assert(!isCompressed() && "loaded index is read-only");
+        if (isCompressed())
+            return kNoTerm;
+
+        uint32_t termId = dictionary.getOrAdd(term);
+        if (termId == postings.size())
+            postings.emplace_back();
+        return termId;
+    }
+
+    // Добавление в загруженный индекс игнорируется (в отладочной сборке - assert)
+    void addTerm(std::string_view term, uint32_t docId)
+    {
+        addPosting(internTerm(term), docId);
+    }
+
+    void addPosting(uint32_t termId, uint32_t docId)
     {
-        PostingsList *list = index.get(term);
-        if (list == nullptr)
+        assert(termId < postings.size() && "unknown termId or loaded index");
+        if (termId >= postings.size())
+            return;
+
+        PostingsList &list = postings[termId];
+        if (!list.empty() && list.back().docId == docId)
         {
-            PostingsList newList;
-            newList.emplace_back(docId, 1);
-            index.insert(term, newList);
+            list.back().termFrequency++;
         }
         else
         {
-            if (!list->empty() && list->back().docId == docId)
-            {
-                list->back().termFrequency++;
-            }
-            else
-            {
-                list->emplace_back(docId, 1);
-            }
+            // Вектор растет геометрически: учитывается выделенное, а не занятое
+            size_t capacity = list.capacity();
+            list.emplace_back(docId, 1);
+            if (list.capacity() != capacity)
+                postingBytes += listBytes(list.capacity()) - listBytes(capacity);
         }
+        documents.addTokens(docId);
     }
 
-    PostingsList *getPostings(const std::string &term)
+    // Номер термина или kNoTerm
+    uint32_t getTermId(std::string_view term) const { return dictionary.find(term); }
+    std::string_view getTerm(uint32_t termId) const { return dictionary.term(termId); }
+    size_t getTermCount() const { return dictionary.size(); }
+
+    // Загружен из файла (постинги сжаты, доступны только через openCursor)
+    bool isCompressed() const { return !compressedTerms.empty(); }
+
+    uint32_t getDocFrequency(uint32_t termId) const
     {
-        return index.get(term);
+        return isCompressed() ? compressedTerms[termId].docFrequency : static_cast<uint32_t>(postings[termId].size());
     }
 
-    void incrementDocCount() { totalDocs++; }
-    size_t getTotalDocs() const { return totalDocs; }
+    // IDF термина для BM25 (см. DocumentStats::idf). У загруженного индекса посчитан
+    // заранее, у строящегося в памяти - по текущей документной частоте
+    double getIdf(uint32_t termId) const
+    {
+        return termId < termIdf.size() ? termIdf[termId] : DocumentStats::idf(totalDocs, getDocFrequency(termId));
+    }
 
-    bool save(const std::string &filename)
+    const DocumentStats &getDocumentStats() const { return documents; }
+
+    // Индекс квантованных вкладов: tf() курсора - вклад в скор
+    bool hasImpacts() const { return impactBits != 0; }
+    uint32_t getImpactBits() const { return impactBits; }
+    double getImpactScale() const { return impactScale; }
+
+    // Пересчитывает длины документов (и память под списки) по постингам - для списков,
+    // заполненных напрямую через getPostingsById(). Только для индекса, построенного в памяти
+    void rebuildDocumentStats()
     {
-        std::ofstream out(filename, std::ios::binary);
-        if (!out.is_open())
-            return false;
+        recountPostingBytes();
+        documents.clear();
+        for (const auto &list : postings)
+        {
+            for (const auto &posting : list)
+                documents.addTokens(posting.docId, posting.termFrequency);
+        }
+        documents.recount();
+    }
 
-        out.write(reinterpret_cast<const char *>(&totalDocs), sizeof(totalDocs));
-
-        size_t termCount = index.size();
-        out.write(reinterpret_cast<const char *>(&termCount), sizeof(termCount));
-
-        index.traverse([&](const std::string &term, const PostingsList &postings)
-                       {
-            // 1. Пишем слово
-            size_t termLen = term.size();
-            out.write(reinterpret_cast<const char*>(&termLen), sizeof(termLen));
-            out.write(term.c_str(), termLen);
-
-            // 2. Подготавливаем данные для сжатия
-            std::vector<uint32_t> deltaDocIds;
-            std::vector<uint32_t> tfs;
-            deltaDocIds.reserve(postings.size());
-            tfs.reserve(postings.size());
-
-            uint32_t previousDocId = 0;
-            for (const auto& p : postings) {
-                deltaDocIds.push_back(p.docId - previousDocId);
-                previousDocId = p.docId;
-                
-                tfs.push_back(p.termFrequency);
-            }
+    // Закрепляет статистику длин после addTerm: до этого minLength() (граница скора BM25)
+    // проходит все длины на каждом запросе
+    void finishDocumentStats() { documents.recount(); }
+
+    // Курсор по постингам термина; работает для любого индекса
+    PostingCursor openCursor(uint32_t termId) const
+    {
+        if (!isCompressed())
+            return PostingCursor(postings[termId]);
 
-            // 3. Сжимаем оба списка (DocID's и TF's)
-            std::vector<uint8_t> compressedDeltas = Compression::compressList(deltaDocIds);
-            std::vector<uint8_t> compressedTfs = Compression::compressList(tfs);
+        const CompressedTerm &entry = compressedTerms[termId];
+        return PostingCursor(compressedPostings.data() + entry.offset, entry.size, entry.docFrequency, compressedCodec, entry.maxTf);
+    }
 
-            // 4. Пишем размеры сжатых блоков
-            size_t sizeDeltas = compressedDeltas.size();
-            size_t sizeTfs = compressedTfs.size();
-            out.write(reinterpret_cast<const char*>(&sizeDeltas), sizeof(sizeDeltas));
-            out.write(reinterpret_cast<const char*>(&sizeTfs), sizeof(sizeTfs));
+    // Для булева поиска (BooleanPlanner, openBooleanIterator): df и документы термина без TF
+    size_t documentFrequency(std::string_view term) const
+    {
+        uint32_t termId = getTermId(term);
+        return termId == kNoTerm ? 0 : getDocFrequency(termId);
+    }
 
-            // 5. Пишем сами сжатые данные
-            out.write(reinterpret_cast<const char*>(compressedDeltas.data()), sizeDeltas);
-            out.write(reinterpret_cast<const char*>(compressedTfs.data()), sizeTfs); });
+    DocIdIteratorPtr openIterator(std::string_view term) const
+    {
+        uint32_t termId = getTermId(term);
+        return std::make_unique<PostingIterator>(termId == kNoTerm ? PostingCursor() : openCursor(termId));
+    }
 
-        out.close();
-        return true;
+    // Распаковывает постинги термина в out (содержимое out заменяется)
+    void decodePostings(uint32_t termId, PostingsList &out) const
+    {
+        out.clear();
+        out.reserve(getDocFrequency(termId));
+        for (PostingCursor cursor = openCursor(termId); !cursor.atEnd(); cursor.next())
+            out.emplace_back(cursor.docId(), cursor.tf());
     }
 
-    bool load(const std::string &filename)
+    // Распакованные постинги есть только у индекса, построенного в памяти;
+    // для загруженного индекса возвращается nullptr - используйте openCursor()
+    PostingsList *getPostings(std::string_view term)
     {
-        std::ifstream in(filename, std::ios::binary);
-        if (!in.is_open())
-            return false;
+        uint32_t termId = dictionary.find(term);
+        return termId == kNoTerm || isCompressed() ? nullptr : &postings[termId];
+    }
+
+    // Только для индекса, построенного в памяти: у загруженного распакованных списков нет
+    // (проверяется assert), читайте его через openCursor() или decodePostings()
+    PostingsList &getPostingsById(uint32_t termId)
+    {
+        assert(termId < postings.size() && "loaded index has no decoded postings");
+        return postings[termId];
+    }
+    const PostingsList &getPostingsById(uint32_t termId) const
+    {
+        assert(termId < postings.size() && "loaded index has no decoded postings");
+        return postings[termId];
+    }
+
+    void reserveTerms(size_t expectedTerms)
+    {
+        dictionary.reserve(expectedTerms);
+        postings.reserve(expectedTerms);
+    }
+
+    // Приблизительный объем памяти индекса в байтах (O(1), для контроля бюджета при индексации)
+    size_t memoryUsage() const
+    {
+        return dictionary.memoryUsage() + postings.capacity() * sizeof(PostingsList) +
+               postingBytes +
+               compressedPostings.capacity() + compressedTerms.capacity() * sizeof(CompressedTerm) +
+               termIdf.capacity() * sizeof(double) + documents.memoryUsage();
+    }
 
-        index.clear();
-        in.read(reinterpret_cast<char *>(&totalDocs), sizeof(totalDocs));
+    // Полностью освобождает память индекса
+    void clear()
+    {
+        dictionary.clear();
+        std::vector<PostingsList>().swap(postings);
+        std::vector<uint8_t>().swap(compressedPostings);
+        std::vector<CompressedTerm>().swap(compressedTerms);
+        std::vector<double>().swap(termIdf);
+        documents.clear();
+        impactBits = 0;
+        impactScale = 0;
+        totalDocs = 0;
+        postingBytes = 0;
+    }
 
-        size_t termCount = 0;
-        in.read(reinterpret_cast<char *>(&termCount), sizeof(termCount));
+    void incrementDocCount() { totalDocs++; }
+    void setTotalDocs(size_t docs) { totalDocs = docs; }
+    size_t getTotalDocs() const { return totalDocs; }
 
-        for (size_t i = 0; i < termCount; ++i)
+    // Сливает индексы, построенные по непересекающимся наборам документов
+    // (например, локальные индексы потоков), построенные в памяти. Списки в каждой части отсортированы
+    // по docId; termId результата выдаются в лексикографическом порядке терминов.
+    static InvertedIndex merge(std::vector<InvertedIndex> parts)
+    {
+        struct TermRef
         {
-            // 1. Читаем слово
-            size_t termLen = 0;
-            in.read(reinterpret_cast<char *>(&termLen), sizeof(termLen));
-            std::string term(termLen, '\0');
-            in.read(&term[0], termLen);
-
-            // 2. Читаем размеры блоков
-            size_t sizeDeltas = 0, sizeTfs = 0;
-            in.read(reinterpret_cast<char *>(&sizeDeltas), sizeof(sizeDeltas));
-            in.read(reinterpret_cast<char *>(&sizeTfs), sizeof(sizeTfs));
-
-            // 3. Читаем сжатые данные
-            std::vector<uint8_t> compressedDeltas(sizeDeltas);
-            std::vector<uint8_t> compressedTfs(sizeTfs);
-            in.read(reinterpret_cast<char *>(compressedDeltas.data()), sizeDeltas);
-            in.read(reinterpret_cast<char *>(compressedTfs.data()), sizeTfs);
-
-            // 4. Распаковка (VarByte -> Delta -> DocID)
-            PostingsList postings;
-            size_t posD = 0;
-            size_t posT = 0;
-
-            uint32_t currentDocId = 0;
-
-            // Пока не дочитаем весь буфер дельт
-            while (posD < sizeDeltas)
-            {
-                uint32_t delta = Compression::decodeVarByte(compressedDeltas, posD);
-                uint32_t tf = Compression::decodeVarByte(compressedTfs, posT);
+            std::string_view term;
+            uint32_t part;
+            uint32_t termId;
+        };
+
+        std::vector<TermRef> refs;
+        InvertedIndex result;
+        for (uint32_t part = 0; part < parts.size(); ++part)
+        {
+            for (uint32_t termId = 0; termId < parts[part].postings.size(); ++termId)
+                refs.push_back({parts[part].dictionary.term(termId), part, termId});
+            result.totalDocs += parts[part].totalDocs;
+            result.documents.merge(parts[part].documents);
+        }
+        std::sort(refs.begin(), refs.end(), [](const TermRef &a, const TermRef &b)
+                  { return a.term < b.term; });
 
-                currentDocId += delta;
-                postings.emplace_back(currentDocId, tf);
+        for (const auto &ref : refs)
+        {
+            PostingsList &source = parts[ref.part].postings[ref.termId];
+            PostingsList &target = result.postings[result.internTerm(ref.term)];
+            if (target.empty())
+            {
+                target = std::move(source);
+                continue;
             }
 
-            index.insert(term, postings);
+            size_t middle = target.size();
+            target.insert(target.end(), source.begin(), source.end());
+            std::inplace_merge(target.begin(), target.begin() + middle, target.end(),
+                               [](const Posting &a, const Posting &b)
+                               { return a.docId < b.docId; });
+            PostingsList().swap(source);
         }
 
-        in.close();
-        return true;
+        result.recountPostingBytes();
+        return result;
     }
 
-    void exportFrequencyStats(const std::string &filename)
+    // Термины записываются по возрастанию: такой файл можно сливать с другими (SPIMI).
+    // Длины документов пишутся рядом, в DocumentStats::pathFor(filename).
+    // Раскладка по вкладам (IndexLayout::ImpactOrdered) - только для индекса вкладов
+    bool save(const std::string &filename, BlockCodec codec = BlockCodec::VarByte,
+              IndexLayout layout = IndexLayout::DocumentOrdered) const
     {
-        std::ofstream out(filename);
-        if (!out.is_open())
-            return;
+        if (layout == IndexLayout::ImpactOrdered && !hasImpacts())
+            return false;
 
-        // 1. Собираем пары <Слово, ОбщаяЧастота>
-        std::vector<std::pair<std::string, uint64_t>> stats;
+        IndexFileWriter writer;
+        if (!writer.open(filename, totalDocs, codec))
+            return false;
+        writer.setImpactQuantization(impactBits, impactScale);
+        writer.setLayout(layout);
 
-        index.traverse([&](const std::string &term, const PostingsList &postings)
-                       {
-            uint64_t collectionFreq = 0;
-            for (const auto& p : postings) {
-                collectionFreq += p.termFrequency;
+        PostingsList buffer;
+        for (uint32_t termId : sortedTermIds())
+        {
+            if (isCompressed())
+            {
+                decodePostings(termId, buffer);
+                writer.writeTerm(dictionary.term(termId), buffer);
+            }
+            else
+            {
+                writer.writeTerm(dictionary.term(termId), postings[termId]);
             }
-            stats.push_back({term, collectionFreq}); });
+        }
 
-        // 2. Сортируем по убыванию частоты (самые частые — в начале)
-        std::sort(stats.begin(), stats.end(),
-                  [](const auto &a, const auto &b)
-                  {
-                      return a.second > b.second;
-                  });
+        return writer.close() && documents.save(DocumentStats::pathFor(filename));
+    }
 
-        // 3. Пишем CSV: Rank,Term,Frequency
-        out << "Rank,Term,Frequency\n";
-        size_t rank = 1;
-        for (const auto &pair : stats)
+    // Удаляет файл, записанный save(), вместе с длинами документов рядом
+    static void removeFiles(const std::string &filename)
+    {
+        std::remove(filename.c_str());
+        std::remove(DocumentStats::pathFor(filename).c_str());
+    }
+
+    // Загружает индекс только для чтения: постинги копируются в память одним блоком
+    // в сжатом виде (в 2-3 раза меньше распакованных Posting) и читаются курсорами.
+    // Индекс в раскладке по вкладам не загружается: курсоров по docId у него нет
+    bool load(const std::string &filename)
+    {
+        MappedIndex file;
+        if (!file.open(filename) || file.isImpactOrdered())
+            return false;
+        file.adviseSequential();
+
+        clear();
+        totalDocs = file.getTotalDocs();
+        compressedCodec = file.getCodec();
+        documents = file.getDocumentStats();
+        impactBits = file.getImpactBits();
+        impactScale = file.getImpactScale();
+        dictionary.reserve(file.getTermCount());
+        compressedTerms.reserve(file.getTermCount());
+        termIdf.reserve(file.getTermCount());
+
+        const uint64_t base = file.getPostingsOffset();
+        const size_t size = file.getPostingsSize();
+        compressedPostings.assign(file.getPostingsData(), file.getPostingsData() + size);
+
+        for (uint32_t termId = 0; termId < file.getTermCount(); ++termId)
         {
-            out << rank << "," << pair.first << "," << pair.second << "\n";
-            rank++;
+            const IndexTermEntry &entry = file.getEntry(termId);
+            if (entry.postingsOffset < base || entry.postingsOffset - base + entry.postingsSize > size)
+            {
+                clear();
+                return false;
+            }
+
+            dictionary.getOrAdd(file.getTerm(termId));
+            compressedTerms.push_back({entry.postingsOffset - base, entry.docFrequency, entry.postingsSize, entry.maxTf});
+            termIdf.push_back(file.getIdf(termId));
         }
 
-        out.close();
-        std::cout << "Zipf stats exported to " << filename << std::endl;
+        return true;
     }
 
-    void exportToBooleanIndex(const std::string &filename)
+    // termId в лексикографическом порядке терминов
+    std::vector<uint32_t> sortedTermIds() const
     {
-        std::ofstream out(filename, std::ios::binary);
-        if (!out.is_open())
-            return;
+        std::vector<uint32_t> ids(getTermCount());
+        for (uint32_t termId = 0; termId < ids.size(); ++termId)
+            ids[termId] = termId;
 
-        out.write(reinterpret_cast<const char *>(&totalDocs), sizeof(totalDocs));
+        std::sort(ids.begin(), ids.end(), [&](uint32_t a, uint32_t b)
+                  { return dictionary.term(a) < dictionary.term(b); });
+        return ids;
+    }
 
-        size_t termCount = index.size();
-        out.write(reinterpret_cast<const char *>(&termCount), sizeof(termCount));
+    // Частоты есть только в индексе с TF: в индексе вкладов постинги хранят уровни BM25,
+    // поэтому для него выгрузка отказывает (false). Частоты такого индекса выгружает
+    // IndexingPipeline::setFrequencyStatsFile - из промежуточного файла с TF
+    bool exportFrequencyStats(const std::string &filename)
+    {
+        if (hasImpacts())
+            return false;
 
-        index.traverse([&](const std::string &term, const PostingsList &postings)
-                       {
-            // 1. Пишем слово
-            size_t termLen = term.size();
-            out.write(reinterpret_cast<const char*>(&termLen), sizeof(termLen));
-            out.write(term.c_str(), termLen);
+        // 1. Собираем пары <Слово, ОбщаяЧастота>
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        stats.reserve(getTermCount());
 
-            // 2. Пишем список уникальных документов (без TF)
-            size_t docCount = postings.size();
-            out.write(reinterpret_cast<const char*>(&docCount), sizeof(docCount));
-            for (const auto &p : postings)
-            {
-                out.write(reinterpret_cast<const char*>(&p.docId), sizeof(p.docId));
-            } });
+        for (uint32_t termId = 0; termId < getTermCount(); ++termId)
+        {
+            stats.push_back({std::string(dictionary.term(termId)), collectionFrequency(openCursor(termId))});
+        }
 
-        out.close();
+        // 2. Пишем CSV: Rank,Term,Frequency
+        return writeFrequencyCsv(stats, filename);
+    }
+
+    // То же по файлу индекса, без загрузки постингов в память целиком
+    static bool exportFrequencyStatsFromFile(const std::string &indexFile, const std::string &filename)
+    {
+        MappedIndex index;
+        if (!index.open(indexFile, false) || index.hasImpacts())
+            return false;
+        index.adviseSequential();
+
+        std::vector<std::pair<std::string, uint64_t>> stats;
+        stats.reserve(index.getTermCount());
+
+        for (uint32_t termId = 0; termId < index.getTermCount(); ++termId)
+        {
+            stats.push_back({std::string(index.getTerm(termId)), collectionFrequency(index.openCursor(termId))});
+        }
+
+        return writeFrequencyCsv(stats, filename);
     }
 };
 
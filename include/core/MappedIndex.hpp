@@ -0,0 +1,130 @@
+#ifndef MAPPED_INDEX_HPP
+#define MAPPED_INDEX_HPP
+
+#include "IndexFormat.hpp"
+#include "Posting.hpp"
+#include "PostingCursor.hpp"
+#include "ImpactSegments.hpp"
+#include "DocumentStats.hpp"
+#include "DocIdIterator.hpp"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Индекс только для чтения поверх отображенного в память index.bin.
+// open() не читает файл целиком: проверяется только заголовок, а постинги
+// декодируются лишь для тех терминов, которые встретились в запросе.
+// Отображение разделяемое, поэтому несколько процессов поиска используют
+// одни и те же страницы кэша ОС. Для ранжирования open() дополнительно читает
+// длины документов (<индекс>.docs) и считает IDF всех терминов один раз.
+class MappedIndex
+{
+public:
+    static constexpr uint32_t kNoTerm = UINT32_MAX;
+
+private:
+    const uint8_t *data = nullptr;
+    size_t fileSize = 0;
+
+    const IndexFileHeader *header = nullptr;
+    const IndexTermEntry *entries = nullptr;
+    const char *termPool = nullptr;
+
+    DocumentStats documents;
+    std::vector<double> termIdf;
+
+public:
+    MappedIndex() = default;
+    ~MappedIndex();
+
+    MappedIndex(MappedIndex &&other) noexcept;
+    MappedIndex &operator=(MappedIndex &&other) noexcept;
+    MappedIndex(const MappedIndex &) = delete;
+    MappedIndex &operator=(const MappedIndex &) = delete;
+
+    // false, если файла нет или он в другом формате. withRankingStats = false -
+    // только постинги (слияние прогонов, загрузка в память): без .docs и IDF.
+    // Без файла .docs статистика пуста, и BM25 не нормирует по длине
+    bool open(const std::string &filename, bool withRankingStats = true);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    // Подсказка ОС, что файл будет читаться подряд (слияние, полная загрузка)
+    void adviseSequential() const;
+
+    size_t getTotalDocs() const { return header ? header->totalDocs : 0; }
+    size_t getTermCount() const { return header ? header->termCount : 0; }
+    BlockCodec getCodec() const { return header ? static_cast<BlockCodec>(header->codec) : BlockCodec::VarByte; }
+
+    // Индекс квантованных вкладов: tf() курсора - вклад в скор (см. IndexFormat.hpp)
+    bool hasImpacts() const { return getImpactBits() != 0; }
+    uint32_t getImpactBits() const { return header ? header->impactBits : 0; }
+    double getImpactScale() const { return header ? header->impactScale : 0.0; }
+
+    // Раскладка по вкладам: постинги читаются через openSegments, а не курсором
+    IndexLayout getLayout() const { return header ? static_cast<IndexLayout>(header->layout) : IndexLayout::DocumentOrdered; }
+    bool isImpactOrdered() const { return getLayout() == IndexLayout::ImpactOrdered; }
+
+    // Номер термина (позиция в отсортированном словаре) или kNoTerm; бинарный поиск
+    uint32_t getTermId(std::string_view term) const;
+
+    std::string_view getTerm(uint32_t termId) const
+    {
+        const IndexTermEntry &entry = entries[termId];
+        return std::string_view(termPool + entry.termOffset, entry.termLength);
+    }
+
+    uint32_t getDocFrequency(uint32_t termId) const { return entries[termId].docFrequency; }
+
+    // IDF термина для BM25, посчитанный при открытии (см. DocumentStats::idf)
+    double getIdf(uint32_t termId) const
+    {
+        return termId < termIdf.size() ? termIdf[termId] : DocumentStats::idf(getTotalDocs(), getDocFrequency(termId));
+    }
+
+    const DocumentStats &getDocumentStats() const { return documents; }
+
+    // Сырая область постингов и запись словаря (загрузка в память без распаковки)
+    size_t getPostingsOffset() const { return header->postingsOffset; }
+    const uint8_t *getPostingsData() const { return data + header->postingsOffset; }
+    size_t getPostingsSize() const { return header->termsOffset - header->postingsOffset; }
+    const IndexTermEntry &getEntry(uint32_t termId) const { return entries[termId]; }
+
+    // Курсор по сжатым постингам прямо в отображенном файле.
+    // В раскладке по вкладам курсор пуст
+    PostingCursor openCursor(uint32_t termId) const;
+
+    // Для булева поиска (BooleanPlanner, openBooleanIterator): df и документы термина без TF.
+    // В раскладке по вкладам курсоры пусты - булев поиск нужен по документам
+    size_t documentFrequency(std::string_view term) const
+    {
+        uint32_t termId = getTermId(term);
+        return termId == kNoTerm ? 0 : getDocFrequency(termId);
+    }
+
+    DocIdIteratorPtr openIterator(std::string_view term) const
+    {
+        uint32_t termId = getTermId(term);
+        return std::make_unique<PostingIterator>(termId == kNoTerm ? PostingCursor() : openCursor(termId));
+    }
+
+    // Сегменты вкладов термина; вне раскладки по вкладам - пусто
+    ImpactSegments openSegments(uint32_t termId) const;
+
+    // Распаковывает постинги термина в out (содержимое out заменяется)
+    void decodePostings(uint32_t termId, PostingsList &out) const;
+
+    // false, если термина нет
+    bool getPostings(std::string_view term, PostingsList &out) const
+    {
+        uint32_t termId = getTermId(term);
+        if (termId == kNoTerm)
+            return false;
+
+        decodePostings(termId, out);
+        return true;
+    }
+};
+
+#endif
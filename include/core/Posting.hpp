@@ -0,0 +1,17 @@
+#ifndef POSTING_HPP
+#define POSTING_HPP
+
+#include <vector>
+#include <cstdint>
+
+struct Posting
+{
+    uint32_t docId;
+    uint32_t termFrequency;
+    Posting(uint32_t id, uint32_t tf) : docId(id), termFrequency(tf) {}
+    Posting() : docId(0), termFrequency(0) {}
+};
+
+using PostingsList = std::vector<Posting>;
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef POSTING_CURSOR_HPP
+#define POSTING_CURSOR_HPP
+
+#include "Posting.hpp"
+#include "IndexFormat.hpp"
+#include "../utils/Compression.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Курсор по списку постингов одного термина: документы идут по возрастанию docId.
+// Умеет ходить как по распакованному списку (индекс, построенный в памяти),
+// так и прямо по сжатым данным в формате index.bin: там постинги распаковываются
+// поблочно (см. IndexFormat.hpp), а advance() перескакивает ненужные блоки по
+// таблице пропусков, вообще их не читая. Данные должны жить дольше курсора.
+// maxTf() и blockBound() дают верхние границы TF для динамического отсечения.
+//
+//   for (PostingCursor c = index.openCursor(termId); !c.atEnd(); c.next())
+//       use(c.docId(), c.tf());
+class PostingCursor
+{
+public:
+    // docId исчерпанного курсора: больше любого настоящего номера документа
+    static constexpr uint32_t kEndDoc = UINT32_MAX;
+
+    // Блок постингов, на который пришелся бы advance(target): его последний docId
+    // и наибольший TF. За концом списка - {kEndDoc - 1, 0}
+    struct BlockBound
+    {
+        uint32_t lastDocId;
+        uint32_t maxTf;
+    };
+
+private:
+    static constexpr uint32_t kUnknownMaxTf = UINT32_MAX;
+
+    const Posting *list = nullptr; // Распакованный список; nullptr - читаем сжатые блоки
+    uint32_t count = 0;
+    uint32_t position = 0; // Индекс в list или в текущем блоке
+
+    const uint8_t *skips = nullptr; // Таблица пропусков (нет у единственного блока)
+    const uint8_t *blocks = nullptr;
+    uint32_t blocksSize = 0;
+    uint32_t blockCount = 0;
+    uint32_t block = 0;
+    uint32_t blockLength = 0;
+    BlockCodec codec = BlockCodec::VarByte;
+    bool decodeTfs = true;
+
+    uint32_t currentDoc = kEndDoc;
+    uint32_t currentTf = 0;
+    uint32_t termMaxTf = 0; // У распакованного списка считается при первом запросе
+
+    // Текущий распакованный блок
+    uint32_t blockDocs[kPostingsBlockSize];
+    uint32_t blockTfs[kPostingsBlockSize];
+
+    IndexSkipEntry skipEntry(uint32_t index) const
+    {
+        IndexSkipEntry entry;
+        std::memcpy(&entry, skips + index * sizeof(IndexSkipEntry), sizeof(entry));
+        return entry;
+    }
+
+    uint32_t lastDocOfBlock(uint32_t index) const
+    {
+        return skips ? skipEntry(index).lastDocId : blockDocs[blockLength - 1];
+    }
+
+    void loadBlock(uint32_t index)
+    {
+        block = index;
+        position = 0;
+        if (index >= blockCount)
+        {
+            currentDoc = kEndDoc;
+            return;
+        }
+
+        size_t begin = 0;
+        size_t end = blocksSize;
+        uint32_t docId = 0;
+        if (skips)
+        {
+            if (index > 0)
+            {
+                IndexSkipEntry previous = skipEntry(index - 1);
+                begin = previous.endOffset;
+                docId = previous.lastDocId;
+            }
+            end = std::min<size_t>(skipEntry(index).endOffset, blocksSize);
+        }
+
+        blockLength = std::min<uint32_t>(kPostingsBlockSize, count - index * kPostingsBlockSize);
+        size_t pos = begin;
+        Compression::decodeBlock(codec, blocks, end, pos, blockDocs, blockLength);
+        for (uint32_t i = 0; i < blockLength; ++i)
+        {
+            docId += blockDocs[i];
+            blockDocs[i] = docId;
+        }
+        if (decodeTfs)
+            Compression::decodeBlock(codec, blocks, end, pos, blockTfs, blockLength);
+
+        currentDoc = blockDocs[0];
+        currentTf = blockTfs[0];
+    }
+
+public:
+    // Пустой курсор (термина нет)
+    PostingCursor() = default;
+
+    explicit PostingCursor(const PostingsList &postings)
+        : list(postings.data()), count(static_cast<uint32_t>(postings.size())), termMaxTf(kUnknownMaxTf)
+    {
+        if (count == 0)
+            return;
+        currentDoc = list[0].docId;
+        currentTf = list[0].termFrequency;
+    }
+
+    // Сжатые постинги термина: size байт (таблица пропусков и блоки)
+    PostingCursor(const uint8_t *data, uint32_t size, uint32_t docFrequency, BlockCodec blockCodec, uint32_t maxTf = 0)
+        : count(docFrequency), codec(blockCodec), termMaxTf(maxTf)
+    {
+        blockCount = (docFrequency + kPostingsBlockSize - 1) / kPostingsBlockSize;
+        size_t skipBytes = blockCount > 1 ? blockCount * sizeof(IndexSkipEntry) : 0;
+        if (skipBytes > size)
+        {
+            count = 0;
+            blockCount = 0;
+            return;
+        }
+
+        skips = skipBytes ? data : nullptr;
+        blocks = data + skipBytes;
+        blocksSize = static_cast<uint32_t>(size - skipBytes);
+        loadBlock(0);
+    }
+
+    bool atEnd() const { return currentDoc == kEndDoc; }
+    uint32_t docId() const { return currentDoc; }
+    uint32_t tf() const { return currentTf; }
+
+    // Для булева поиска: TF следующих сжатых блоков не распаковываются, tf() дальше не определен
+    void ignoreTermFrequencies() { decodeTfs = false; }
+
+    // Число документов в списке (document frequency)
+    uint32_t size() const { return count; }
+
+    // Наибольший TF термина
+    uint32_t maxTf()
+    {
+        if (termMaxTf == kUnknownMaxTf)
+        {
+            termMaxTf = 0;
+            for (uint32_t i = 0; i < count; ++i)
+                termMaxTf = std::max(termMaxTf, list[i].termFrequency);
+        }
+        return termMaxTf;
+    }
+
+    // Граница блока с первым документом >= target. Курсор не двигается и блок не
+    // распаковывается: по таблице пропусков Block-Max WAND отбрасывает целые блоки.
+    // У распакованного списка блоки те же kPostingsBlockSize постингов, что и в файле
+    BlockBound blockBound(uint32_t target)
+    {
+        constexpr BlockBound kPastEnd{kEndDoc - 1, 0};
+        if (atEnd())
+            return kPastEnd;
+
+        if (list)
+        {
+            const Posting *found = std::lower_bound(list + position, list + count, target,
+                                                    [](const Posting &p, uint32_t id)
+                                                    { return p.docId < id; });
+            uint32_t index = static_cast<uint32_t>(found - list);
+            if (index == count)
+                return kPastEnd;
+
+            uint32_t begin = index - index % kPostingsBlockSize;
+            uint32_t end = std::min(count, begin + kPostingsBlockSize);
+            BlockBound bound{list[end - 1].docId, 0};
+            for (uint32_t i = begin; i < end; ++i)
+                bound.maxTf = std::max(bound.maxTf, list[i].termFrequency);
+            return bound;
+        }
+
+        if (!skips)
+            return lastDocOfBlock(block) < target ? kPastEnd : BlockBound{lastDocOfBlock(block), termMaxTf};
+
+        // Обычно target лежит в текущем или одном из ближайших блоков
+        uint32_t low = block;
+        uint32_t high = blockCount;
+        for (uint32_t step = 1; low < high && skipEntry(low).lastDocId < target; step *= 2)
+        {
+            if (low + step >= high || skipEntry(low + step).lastDocId >= target)
+            {
+                high = std::min(high, low + step);
+                low = low + 1;
+                break;
+            }
+            low += step;
+        }
+        while (low < high)
+        {
+            uint32_t middle = low + (high - low) / 2;
+            if (skipEntry(middle).lastDocId < target)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low == blockCount)
+            return kPastEnd;
+
+        IndexSkipEntry entry = skipEntry(low);
+        return {entry.lastDocId, entry.maxTf};
+    }
+
+    void next()
+    {
+        if (list)
+        {
+            if (++position < count)
+            {
+                currentDoc = list[position].docId;
+                currentTf = list[position].termFrequency;
+            }
+            else
+            {
+                position = count;
+                currentDoc = kEndDoc;
+            }
+            return;
+        }
+
+        if (atEnd())
+            return;
+
+        if (++position < blockLength)
+        {
+            currentDoc = blockDocs[position];
+            currentTf = blockTfs[position];
+        }
+        else
+        {
+            loadBlock(block + 1);
+        }
+    }
+
+    // Переходит к первому документу с docId >= target (назад не ходит)
+    void advance(uint32_t target)
+    {
+        if (currentDoc >= target)
+            return;
+
+        if (list)
+        {
+            const Posting *found = std::lower_bound(list + position, list + count, target,
+                                                    [](const Posting &p, uint32_t id)
+                                                    { return p.docId < id; });
+            position = static_cast<uint32_t>(found - list);
+            if (position < count)
+            {
+                currentDoc = found->docId;
+                currentTf = found->termFrequency;
+            }
+            else
+            {
+                currentDoc = kEndDoc;
+            }
+            return;
+        }
+
+        // Пропускаем блоки, целиком лежащие левее target, не распаковывая их
+        if (lastDocOfBlock(block) < target)
+        {
+            // Бинарный поиск первого блока с lastDocId >= target
+            uint32_t low = block + 1;
+            uint32_t high = blockCount;
+            while (low < high)
+            {
+                uint32_t middle = low + (high - low) / 2;
+                if (skipEntry(middle).lastDocId < target)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            loadBlock(low);
+            if (atEnd())
+                return;
+        }
+
+        const uint32_t *found = std::lower_bound(blockDocs + position, blockDocs + blockLength, target);
+        position = static_cast<uint32_t>(found - blockDocs);
+        currentDoc = blockDocs[position];
+        currentTf = blockTfs[position];
+    }
+};
+
+#endif
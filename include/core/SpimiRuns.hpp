@@ -0,0 +1,173 @@
+#ifndef SPIMI_RUNS_HPP
+#define SPIMI_RUNS_HPP
+
+#include "InvertedIndex.hpp"
+#include "IndexFile.hpp"
+#include <vector>
+#include <string>
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+#include <algorithm>
+
+// Построение индекса с ограниченной памятью (SPIMI):
+// как только индекс в памяти превышает бюджет, он сбрасывается на диск
+// отсортированным по терминам "прогоном" и очищается. В конце все прогоны
+// сливаются k-way слиянием в итоговый файл; в памяти в каждый момент
+// находится только по одному термину из каждого прогона.
+class SpimiRuns
+{
+private:
+    std::filesystem::path directory;
+    std::vector<std::string> runFiles;
+    std::mutex mutex;
+    std::atomic<bool> failed{false}; // Какой-то прогон не записан: его документы потеряны
+
+    struct RunCursor
+    {
+        IndexFileReader reader;
+        std::string term;
+        PostingsList postings;
+        bool valid = false;
+
+        void advance() { valid = reader.next(term, postings); }
+    };
+
+    void removeRuns()
+    {
+        for (const auto &file : runFiles)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(file, ignored);
+            std::filesystem::remove(DocumentStats::pathFor(file), ignored);
+        }
+        runFiles.clear();
+    }
+
+public:
+    explicit SpimiRuns(const std::string &runDirectory) : directory(runDirectory)
+    {
+        std::filesystem::create_directories(directory);
+    }
+
+    ~SpimiRuns() { removeRuns(); }
+
+    SpimiRuns(const SpimiRuns &) = delete;
+    SpimiRuns &operator=(const SpimiRuns &) = delete;
+
+    // Записывает индекс очередным прогоном и очищает его (потокобезопасно).
+    // После неудачной записи mergeInto тоже вернет false
+    bool flush(InvertedIndex &index)
+    {
+        if (index.getTermCount() == 0 && index.getTotalDocs() == 0)
+            return true;
+
+        std::string filename;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            filename = (directory / ("run-" + std::to_string(runFiles.size()) + ".bin")).string();
+            runFiles.push_back(filename);
+        }
+
+        bool ok = index.save(filename);
+        index.clear();
+        if (!ok)
+            failed = true;
+        return ok;
+    }
+
+    size_t runCount() const { return runFiles.size(); }
+
+    // Сливает все прогоны в outputFile (формат index.bin, кодек codec) и удаляет их.
+    // Длины документов прогонов складываются в DocumentStats::pathFor(outputFile)
+    bool mergeInto(const std::string &outputFile, BlockCodec codec = BlockCodec::VarByte)
+    {
+        if (failed)
+        {
+            removeRuns();
+            return false;
+        }
+
+        std::vector<RunCursor> runs(runFiles.size());
+        size_t totalDocs = 0;
+        DocumentStats documents;
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            if (!runs[i].reader.open(runFiles[i]))
+                return false;
+            totalDocs += runs[i].reader.getTotalDocs();
+            runs[i].advance();
+
+            // Без длин документов прогона BM25 слитого индекса был бы неверным
+            DocumentStats runDocuments;
+            if (!runDocuments.load(DocumentStats::pathFor(runFiles[i])))
+                return false;
+            documents.merge(runDocuments);
+        }
+
+        IndexFileWriter writer;
+        if (!writer.open(outputFile, totalDocs, codec))
+            return false;
+
+        // Куча прогонов по текущему термину (наименьший сверху)
+        auto greater = [&](size_t a, size_t b)
+        { return runs[a].term > runs[b].term; };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            if (runs[i].valid)
+                heap.push(i);
+        }
+
+        std::vector<size_t> sameTerm;
+        PostingsList merged;
+        while (!heap.empty())
+        {
+            // Все прогоны, в которых встречается наименьший термин
+            sameTerm.clear();
+            sameTerm.push_back(heap.top());
+            heap.pop();
+            while (!heap.empty() && runs[heap.top()].term == runs[sameTerm[0]].term)
+            {
+                sameTerm.push_back(heap.top());
+                heap.pop();
+            }
+
+            const std::string &term = runs[sameTerm[0]].term;
+            if (sameTerm.size() == 1)
+            {
+                writer.writeTerm(term, runs[sameTerm[0]].postings);
+            }
+            else
+            {
+                // Документы разных прогонов не пересекаются, но их docId могут чередоваться
+                merged.clear();
+                for (size_t run : sameTerm)
+                {
+                    size_t middle = merged.size();
+                    const PostingsList &part = runs[run].postings;
+                    merged.insert(merged.end(), part.begin(), part.end());
+                    std::inplace_merge(merged.begin(), merged.begin() + middle, merged.end(),
+                                       [](const Posting &a, const Posting &b)
+                                       { return a.docId < b.docId; });
+                }
+                writer.writeTerm(term, merged);
+            }
+
+            for (size_t run : sameTerm)
+            {
+                runs[run].advance();
+                if (runs[run].valid)
+                    heap.push(run);
+            }
+        }
+
+        bool ok = writer.close() && documents.save(DocumentStats::pathFor(outputFile));
+        runs.clear();
+        removeRuns();
+        return ok;
+    }
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef TERM_DICTIONARY_HPP
+#define TERM_DICTIONARY_HPP
+
+#include "HashMap.hpp"
+#include <vector>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+
+// Словарь терминов: каждая лемма хранится один раз в общей "арене" (крупные блоки памяти),
+// а наружу выдаются плотные номера 0, 1, 2, ... в порядке первого появления.
+// Строки в арене никогда не перемещаются, поэтому std::string_view на них остаются валидными.
+class TermDictionary
+{
+public:
+    static constexpr uint32_t kNoTerm = UINT32_MAX;
+
+private:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockUsed = kBlockSize; // Сколько занято в последнем блоке
+    size_t arenaBytes = 0;
+
+    std::vector<std::string_view> terms; // termId -> текст термина
+    HashMap<std::string_view, uint32_t> ids;
+
+    // Копирует строку в арену. Пустой строке место не нужно (и блоков может еще не быть)
+    std::string_view store(std::string_view term)
+    {
+        if (term.empty())
+            return std::string_view();
+
+        char *dest;
+        if (term.size() > kBlockSize)
+        {
+            // Слишком длинное слово - отдельный блок
+            blocks.push_back(std::make_unique<char[]>(term.size()));
+            dest = blocks.back().get();
+            blockUsed = kBlockSize;
+            arenaBytes += term.size();
+        }
+        else
+        {
+            if (blockUsed + term.size() > kBlockSize)
+            {
+                blocks.push_back(std::make_unique<char[]>(kBlockSize));
+                blockUsed = 0;
+                arenaBytes += kBlockSize;
+            }
+            dest = blocks.back().get() + blockUsed;
+            blockUsed += term.size();
+        }
+
+        std::memcpy(dest, term.data(), term.size());
+        return std::string_view(dest, term.size());
+    }
+
+public:
+    TermDictionary() = default;
+    TermDictionary(TermDictionary &&) = default;
+    TermDictionary &operator=(TermDictionary &&) = default;
+
+    // Копия указывала бы в чужую арену
+    TermDictionary(const TermDictionary &) = delete;
+    TermDictionary &operator=(const TermDictionary &) = delete;
+
+    // Номер термина или kNoTerm, если его нет
+    uint32_t find(std::string_view term) const
+    {
+        const uint32_t *id = ids.get(term);
+        return id ? *id : kNoTerm;
+    }
+
+    // Номер термина; новый термин копируется в арену и получает следующий номер
+    uint32_t getOrAdd(std::string_view term)
+    {
+        if (const uint32_t *id = ids.get(term))
+            return *id;
+
+        // Ключом в таблице становится копия из арены, а не строка вызывающего
+        uint32_t id = static_cast<uint32_t>(terms.size());
+        terms.push_back(store(term));
+        ids.try_emplace(terms.back(), id);
+        return id;
+    }
+
+    std::string_view term(uint32_t termId) const { return terms[termId]; }
+
+    size_t size() const { return terms.size(); }
+
+    void reserve(size_t expectedTerms)
+    {
+        terms.reserve(expectedTerms);
+        ids.reserve(expectedTerms);
+    }
+
+    // Приблизительный объем памяти словаря в байтах
+    size_t memoryUsage() const
+    {
+        return arenaBytes + terms.capacity() * sizeof(std::string_view) +
+               ids.memoryUsage();
+    }
+
+    void clear()
+    {
+        blocks.clear();
+        blockUsed = kBlockSize;
+        arenaBytes = 0;
+        terms.clear();
+        ids.clear();
+    }
+};
+
+#endif
@@ -36,7 +36,8 @@ public:
     MongoConnector(const std::string &uri, const std::string &db, const std::string &coll);
     ~MongoConnector();
 
-    void processAllDocuments(std::function<void(const RawDocument &)> callback);
+    // Колбэк может забрать поля документа через std::move (например, чтобы отдать html в очередь)
+    void processAllDocuments(std::function<void(RawDocument &)> callback);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef INDEXING_PIPELINE_HPP
+#define INDEXING_PIPELINE_HPP
+
+#include "../core/InvertedIndex.hpp"
+#include "../ranking/ScoringModel.hpp"
+#include "../db/MongoConnector.hpp"
+#include <vector>
+#include <string>
+#include <functional>
+
+class SpimiRuns;
+
+// Параллельная индексация:
+//   производитель (вызывающий поток) читает документы из источника
+//   -> ограниченная очередь ->
+//   N рабочих потоков: HTML -> текст -> токены -> леммы -> локальный InvertedIndex
+//   -> в конце локальные индексы сливаются в один.
+// У каждого рабочего свой Lemmatizer (sb_stemmer не потокобезопасен).
+//
+// С бюджетом памяти (setMemoryBudget) локальные индексы сбрасываются на диск
+// прогонами SPIMI, а итоговый файл собирается слиянием прогонов.
+class IndexingPipeline
+{
+public:
+    // Источник документов: вызывает переданный колбэк для каждого документа по порядку id
+    using DocumentSource = std::function<void(const std::function<void(RawDocument &)> &)>;
+
+private:
+    size_t threadCount;
+    size_t queueCapacity;
+    size_t memoryBudget = 0; // 0 - без ограничения
+    std::string runDirectory;
+    BlockCodec codec = BlockCodec::VarByte;
+    uint32_t impactBits = 0;
+    Bm25Scoring impactScoring;
+    IndexLayout impactLayout = IndexLayout::DocumentOrdered;
+    std::string frequencyStatsFile;
+
+    // runs == nullptr - локальные индексы копятся в памяти целиком
+    std::vector<InvertedIndex> runWorkers(const DocumentSource &source, std::vector<std::string> &docUrls,
+                                          SpimiRuns *runs);
+
+    // Индекс с TF: целиком из памяти или слиянием прогонов
+    bool writeTfIndex(const DocumentSource &source, std::vector<std::string> &docUrls, const std::string &indexFile);
+
+    // Частоты слов из файла с TF в frequencyStatsFile, если он задан
+    void exportFrequencyStats(const std::string &tfFile) const;
+
+public:
+    explicit IndexingPipeline(size_t threads, size_t queueCapacity = 0);
+
+    // Общий бюджет памяти индекса на все потоки; временные прогоны пишутся в runDirectory
+    void setMemoryBudget(size_t bytes, const std::string &runDirectory);
+
+    // Кодек постингов итогового файла (временные прогоны всегда VarByte)
+    void setCodec(BlockCodec codec);
+
+    // bits > 0 - итоговый файл хранит квантованные вклады BM25 вместо TF
+    // с параметрами scoring (см. ranking/ImpactIndex.hpp); 0 - обычный индекс с TF.
+    // layout = ImpactOrdered - постинги по сегментам вклада для AnytimeScorer
+    void setImpactBits(uint32_t bits, const Bm25Scoring &scoring = Bm25Scoring(),
+                       IndexLayout layout = IndexLayout::DocumentOrdered);
+
+    // runToFile выгрузит частоты слов (CSV для закона Ципфа) в csvFile. Берутся из индекса
+    // с TF до перевода во вклады: файл вкладов частот уже не хранит
+    void setFrequencyStatsFile(const std::string &csvFile);
+
+    // Индексирует все документы источника в память. docUrls[doc.id] заполняется для каждого документа.
+    InvertedIndex run(const DocumentSource &source, std::vector<std::string> &docUrls);
+
+    // Индексирует все документы источника сразу в файл индекса (с учетом бюджета памяти).
+    // Возвращает false при ошибке записи.
+    bool runToFile(const DocumentSource &source, std::vector<std::string> &docUrls, const std::string &indexFile);
+};
+
+#endif
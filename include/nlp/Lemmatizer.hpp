@@ -2,6 +2,7 @@
 #define LEMMATIZER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include "libstemmer.h"
 
@@ -24,11 +25,18 @@ public:
     }
 
     std::string lemmatize(const std::string &word)
+    {
+        return std::string(stem(word));
+    }
+
+    // Лемма без копирования: указывает во внутренний буфер стеммера
+    // и действительна только до следующего вызова
+    std::string_view stem(std::string_view word)
     {
         const sb_symbol *stemmed = sb_stemmer_stem(stemmer,
-                                                   reinterpret_cast<const sb_symbol *>(word.c_str()),
-                                                   word.length());
-        return std::string(reinterpret_cast<const char *>(stemmed));
+                                                   reinterpret_cast<const sb_symbol *>(word.data()),
+                                                   static_cast<int>(word.size()));
+        return std::string_view(reinterpret_cast<const char *>(stemmed), sb_stemmer_length(stemmer));
     }
 };
 
@@ -6,8 +6,8 @@
 #include <stack>
 #include <sstream>
 #include <algorithm>
-#include <set>
-#include "../core/BooleanIndex.hpp"
+#include "../core/DocIdIterator.hpp"
+#include "../core/BooleanQuery.hpp"
 #include "Lemmatizer.hpp"
 #include "Tokenizer.hpp"
 
@@ -69,57 +69,12 @@ private:
         return false;
     }
 
-    // Булевы операции над списками ID
-    std::vector<uint32_t> opAND(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
-    {
-        std::vector<uint32_t> res;
-        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(res));
-        return res;
-    }
-
-    std::vector<uint32_t> opOR(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
-    {
-        std::vector<uint32_t> res;
-        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(res));
-        return res;
-    }
-
-    std::vector<uint32_t> opNOT(const std::vector<uint32_t> &a, size_t totalDocs)
-    {
-        std::vector<uint32_t> res;
-        res.reserve(totalDocs - a.size());
-        size_t a_idx = 0;
-        for (uint32_t docId = 0; docId < totalDocs; ++docId)
-        {
-            if (a_idx < a.size() && a[a_idx] == docId)
-            {
-                a_idx++;
-            }
-            else
-            {
-                res.push_back(docId);
-            }
-        }
-        return res;
-    }
-
-public:
-    QueryParser(Lemmatizer &lemm) : lemmatizer(lemm) {}
-
-    std::vector<std::string> parseTerms(const std::string &query)
-    {
-        std::vector<std::string> cleanTerms;
-        std::vector<std::string> rawTokens = Tokenizer::tokenize(query);
-        for (const auto &t : rawTokens)
-        {
-            std::string lemma = lemmatizer.lemmatize(t);
-            if (!lemma.empty())
-                cleanTerms.push_back(lemma);
-        }
-        return cleanTerms;
-    }
+    static bool startsOperand(TokenType type) { return type == WORD || type == NOT || type == LPAREN; }
+    static bool endsOperand(TokenType type) { return type == WORD || type == RPAREN; }
 
-    std::vector<uint32_t> parseBoolean(const std::string &query, BooleanIndex &index)
+    // Токены запроса в инфиксной записи: операторы без операнда отброшены, между
+    // соседними операндами вставлен неявный AND
+    std::vector<Token> tokenize(const std::string &query)
     {
         std::vector<Token> tokens;
 
@@ -158,6 +113,48 @@ public:
             }
         }
 
+        // Оператор без операнда справа отбрасывается, а не применяется к соседнему слову:
+        // "путин!" - это "путин", а не "!путин". Идем с конца, помня, начинается ли
+        // за токеном операнд
+        std::vector<Token> kept;
+        bool operandFollows = false;
+        for (size_t i = tokens.size(); i-- > 0;)
+        {
+            const Token &token = tokens[i];
+            if (token.type == NOT || token.type == AND || token.type == OR)
+            {
+                if (!operandFollows)
+                    continue;
+                operandFollows = token.type == NOT;
+            }
+            else if (token.type != LPAREN)
+            {
+                operandFollows = token.type == WORD;
+            }
+            kept.push_back(token);
+        }
+        std::reverse(kept.begin(), kept.end());
+
+        // Бинарный оператор без операнда слева тоже отбрасывается; между соседними
+        // операндами - неявный AND: "путин !санкции" = "путин & !санкции"
+        std::vector<Token> explicitTokens;
+        for (const auto &token : kept)
+        {
+            bool hasLeft = !explicitTokens.empty() && endsOperand(explicitTokens.back().type);
+            if ((token.type == AND || token.type == OR) && !hasLeft)
+                continue;
+            if (startsOperand(token.type) && hasLeft)
+                explicitTokens.push_back({"", AND, 2}); // Пустое значение - неявный
+            explicitTokens.push_back(token);
+        }
+        return explicitTokens;
+    }
+
+    // Булев запрос в обратной польской записи (shunting-yard)
+    std::vector<Token> toRpn(const std::string &query)
+    {
+        std::vector<Token> tokens = tokenize(query);
+
         // Shunting-yard (Infix -> RPN)
         std::vector<Token> rpn;
         std::stack<Token> opStack;
@@ -195,43 +192,97 @@ public:
             opStack.pop();
         }
 
-        // Вычисление RPN
-        std::stack<std::vector<uint32_t>> evalStack;
+        return rpn;
+    }
 
-        for (const auto &token : rpn)
+public:
+    QueryParser(Lemmatizer &lemm) : lemmatizer(lemm) {}
+
+    std::vector<std::string> parseTerms(const std::string &query)
+    {
+        std::vector<std::string> cleanTerms;
+        std::vector<std::string> rawTokens = Tokenizer::tokenize(query);
+        for (const auto &t : rawTokens)
+        {
+            std::string lemma = lemmatizer.lemmatize(t);
+            if (!lemma.empty())
+                cleanTerms.push_back(lemma);
+        }
+        return cleanTerms;
+    }
+
+    // Есть ли в запросе настоящий оператор-символ: & или | между операндами либо !
+    // перед операндом. Ранжированный поиск по таким запросам сначала фильтрует булевым
+    // выражением. Скобки без операторов ("Сбербанк (SBER) отчитался"), висящий "!"
+    // и словесные И/ИЛИ/НЕ в обычном запросе режим не меняют
+    bool hasBooleanOperators(const std::string &query)
+    {
+        for (const auto &token : tokenize(query))
+        {
+            if ((token.type == AND || token.type == OR || token.type == NOT) &&
+                (token.value == "&" || token.value == "&&" || token.value == "|" || token.value == "!"))
+                return true;
+        }
+        return false;
+    }
+
+    // Дерево запроса как записано. Лишние операторы без операндов пропускаются; если
+    // операндов осталось несколько, результат - последний
+    BooleanNode parseBooleanQuery(const std::string &query)
+    {
+        std::vector<BooleanNode> evalStack;
+
+        for (const auto &token : toRpn(query))
         {
             if (token.type == WORD)
             {
-                std::vector<uint32_t> docs;
-                auto ptr = index.getDocIds(token.value);
-                if (ptr)
-                    docs = *ptr; // Копируем список ID
-                evalStack.push(docs);
+                evalStack.push_back(BooleanNode::makeTerm(token.value));
             }
             else if (token.type == NOT)
             {
                 if (evalStack.empty())
                     continue;
-                auto a = evalStack.top();
-                evalStack.pop();
-                evalStack.push(opNOT(a, index.getTotalDocs()));
+                evalStack.back() = BooleanNode::makeNot(std::move(evalStack.back()));
             }
             else
             { // AND, OR
                 if (evalStack.size() < 2)
                     continue;
-                auto b = evalStack.top();
-                evalStack.pop();
-                auto a = evalStack.top();
-                evalStack.pop();
+                BooleanNode right = std::move(evalStack.back());
+                evalStack.pop_back();
                 if (token.type == AND)
-                    evalStack.push(opAND(a, b));
+                    evalStack.back() = BooleanNode::makeAnd(std::move(evalStack.back()), std::move(right));
                 else
-                    evalStack.push(opOR(a, b));
+                    evalStack.back() = BooleanNode::makeOr(std::move(evalStack.back()), std::move(right));
             }
         }
 
-        return evalStack.empty() ? std::vector<uint32_t>{} : evalStack.top();
+        if (evalStack.empty())
+            return BooleanNode();
+        return std::move(evalStack.back());
+    }
+
+    // План выполнения: переписывания и порядок операндов по df из индекса (BooleanPlanner).
+    // Index - InvertedIndex или MappedIndex
+    template <typename Index>
+    BooleanNode planBoolean(const std::string &query, const Index &index)
+    {
+        return BooleanPlanner::plan(parseBooleanQuery(query), index);
+    }
+
+    // Ленивое дерево итераторов по плану: постинги читаются на месте, в том числе
+    // сжатые блоки index.bin
+    template <typename Index>
+    DocIdIteratorPtr compileBoolean(const std::string &query, const Index &index)
+    {
+        return openBooleanIterator(planBoolean(query, index), index);
+    }
+
+    // Все документы булева запроса по возрастанию docId
+    template <typename Index>
+    std::vector<uint32_t> parseBoolean(const std::string &query, const Index &index)
+    {
+        return collectDocIds(*compileBoolean(query, index));
     }
 };
 
@@ -0,0 +1,84 @@
+#ifndef DOC_ID_FILTER_HPP
+#define DOC_ID_FILTER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Разрешенные документы для Scorer: отсортированный список docId и битовая карта
+// над ним. Проверка документа - один бит, без бинарного поиска по списку на каждый
+// постинг; переход к следующему разрешенному - галопом по списку от прошлой позиции.
+// Когда разрешенных мало по сравнению с постингами, Scorer идет по ним и перескакивает
+// целые блоки постингов, иначе читает постинги подряд и проверяет биты.
+// Строится один раз на запрос; assign() переиспользует память фильтра.
+class DocIdFilter
+{
+public:
+    // docId за концом списка
+    static constexpr uint32_t kEnd = UINT32_MAX;
+
+private:
+    std::vector<uint32_t> ids;
+    std::vector<uint64_t> bits; // Бит docId; слов - до последнего разрешенного
+
+public:
+    DocIdFilter() = default;
+
+    // docIds - по возрастанию
+    explicit DocIdFilter(const std::vector<uint32_t> &docIds) { assign(docIds.data(), docIds.size()); }
+
+    void assign(const uint32_t *docIds, size_t count)
+    {
+        // Обнуляем только слова прежних документов: карта не очищается целиком
+        for (uint32_t docId : ids)
+            bits[docId >> 6] = 0;
+
+        ids.assign(docIds, docIds + count);
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        if (ids.empty())
+            return;
+
+        size_t words = (static_cast<size_t>(ids.back()) >> 6) + 1;
+        if (words > bits.size())
+            bits.resize(words, 0);
+        for (uint32_t docId : ids)
+            bits[docId >> 6] |= uint64_t(1) << (docId & 63);
+    }
+
+    bool contains(uint32_t docId) const
+    {
+        size_t word = docId >> 6;
+        return word < bits.size() && (bits[word] >> (docId & 63)) & 1;
+    }
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    const std::vector<uint32_t> &docIds() const { return ids; }
+
+    // docId на позиции position списка; kEnd за концом
+    uint32_t at(size_t position) const { return position < ids.size() ? ids[position] : kEnd; }
+
+    // Позиция первого docId >= target, не раньше position. Обход идет вперед,
+    // и нужный docId обычно рядом: галоп, затем бинарный поиск в найденном окне
+    size_t seek(uint32_t target, size_t position) const
+    {
+        size_t low = position;
+        size_t high = ids.size();
+        for (size_t step = 1; low < high && ids[low] < target; step *= 2)
+        {
+            if (low + step >= high || ids[low + step] >= target)
+            {
+                high = std::min(high, low + step);
+                low = low + 1;
+                break;
+            }
+            low += step;
+        }
+        return std::lower_bound(ids.begin() + low, ids.begin() + high, target) - ids.begin();
+    }
+
+    size_t memoryUsage() const { return ids.capacity() * sizeof(uint32_t) + bits.capacity() * sizeof(uint64_t); }
+};
+
+#endif
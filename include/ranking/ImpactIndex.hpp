@@ -0,0 +1,35 @@
+#ifndef IMPACT_INDEX_HPP
+#define IMPACT_INDEX_HPP
+
+#include "ScoringModel.hpp"
+#include "../core/IndexFormat.hpp"
+#include "../utils/Compression.hpp"
+#include <string>
+#include <cstdint>
+
+// Индекс квантованных вкладов: вместо TF каждый постинг хранит свой вклад BM25,
+// округленный до целого от 1 до 2^bits - 1. Квант общий для всего индекса:
+// наибольшая возможная оценка вклада (maxScore по maxTf термина) делится на
+// 2^bits - 1. Запросы к такому индексу - ImpactScoring: сложение целых без
+// IDF и длин документов. Чем меньше bits, тем меньше файл и тем чаще равные
+// скоры путают порядок выдачи; расхождение с точным BM25 показывает
+// benchmarks/ImpactDivergence.
+//
+// Вклад зависит от N, df и средней длины документа всей коллекции, поэтому
+// строится вторым проходом по уже готовому индексу с TF (после слияния SPIMI).
+// В раскладке по вкладам (IndexLayout::ImpactOrdered) индекс предназначен для
+// подсчета score-at-a-time с бюджетом (AnytimeScorer в Scorer.hpp).
+class ImpactIndex
+{
+public:
+    static constexpr uint32_t kMinBits = 1;
+    static constexpr uint32_t kMaxBits = 16;
+
+    // Переписывает индекс с TF sourceFile в индекс вкладов targetFile (вместе с .docs).
+    // false при ошибке чтения/записи, недопустимом bits или если sourceFile уже с вкладами
+    static bool build(const std::string &sourceFile, const std::string &targetFile, uint32_t bits,
+                      BlockCodec codec = BlockCodec::VarByte, const Bm25Scoring &scoring = Bm25Scoring(),
+                      IndexLayout layout = IndexLayout::DocumentOrdered);
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef SCORE_ACCUMULATOR_HPP
+#define SCORE_ACCUMULATOR_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Плотный массив скоров по docId для подсчета "термин за термином".
+// docId идут подряд 0..totalDocs-1, поэтому вместо хеш-таблицы хватает массива.
+// Чтобы не обнулять его перед каждым запросом, у ячейки есть метка эпохи:
+// ячейка с чужой меткой считается пустой. Номера затронутых документов копятся
+// в touched - по ним результат собирается без прохода по всему массиву.
+// Score - double или float (вдвое меньше памяти, чуть ниже точность).
+template <typename Score>
+class ScoreAccumulator
+{
+private:
+    struct Cell
+    {
+        Score score;
+        uint32_t epoch; // Рядом со скором: одна кеш-линия на документ
+    };
+
+    std::vector<Cell> cells;
+    std::vector<uint32_t> touched;
+    uint32_t epoch = 0;
+    size_t range = 0; // Документы текущего запроса: 0..range-1
+
+    void grow(size_t docCount)
+    {
+        cells.resize(std::max(docCount, cells.size() * 2), Cell{Score(), 0});
+    }
+
+public:
+    // Начинает новый запрос по документам 0..docCount-1. O(1), если массив уже нужного размера
+    void reset(size_t docCount)
+    {
+        if (docCount > cells.size())
+            grow(docCount);
+
+        range = docCount;
+        touched.clear();
+        if (++epoch == 0)
+        {
+            // Счетчик эпох переполнился: один раз честно очищаем метки
+            for (auto &cell : cells)
+                cell.epoch = 0;
+            epoch = 1;
+        }
+    }
+
+    void add(uint32_t docId, Score score)
+    {
+        if (docId >= range)
+        {
+            range = static_cast<size_t>(docId) + 1;
+            if (range > cells.size())
+                grow(range);
+        }
+
+        Cell &cell = cells[docId];
+        if (cell.epoch != epoch)
+        {
+            cell.epoch = epoch;
+            cell.score = score;
+            touched.push_back(docId);
+        }
+        else
+        {
+            cell.score += score;
+        }
+    }
+
+    // Число документов с ненулевым вкладом за текущий запрос
+    size_t size() const { return touched.size(); }
+
+    // visit(docId, score) для каждого затронутого документа, в порядке первого касания
+    template <typename F>
+    void traverse(F &&visit) const
+    {
+        for (uint32_t docId : touched)
+            visit(docId, cells[docId].score);
+    }
+
+    // То же, но по возрастанию docId. Если затронута заметная часть документов,
+    // дешевле пройти массив подряд, чем сортировать touched
+    template <typename F>
+    void traverseInDocOrder(F &&visit)
+    {
+        if (touched.size() * 16 >= range)
+        {
+            for (size_t docId = 0; docId < range; ++docId)
+            {
+                if (cells[docId].epoch == epoch)
+                    visit(static_cast<uint32_t>(docId), cells[docId].score);
+            }
+            return;
+        }
+
+        std::sort(touched.begin(), touched.end());
+        traverse(visit);
+    }
+
+    size_t memoryUsage() const
+    {
+        return cells.capacity() * sizeof(Cell) + touched.capacity() * sizeof(uint32_t);
+    }
+};
+
+#endif
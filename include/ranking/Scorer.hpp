@@ -2,6 +2,10 @@
 #define SCORER_HPP
 
 #include "../core/InvertedIndex.hpp"
+#include "../core/MappedIndex.hpp"
+#include "../core/DocIdIterator.hpp"
+#include "ScoringModel.hpp"
+#include "DocIdFilter.hpp"
 #include <vector>
 #include <cmath>
 #include <algorithm>
@@ -12,13 +16,156 @@ struct SearchResult
     double score;
 };
 
-class Scorer
+// Порядок обхода постингов. Результат у всех стратегий одинаковый, отличается
+// только число просмотренных постингов
+enum class QueryStrategy
+{
+    Exhaustive,   // Термин за термином: каждый постинг каждого слова запроса
+    Wand,         // Документ за документом, пропуская документы, которые по
+                  // максимальным TF терминов не проходят в top-k
+    BlockMaxWand, // То же, плюс границы по блокам постингов: отбрасываются целые блоки
+    MaxScore,     // Кандидаты только из списков весомых слов, остальные списки
+                  // проверяются точечно, пока документ может попасть в top-k
+};
+
+struct SearchStats
+{
+    size_t postingsScored = 0; // Постинги, вклад которых реально посчитан
+    bool budgetExhausted = false; // AnytimeScorer остановился по бюджету, не дойдя до конца
+    bool conjunctiveFallback = false; // searchConjunctive: документов со всеми словами меньше topK, выдача OR
+};
+
+// Бюджет запроса AnytimeScorer; 0 - без ограничения
+struct AnytimeBudget
+{
+    size_t maxPostings = 0;     // Сколько постингов прибавить к скорам, не больше
+    double maxMilliseconds = 0; // Сколько времени обходить сегменты (сбор top-k - сверх него)
+};
+
+// Ранжирование запроса по модели Scoring (TfIdfScoring, Bm25Scoring, ImpactScoring -
+// см. ScoringModel.hpp). Модель должна подходить индексу: ImpactScoring ищет только
+// в индексе квантованных вкладов (ImpactIndex), остальные - только в индексе с TF;
+// при несовпадении результат пуст.
+// Модель - параметр шаблона, поэтому подсчет скора встраивается в цикл по постингам.
+// Реализация инстанцирована в Scorer.cpp для всех моделей.
+template <typename Scoring>
+class BasicScorer
 {
 public:
+    // topK: сколько лучших документов вернуть; kAllResults - все найденные.
+    // Результаты упорядочены по убыванию скора, при равном скоре - по docId.
+    // Wand, BlockMaxWand и MaxScore работают только для top-k: при kAllResults обход полный.
+    static constexpr size_t kAllResults = 0;
+
+    // allowedDocIds - разрешенные документы по возрастанию docId; nullptr - все
     static std::vector<SearchResult> search(
         const std::vector<std::string> &queryTerms,
         InvertedIndex &index,
-        const std::vector<uint32_t> *allowedDocIds = nullptr);
+        const std::vector<uint32_t> *allowedDocIds = nullptr,
+        size_t topK = kAllResults,
+        QueryStrategy strategy = QueryStrategy::Exhaustive,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+
+    // Поиск по индексу на диске: распаковываются только постинги слов запроса
+    static std::vector<SearchResult> search(
+        const std::vector<std::string> &queryTerms,
+        const MappedIndex &index,
+        const std::vector<uint32_t> *allowedDocIds = nullptr,
+        size_t topK = kAllResults,
+        QueryStrategy strategy = QueryStrategy::Exhaustive,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+
+    // Только документы из filter. Список allowedDocIds выше тоже превращается в
+    // DocIdFilter, но на каждый запрос заново; готовый фильтр можно переиспользовать
+    static std::vector<SearchResult> search(
+        const std::vector<std::string> &queryTerms,
+        InvertedIndex &index,
+        const DocIdFilter &filter,
+        size_t topK = kAllResults,
+        QueryStrategy strategy = QueryStrategy::Exhaustive,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+
+    static std::vector<SearchResult> search(
+        const std::vector<std::string> &queryTerms,
+        const MappedIndex &index,
+        const DocIdFilter &filter,
+        size_t topK = kAllResults,
+        QueryStrategy strategy = QueryStrategy::Exhaustive,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+
+    // Фильтр, затем ранжирование: кандидаты - поток булева запроса (openBooleanIterator),
+    // ранжируются документ за документом, без списка кандидатов в памяти. Итератор и курсоры
+    // слов идут вперед вместе; когда top-k полон, кандидаты без существенных слов (как
+    // в MaxScore) пропускаются через candidates.advance. Кандидат без слов запроса получает
+    // скор 0, поэтому, например, "!санкции" выдает первые документы без слова по docId.
+    // Итератор не переиспользуется: обход может остановиться до его конца.
+    static std::vector<SearchResult> search(
+        const std::vector<std::string> &queryTerms,
+        InvertedIndex &index,
+        DocIdIterator &candidates,
+        size_t topK = kAllResults,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+
+    static std::vector<SearchResult> search(
+        const std::vector<std::string> &queryTerms,
+        const MappedIndex &index,
+        DocIdIterator &candidates,
+        size_t topK = kAllResults,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+
+    // Ранжирование с семантикой AND: скор считается только документам со всеми словами
+    // запроса. Постинги пересекаются документ за документом: ведущий - самый короткий
+    // список, остальные догоняют его через advance, пропуская блоки по таблице пропусков,
+    // так что длинные списки частых слов почти не читаются. Скор документа тот же, что
+    // и в search. Если таких документов меньше topK (при kAllResults - ни одного), выдача -
+    // обычный поиск OR стратегией fallback, и stats->conjunctiveFallback = true
+    static std::vector<SearchResult> searchConjunctive(
+        const std::vector<std::string> &queryTerms,
+        InvertedIndex &index,
+        size_t topK = kAllResults,
+        QueryStrategy fallback = QueryStrategy::MaxScore,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+
+    static std::vector<SearchResult> searchConjunctive(
+        const std::vector<std::string> &queryTerms,
+        const MappedIndex &index,
+        size_t topK = kAllResults,
+        QueryStrategy fallback = QueryStrategy::MaxScore,
+        SearchStats *stats = nullptr,
+        const Scoring &scoring = Scoring());
+};
+
+extern template class BasicScorer<TfIdfScoring>;
+extern template class BasicScorer<Bm25Scoring>;
+extern template class BasicScorer<ImpactScoring>;
+
+// Score-at-a-time ("anytime") по индексу вкладов в раскладке по вкладам
+// (IndexLayout::ImpactOrdered, см. ImpactIndex.hpp). Сегменты всех слов запроса
+// обходятся от большего вклада к меньшему, поэтому остановка в любой момент оставляет
+// в аккумуляторах самые весомые вклады: бюджет - ручка между задержкой и качеством.
+// Без бюджета результат совпадает с BasicScorer<ImpactScoring> по тем же вкладам.
+// Скор - в квантах (getImpactScale() индекса). В индексе другой раскладки результат пуст.
+class AnytimeScorer
+{
+public:
+    static constexpr size_t kAllResults = 0;
+
+    static std::vector<SearchResult> search(
+        const std::vector<std::string> &queryTerms,
+        const MappedIndex &index,
+        size_t topK = kAllResults,
+        const AnytimeBudget &budget = AnytimeBudget(),
+        SearchStats *stats = nullptr);
 };
 
-#endif
\ No newline at end of file
+// Основное ранжирование - BM25 (k1 = 1.2, b = 0.75; другие - через аргумент scoring)
+using Scorer = BasicScorer<Bm25Scoring>;
+
+#endif
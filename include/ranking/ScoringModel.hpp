@@ -0,0 +1,123 @@
+#ifndef SCORING_MODEL_HPP
+#define SCORING_MODEL_HPP
+
+#include "../core/DocumentStats.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+// Модели ранжирования - политики BasicScorer (см. Scorer.hpp). Модель подставляется
+// шаблоном, поэтому score() встраивается прямо в цикл по постингам.
+// Интерфейс:
+//   Score                   - тип скора и аккумуляторов
+//   kImpactIndex            - модель для индекса квантованных вкладов (ImpactIndex)
+//   prepare(index)          - перед запросом: статистика документов индекса
+//   idf(index, termId)      - вес термина, один раз на запрос
+//   score(docId, tf, idf)   - вклад термина в скор документа
+//   maxScore(maxTf, idf)    - верхняя граница score() при tf <= maxTf (для отсечения)
+// score() не убывает по tf, а вклад неотрицателен - на этом держатся WAND и MaxScore.
+
+// Классический tf * log(N / df), без нормализации по длине документа
+struct TfIdfScoring
+{
+    using Score = double;
+    static constexpr bool kImpactIndex = false;
+
+    template <typename Index>
+    void prepare(const Index &) {}
+
+    template <typename Index>
+    double idf(const Index &index, uint32_t termId) const
+    {
+        return std::log((double)index.getTotalDocs() / (double)index.getDocFrequency(termId));
+    }
+
+    double score(uint32_t, uint32_t tf, double termIdf) const { return (double)tf * termIdf; }
+    double maxScore(uint32_t maxTf, double termIdf) const { return (double)maxTf * termIdf; }
+};
+
+// Okapi BM25:
+//   idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * length / averageLength))
+// k1 - насыщение по tf, b - сила нормализации по длине (0 - без нее).
+// IDF берется готовым из индекса. Длины документов - из DocumentStats индекса;
+// если их нет (старый индекс), каждый документ считается средней длины.
+class Bm25Scoring
+{
+public:
+    using Score = double;
+    static constexpr bool kImpactIndex = false;
+
+private:
+    double k1;
+    double b;
+
+    // Знаменатель без tf: lengthBase + lengthScale * length
+    const uint32_t *lengths = nullptr;
+    size_t lengthCount = 0;
+    double lengthBase = 0;
+    double lengthScale = 0;
+    double shortestNorm = 0; // Для самого короткого документа - наибольший вклад
+
+public:
+    explicit Bm25Scoring(double k1 = 1.2, double b = 0.75) : k1(k1), b(b), lengthBase(k1), shortestNorm(k1) {}
+
+    double getK1() const { return k1; }
+    double getB() const { return b; }
+
+    template <typename Index>
+    void prepare(const Index &index)
+    {
+        const DocumentStats &documents = index.getDocumentStats();
+        if (documents.empty())
+        {
+            lengths = nullptr;
+            lengthCount = 0;
+            lengthBase = k1;
+            lengthScale = 0;
+            shortestNorm = k1;
+            return;
+        }
+
+        lengths = documents.data();
+        lengthCount = documents.size();
+        lengthBase = k1 * (1.0 - b);
+        lengthScale = k1 * b / documents.averageLength();
+        shortestNorm = lengthBase + lengthScale * documents.minLength();
+    }
+
+    template <typename Index>
+    double idf(const Index &index, uint32_t termId) const { return index.getIdf(termId); }
+
+    double score(uint32_t docId, uint32_t tf, double termIdf) const
+    {
+        double norm = docId < lengthCount ? lengthBase + lengthScale * lengths[docId] : k1;
+        double frequency = (double)tf;
+        return termIdf * (frequency * (k1 + 1.0)) / (frequency + norm);
+    }
+
+    double maxScore(uint32_t maxTf, double termIdf) const
+    {
+        double frequency = (double)maxTf;
+        return termIdf * (frequency * (k1 + 1.0)) / (frequency + std::fmin(shortestNorm, k1));
+    }
+};
+
+// Индекс квантованных вкладов (см. ImpactIndex.hpp): в постинге вместо TF уже лежит
+// вклад термина в скор, поэтому запрос - это сложение целых в uint32_t-аккумуляторах.
+// Скор результата - в квантах; getImpactScale() индекса переводит его в единицы BM25
+struct ImpactScoring
+{
+    using Score = uint32_t;
+    static constexpr bool kImpactIndex = true;
+
+    template <typename Index>
+    void prepare(const Index &) {}
+
+    template <typename Index>
+    double idf(const Index &, uint32_t) const { return 1.0; }
+
+    Score score(uint32_t, uint32_t impact, double) const { return impact; }
+    double maxScore(uint32_t maxImpact, double) const { return (double)maxImpact; }
+};
+
+#endif
@@ -3,10 +3,35 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// Кодек блоков постингов; номер пишется в заголовок index.bin
+enum class BlockCodec : uint32_t
+{
+    VarByte = 0,     // По 7 бит в байте, флаг продолжения в старшем бите
+    StreamVByte = 1, // Длины четырех чисел в управляющем байте, данные без флагов (SSSE3)
+    BitPacking = 2,  // Все числа блока одной битовой ширины, полный блок - SIMD-BP128 (SSE2)
+};
 
 class Compression
 {
 public:
+    // Блок - не больше kMaxBlockValues чисел (см. kPostingsBlockSize)
+    static constexpr size_t kMaxBlockValues = 128;
+
+    // Дописывает n чисел в out
+    static void encodeBlock(BlockCodec codec, const uint32_t *values, size_t n, std::vector<uint8_t> &out);
+
+    // Читает n чисел с позиции pos, не выходя за size; pos сдвигается за конец блока.
+    // Если данных не хватает, недостающие числа равны 0 (как у decodeVarByte)
+    static void decodeBlock(BlockCodec codec, const uint8_t *input, size_t size, size_t &pos, uint32_t *values, size_t n);
+
+    static bool isKnownCodec(uint32_t codec) { return codec <= static_cast<uint32_t>(BlockCodec::BitPacking); }
+    static const char *codecName(BlockCodec codec);
+    // "varbyte", "streamvbyte", "bp128"; false для неизвестного имени
+    static bool parseCodec(std::string_view name, BlockCodec &codec);
+
     static void encodeVarByte(uint32_t number, std::vector<uint8_t> &output)
     {
         while (number >= 128)
@@ -18,12 +43,18 @@ public:
     }
 
     static uint32_t decodeVarByte(const std::vector<uint8_t> &input, size_t &pos)
+    {
+        return decodeVarByte(input.data(), input.size(), pos);
+    }
+
+    // То же для сырого буфера (например, отображенного в память файла)
+    static uint32_t decodeVarByte(const uint8_t *input, size_t size, size_t &pos)
     {
         uint32_t number = 0;
         int shift = 0;
         while (true)
         {
-            if (pos >= input.size())
+            if (pos >= size)
                 return 0; // Защита от выхода за границы
 
             uint8_t byte = input[pos++];
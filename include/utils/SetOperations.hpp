@@ -0,0 +1,66 @@
+#ifndef SET_OPERATIONS_HPP
+#define SET_OPERATIONS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Набор команд, которым считаются пересечения и объединения
+enum class SimdLevel : uint32_t
+{
+    Scalar = 0, // Слияние с ветвлениями, работает везде
+    Sse41 = 1,  // Блоки по 4 числа: сравнение "все со всеми" и сеть слияния min/max
+    Avx2 = 2,   // Пересечение блоками по 8 (объединение - как в Sse41)
+};
+
+// Операции над отсортированными списками docId без повторов. Уровень SIMD
+// выбирается при первом вызове по процессору (__builtin_cpu_supports), SIMD-код
+// собирается с атрибутом target, поэтому флаги компилятора не нужны.
+// Если один список длиннее другого в kGallopingRatio раз и больше, все операции
+// идут галопом по длинному (объединение копирует его участки целиком).
+// Векторные ядра пишут в out блоками целиком, поэтому out - с запасом kOutputPadding
+// чисел; out не должен пересекаться с входными массивами.
+class SetOperations
+{
+public:
+    static constexpr size_t kOutputPadding = 8;
+    static constexpr size_t kGallopingRatio = 32;
+
+    // Лучший уровень, доступный на этом процессоре
+    static SimdLevel detectedLevel();
+    static const char *levelName(SimdLevel level);
+
+    // Пересечение a и b; out - не меньше min(na, nb) + kOutputPadding чисел.
+    // Возвращает число записанных. level выше доступного понижается до доступного
+    static size_t intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out,
+                            SimdLevel level = detectedLevel());
+
+    // Объединение; out - не меньше na + nb + kOutputPadding чисел
+    static size_t unite(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out,
+                        SimdLevel level = detectedLevel());
+
+    // a без b; out - не меньше na + kOutputPadding чисел
+    static size_t subtract(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out);
+
+    // То же для векторов: out заменяется результатом
+    static void intersect(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b, std::vector<uint32_t> &out)
+    {
+        out.resize(std::min(a.size(), b.size()) + kOutputPadding);
+        out.resize(intersect(a.data(), a.size(), b.data(), b.size(), out.data()));
+    }
+
+    static void unite(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b, std::vector<uint32_t> &out)
+    {
+        out.resize(a.size() + b.size() + kOutputPadding);
+        out.resize(unite(a.data(), a.size(), b.data(), b.size(), out.data()));
+    }
+
+    static void subtract(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b, std::vector<uint32_t> &out)
+    {
+        out.resize(a.size() + kOutputPadding);
+        out.resize(subtract(a.data(), a.size(), b.data(), b.size(), out.data()));
+    }
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "core/MappedIndex.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+namespace
+{
+    // [offset, offset + size) внутри [0, limit) - без переполнения при битых смещениях
+    bool fitsWithin(uint64_t offset, uint64_t size, uint64_t limit)
+    {
+        return offset <= limit && size <= limit - offset;
+    }
+}
+
+MappedIndex::~MappedIndex() { close(); }
+
+MappedIndex::MappedIndex(MappedIndex &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedIndex &MappedIndex::operator=(MappedIndex &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(data, other.data);
+        std::swap(fileSize, other.fileSize);
+        std::swap(header, other.header);
+        std::swap(entries, other.entries);
+        std::swap(termPool, other.termPool);
+        std::swap(documents, other.documents);
+        std::swap(termIdf, other.termIdf);
+    }
+    return *this;
+}
+
+bool MappedIndex::open(const std::string &filename, bool withRankingStats)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(IndexFileHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // Отображение остается валидным и после закрытия дескриптора
+    if (mapped == MAP_FAILED)
+        return false;
+
+    data = static_cast<const uint8_t *>(mapped);
+    fileSize = info.st_size;
+    header = reinterpret_cast<const IndexFileHeader *>(data);
+
+    // Проверяем формат и то, что все области лежат внутри файла
+    bool valid = isValidIndexHeader(*header) &&
+                 header->postingsOffset <= header->termsOffset &&
+                 header->termsOffset <= header->dictionaryOffset &&
+                 header->dictionaryOffset % alignof(IndexTermEntry) == 0 &&
+                 header->dictionaryOffset <= fileSize &&
+                 header->termCount <= (fileSize - header->dictionaryOffset) / sizeof(IndexTermEntry);
+    if (!valid)
+    {
+        close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const IndexTermEntry *>(data + header->dictionaryOffset);
+    termPool = reinterpret_cast<const char *>(data + header->termsOffset);
+
+    // Строка каждого термина - внутри области строк: getTerm и бинарный поиск в getTermId
+    // читают их без проверок
+    const uint64_t termPoolSize = header->dictionaryOffset - header->termsOffset;
+    for (uint64_t termId = 0; termId < header->termCount; ++termId)
+    {
+        if (!fitsWithin(entries[termId].termOffset, entries[termId].termLength, termPoolSize))
+        {
+            close();
+            return false;
+        }
+    }
+
+    // Запросы читают файл вразнобой: опережающее чтение только вредит
+    madvise(const_cast<uint8_t *>(data), fileSize, MADV_RANDOM);
+
+    if (withRankingStats)
+    {
+        documents.load(DocumentStats::pathFor(filename));
+        termIdf.resize(getTermCount());
+        for (uint32_t termId = 0; termId < termIdf.size(); ++termId)
+            termIdf[termId] = DocumentStats::idf(getTotalDocs(), getDocFrequency(termId));
+    }
+    return true;
+}
+
+void MappedIndex::close()
+{
+    if (data)
+        munmap(const_cast<uint8_t *>(data), fileSize);
+
+    data = nullptr;
+    fileSize = 0;
+    header = nullptr;
+    entries = nullptr;
+    termPool = nullptr;
+    documents.clear();
+    std::vector<double>().swap(termIdf);
+}
+
+void MappedIndex::adviseSequential() const
+{
+    if (data)
+        madvise(const_cast<uint8_t *>(data), fileSize, MADV_SEQUENTIAL);
+}
+
+uint32_t MappedIndex::getTermId(std::string_view term) const
+{
+    size_t low = 0;
+    size_t high = getTermCount();
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (getTerm(middle) < term)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (low < getTermCount() && getTerm(low) == term)
+        return static_cast<uint32_t>(low);
+    return kNoTerm;
+}
+
+PostingCursor MappedIndex::openCursor(uint32_t termId) const
+{
+    const IndexTermEntry &entry = entries[termId];
+
+    // Битый словарь не должен приводить к чтению за пределами файла
+    if (isImpactOrdered() || !fitsWithin(entry.postingsOffset, entry.postingsSize, fileSize))
+        return PostingCursor();
+
+    return PostingCursor(data + entry.postingsOffset, entry.postingsSize, entry.docFrequency, getCodec(), entry.maxTf);
+}
+
+ImpactSegments MappedIndex::openSegments(uint32_t termId) const
+{
+    const IndexTermEntry &entry = entries[termId];
+    if (!isImpactOrdered() || !fitsWithin(entry.postingsOffset, entry.postingsSize, fileSize))
+        return ImpactSegments();
+
+    return ImpactSegments(data + entry.postingsOffset, entry.postingsSize, entry.segmentCount, getCodec());
+}
+
+void MappedIndex::decodePostings(uint32_t termId, PostingsList &out) const
+{
+    PostingCursor cursor = openCursor(termId);
+    out.clear();
+    out.reserve(cursor.size());
+
+    for (; !cursor.atEnd(); cursor.next())
+        out.emplace_back(cursor.docId(), cursor.tf());
+}
@@ -14,7 +14,7 @@ MongoConnector::MongoConnector(const std::string &uri_str, const std::string &db
 
 MongoConnector::~MongoConnector() = default;
 
-void MongoConnector::processAllDocuments(std::function<void(const RawDocument &)> callback)
+void MongoConnector::processAllDocuments(std::function<void(RawDocument &)> callback)
 {
     auto collection = (*client)[dbName][collectionName];
     auto cursor = collection.find({});
@@ -0,0 +1,179 @@
+#include "indexing/IndexingPipeline.hpp"
+#include "core/SpimiRuns.hpp"
+#include "ranking/ImpactIndex.hpp"
+#include "nlp/HtmlParser.hpp"
+#include "nlp/Tokenizer.hpp"
+#include "nlp/Lemmatizer.hpp"
+#include "utils/BoundedQueue.hpp"
+#include <thread>
+#include <iostream>
+#include <cstdio>
+
+namespace
+{
+    struct PendingDocument
+    {
+        uint32_t id = 0;
+        std::string html;
+    };
+
+    // runs == nullptr - индекс копится в памяти целиком
+    void indexDocuments(BoundedQueue<PendingDocument> &queue, InvertedIndex &localIndex,
+                        SpimiRuns *runs, size_t memoryBudget)
+    {
+        Lemmatizer lemmatizer;
+        PendingDocument doc;
+
+        // Документы приходят из общей очереди по возрастанию id,
+        // поэтому списки локального индекса остаются отсортированными
+        while (queue.pop(doc))
+        {
+            std::string plainText = HtmlParser::getCleanText(doc.html);
+            std::vector<std::string> tokens = Tokenizer::tokenize(plainText);
+
+            bool hasTerms = false;
+            for (const auto &token : tokens)
+            {
+                std::string_view lemma = lemmatizer.stem(token);
+                if (!lemma.empty())
+                {
+                    localIndex.addTerm(lemma, doc.id);
+                    hasTerms = true;
+                }
+            }
+
+            if (hasTerms)
+                localIndex.incrementDocCount();
+
+            // Сбрасываем только между документами: каждый документ целиком в одном прогоне
+            if (runs && localIndex.memoryUsage() > memoryBudget && !runs->flush(localIndex))
+                std::cerr << "[INIT] Failed to write index run" << std::endl;
+        }
+    }
+}
+
+IndexingPipeline::IndexingPipeline(size_t threads, size_t capacity)
+    : threadCount(threads > 0 ? threads : 1),
+      queueCapacity(capacity > 0 ? capacity : threadCount * 8)
+{
+}
+
+void IndexingPipeline::setMemoryBudget(size_t bytes, const std::string &directory)
+{
+    memoryBudget = bytes;
+    runDirectory = directory;
+}
+
+void IndexingPipeline::setCodec(BlockCodec blockCodec)
+{
+    codec = blockCodec;
+}
+
+void IndexingPipeline::setImpactBits(uint32_t bits, const Bm25Scoring &scoring, IndexLayout layout)
+{
+    impactBits = bits;
+    impactScoring = scoring;
+    impactLayout = layout;
+}
+
+void IndexingPipeline::setFrequencyStatsFile(const std::string &csvFile)
+{
+    frequencyStatsFile = csvFile;
+}
+
+void IndexingPipeline::exportFrequencyStats(const std::string &tfFile) const
+{
+    // Без статистики индекс остается годным: ошибка только в лог
+    if (!frequencyStatsFile.empty() && !InvertedIndex::exportFrequencyStatsFromFile(tfFile, frequencyStatsFile))
+        std::cerr << "[INIT] Failed to export frequency statistics to " << frequencyStatsFile << std::endl;
+}
+
+std::vector<InvertedIndex> IndexingPipeline::runWorkers(const DocumentSource &source, std::vector<std::string> &docUrls,
+                                                        SpimiRuns *runs)
+{
+    BoundedQueue<PendingDocument> queue(queueCapacity);
+    std::vector<InvertedIndex> localIndexes(threadCount);
+
+    // Бюджет делится поровну между рабочими
+    size_t workerBudget = runs ? std::max<size_t>(1, memoryBudget / threadCount) : 0;
+
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(indexDocuments, std::ref(queue), std::ref(localIndexes[i]), runs, workerBudget);
+    }
+
+    auto stopWorkers = [&]()
+    {
+        queue.close();
+        for (auto &worker : workers)
+            worker.join();
+    };
+
+    try
+    {
+        // Производитель: URL сохраняем сразу, HTML отдаем рабочим без копирования
+        source([&](RawDocument &doc)
+               {
+            if (docUrls.size() <= doc.id)
+                docUrls.resize(doc.id + 1);
+            docUrls[doc.id] = std::move(doc.url);
+
+            if (doc.html.empty())
+                return;
+
+            queue.push(PendingDocument{doc.id, std::move(doc.html)}); });
+    }
+    catch (...)
+    {
+        stopWorkers();
+        throw;
+    }
+
+    stopWorkers();
+    return localIndexes;
+}
+
+InvertedIndex IndexingPipeline::run(const DocumentSource &source, std::vector<std::string> &docUrls)
+{
+    return InvertedIndex::merge(runWorkers(source, docUrls, nullptr));
+}
+
+bool IndexingPipeline::runToFile(const DocumentSource &source, std::vector<std::string> &docUrls, const std::string &indexFile)
+{
+    if (impactBits == 0)
+    {
+        if (!writeTfIndex(source, docUrls, indexFile))
+            return false;
+        exportFrequencyStats(indexFile);
+        return true;
+    }
+
+    // Вклады зависят от статистики всей коллекции: сначала обычный индекс, затем второй проход.
+    // Частоты слов выгружаются из него же, пока файл с TF не удален
+    const std::string tfFile = indexFile + ".tf";
+    bool ok = writeTfIndex(source, docUrls, tfFile);
+    if (ok)
+        exportFrequencyStats(tfFile);
+    ok = ok && ImpactIndex::build(tfFile, indexFile, impactBits, codec, impactScoring, impactLayout);
+    InvertedIndex::removeFiles(tfFile);
+    return ok;
+}
+
+bool IndexingPipeline::writeTfIndex(const DocumentSource &source, std::vector<std::string> &docUrls, const std::string &indexFile)
+{
+    if (memoryBudget == 0)
+        return run(source, docUrls).save(indexFile, codec);
+
+    SpimiRuns spimi(runDirectory);
+    std::vector<InvertedIndex> localIndexes = runWorkers(source, docUrls, &spimi);
+
+    // Остатки локальных индексов - последние прогоны
+    bool ok = true;
+    for (auto &localIndex : localIndexes)
+        ok = spimi.flush(localIndex) && ok;
+
+    std::cout << "[INIT] Merging " << spimi.runCount() << " runs into " << indexFile << "..." << std::endl;
+    return spimi.mergeInto(indexFile, codec) && ok;
+}
@@ -4,14 +4,19 @@
 #include <fstream>
 #include <filesystem>
 #include <algorithm>
+#include <thread>
+#include <cstdlib>
 
 #include "db/MongoConnector.hpp"
 #include "nlp/HtmlParser.hpp"
 #include "nlp/Tokenizer.hpp"
 #include "nlp/Lemmatizer.hpp"
 #include "core/InvertedIndex.hpp"
-#include "core/BooleanIndex.hpp"
+#include "core/BooleanQuery.hpp"
+#include "core/MappedIndex.hpp"
+#include "indexing/IndexingPipeline.hpp"
 #include "ranking/Scorer.hpp"
+#include "ranking/ImpactIndex.hpp"
 #include "nlp/QueryParser.hpp"
 
 // --- Хелперы для загрузки/сохранения URL ---
@@ -55,18 +60,87 @@ int main(int argc, char *argv[])
 {
     // Конфигурация
     bool useBooleanMode = false;
+    bool explainPlans = false; // --explain: план булева запроса и его оценка перед результатами
+    bool conjunctiveRanking = false; // --and: ранжировать только документы со всеми словами запроса
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    size_t memoryBudgetMb = 0; // 0 - весь индекс строится в памяти
+    BlockCodec codec = BlockCodec::VarByte;
+    double bm25K1 = 1.2;
+    double bm25B = 0.75;
+    uint32_t impactBits = 0; // 0 - в индексе TF, иначе квантованные вклады BM25
+    IndexLayout impactLayout = IndexLayout::DocumentOrdered;
+    AnytimeBudget anytimeBudget; // Для индекса в раскладке по вкладам
     for (int i = 1; i < argc; ++i)
     {
-        if (std::string(argv[i]) == "--bool")
+        std::string arg = argv[i];
+        if (arg == "--bool")
         {
             useBooleanMode = true;
-            break;
+        }
+        else if (arg == "--explain")
+        {
+            explainPlans = true;
+        }
+        else if (arg == "--and")
+        {
+            conjunctiveRanking = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--memory-budget" && i + 1 < argc)
+        {
+            memoryBudgetMb = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--codec" && i + 1 < argc)
+        {
+            if (!Compression::parseCodec(argv[++i], codec))
+            {
+                std::cerr << "Unknown codec: " << argv[i] << " (varbyte, streamvbyte, bp128)" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--impacts" && i + 1 < argc)
+        {
+            impactBits = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+            if (impactBits > ImpactIndex::kMaxBits)
+            {
+                std::cerr << "Impact bits must be 1.." << ImpactIndex::kMaxBits << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--impact-ordered")
+        {
+            impactLayout = IndexLayout::ImpactOrdered;
+        }
+        else if (arg == "--postings-budget" && i + 1 < argc)
+        {
+            anytimeBudget.maxPostings = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        }
+        else if (arg == "--time-budget-ms" && i + 1 < argc)
+        {
+            anytimeBudget.maxMilliseconds = std::max(0.0, std::atof(argv[++i]));
+        }
+        else if (arg == "--bm25-k1" && i + 1 < argc)
+        {
+            bm25K1 = std::max(0.0, std::atof(argv[++i]));
+        }
+        else if (arg == "--bm25-b" && i + 1 < argc)
+        {
+            bm25B = std::clamp(std::atof(argv[++i]), 0.0, 1.0);
         }
     }
 
+    if (impactLayout == IndexLayout::ImpactOrdered && impactBits == 0)
+    {
+        std::cerr << "--impact-ordered requires --impacts N" << std::endl;
+        return 1;
+    }
+
     const std::string INDEX_FILE = "index.bin";
-    const std::string BOOLEAN_INDEX_FILE = "boolean_index.bin";
     const std::string URLS_FILE = "urls.bin";
+    const std::string INDEX_RUNS_DIR = "index_runs";
 
     Lemmatizer lemmatizer;
     QueryParser queryParser(lemmatizer);
@@ -82,50 +156,37 @@ int main(int argc, char *argv[])
 
         // Подключение к БД
         MongoConnector db("mongodb://localhost:27017", "search_engine", "pages");
-        InvertedIndex tempIndex;
-
-        std::cout << "[INIT] Processing documents..." << std::endl;
 
-        // Обработка документов
-        db.processAllDocuments([&](const RawDocument &doc)
-                               {
-
-            if (docUrls.size() <= doc.id) docUrls.resize(doc.id + 1);
-            docUrls[doc.id] = doc.url;
-
-            if (doc.html.empty()) return;
-
-            std::string plainText = HtmlParser::getCleanText(doc.html);
-            
-            std::vector<std::string> tokens = Tokenizer::tokenize(plainText);
-            
-            std::vector<std::string> terms;
-            terms.reserve(tokens.size());
-            for(const auto& token : tokens) {
-                std::string lemma = lemmatizer.lemmatize(token);
-                if (!lemma.empty()) {
-                    terms.push_back(lemma);
-                }
-            }
-
-            if (!terms.empty()) {
-                for (const auto& term : terms) {
-                    tempIndex.addTerm(term, doc.id); 
-                }
-
-                tempIndex.incrementDocCount();
-            } });
+        std::cout << "[INIT] Processing documents with " << threadCount << " threads..." << std::endl;
+
+        // Обработка документов: чтение из курсора -> очередь -> рабочие потоки
+        IndexingPipeline pipeline(threadCount);
+        pipeline.setCodec(codec);
+        pipeline.setImpactBits(impactBits, Bm25Scoring(bm25K1, bm25B), impactLayout);
+        pipeline.setFrequencyStatsFile("zipf_data.csv"); // По TF, даже если в index.bin вклады
+        if (impactBits > 0)
+            std::cout << "[INIT] Postings store " << impactBits << "-bit BM25 impacts"
+                      << (impactLayout == IndexLayout::ImpactOrdered ? ", ordered by impact" : "") << std::endl;
+        std::cout << "[INIT] Postings codec: " << Compression::codecName(codec) << std::endl;
+        if (memoryBudgetMb > 0)
+        {
+            std::cout << "[INIT] Memory budget: " << memoryBudgetMb << " MB, runs in " << INDEX_RUNS_DIR << std::endl;
+            pipeline.setMemoryBudget(memoryBudgetMb << 20, INDEX_RUNS_DIR);
+        }
 
-        std::cout << "\n[INIT] Finished. Total indexed docs: " << tempIndex.getTotalDocs() << std::endl;
+        bool indexed = pipeline.runToFile([&](const auto &callback)
+                                          { db.processAllDocuments(callback); },
+                                          docUrls, INDEX_FILE);
+        if (!indexed)
+        {
+            std::cerr << "Error: Failed to write " << INDEX_FILE << std::endl;
+            return 1;
+        }
 
-        std::cout << "[INIT] Saving " << INDEX_FILE << "..." << std::endl;
-        tempIndex.save(INDEX_FILE);
+        std::cout << "\n[INIT] Finished. Total documents: " << docUrls.size() << std::endl;
 
         std::cout << "[INIT] Saving " << URLS_FILE << "..." << std::endl;
         saveUrls(URLS_FILE, docUrls);
-
-        std::cout << "[INIT] Exporting frequency statistics..." << std::endl;
-        tempIndex.exportFrequencyStats("zipf_data.csv");
     }
     else
     {
@@ -136,48 +197,51 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Булев индекс
-    if (useBooleanMode && !std::filesystem::exists(BOOLEAN_INDEX_FILE))
-    {
-        std::cout << "[INIT] Boolean mode requested. Converting index..." << std::endl;
-
-        InvertedIndex tempInverted;
-        if (!tempInverted.load(INDEX_FILE))
-        {
-            std::cerr << "Error: Failed to load index.bin." << std::endl;
-            return 1;
-        }
-
-        tempInverted.exportToBooleanIndex(BOOLEAN_INDEX_FILE);
-        std::cout << "[INIT] Conversion complete." << std::endl;
-    }
-
     std::cout << "=== Initialization Complete ===\n"
               << std::endl;
 
-    // Режим поиска: булев или tf-idf
+    // Режим поиска: булев или BM25
 
     if (useBooleanMode)
     {
         std::cout << "Mode: BOOLEAN SEARCH" << std::endl;
 
-        BooleanIndex booleanIndex;
-        if (!booleanIndex.load(BOOLEAN_INDEX_FILE))
+        // Тот же index.bin, что и для ранжирования: постинги читаются сжатыми, TF пропускаются
+        MappedIndex booleanIndex;
+        if (!booleanIndex.open(INDEX_FILE, false))
+        {
+            std::cerr << "Error: Failed to open " << INDEX_FILE << " (old or damaged format). Please delete it and re-run." << std::endl;
+            return 1;
+        }
+        if (booleanIndex.isImpactOrdered())
+        {
+            std::cerr << "Error: Boolean search needs a document-ordered index (built without --impact-ordered)." << std::endl;
             return 1;
+        }
 
         std::cout << "\n> ";
         std::string query;
         while (std::getline(std::cin, query) && query != "exit")
         {
-            std::vector<uint32_t> results = queryParser.parseBoolean(query, booleanIndex);
-
-            if (results.empty())
+            // Переписанный план; отрицание не разворачивается в список всех документов
+            BooleanNode plan = queryParser.planBoolean(query, booleanIndex);
+            if (explainPlans)
+                std::cout << BooleanPlanner::explain(plan);
+            DocIdIteratorPtr results = openBooleanIterator(plan, booleanIndex);
+
+            std::vector<uint32_t> shown;
+            for (; shown.size() < 10 && !results->atEnd(); results->next())
+                shown.push_back(results->docId());
+            size_t found = shown.size() + results->countRemaining();
+
+            if (shown.empty())
                 std::cout << "No documents found." << std::endl;
             else
             {
-                for (size_t i = 0; i < std::min(results.size(), (size_t)10); ++i)
+                std::cout << "Found " << found << " documents." << std::endl;
+                for (size_t i = 0; i < shown.size(); ++i)
                 {
-                    uint32_t id = results[i];
+                    uint32_t id = shown[i];
                     std::string url = (id < docUrls.size()) ? docUrls[id] : "UNKNOWN";
                     std::cout << i + 1 << ". " << url << std::endl;
                 }
@@ -187,11 +251,17 @@ int main(int argc, char *argv[])
     }
     else
     {
-        std::cout << "Mode: RANKING SEARCH (TF-IDF)" << std::endl;
+        std::cout << "Mode: RANKING SEARCH (BM25, k1=" << bm25K1 << ", b=" << bm25B << ")" << std::endl;
+        if (conjunctiveRanking)
+            std::cout << "Conjunctive ranking: documents with all query words (any of them if fewer than 10)" << std::endl;
 
-        InvertedIndex invertedIndex;
-        if (!invertedIndex.load(INDEX_FILE))
+        // Индекс отображается в память: постинги читаются только для слов запроса
+        MappedIndex invertedIndex;
+        if (!invertedIndex.open(INDEX_FILE))
+        {
+            std::cerr << "Error: Failed to open " << INDEX_FILE << " (old or damaged format). Please delete it and re-run." << std::endl;
             return 1;
+        }
 
         // Проверка на случай битого индекса
         if (invertedIndex.getTotalDocs() == 0)
@@ -199,19 +269,87 @@ int main(int argc, char *argv[])
             std::cerr << "Error: Index contains 0 documents! Please delete index.bin and re-run." << std::endl;
             return 1;
         }
+        if (invertedIndex.hasImpacts())
+            std::cout << "Postings store " << invertedIndex.getImpactBits() << "-bit impacts (k1, b fixed at indexing)" << std::endl;
+        if (invertedIndex.isImpactOrdered())
+        {
+            std::cout << "Score-at-a-time evaluation, budget:";
+            if (anytimeBudget.maxPostings > 0)
+                std::cout << " " << anytimeBudget.maxPostings << " postings";
+            if (anytimeBudget.maxMilliseconds > 0)
+                std::cout << " " << anytimeBudget.maxMilliseconds << " ms";
+            if (anytimeBudget.maxPostings == 0 && anytimeBudget.maxMilliseconds <= 0)
+                std::cout << " none";
+            std::cout << std::endl;
+            std::cout << "Boolean operators and --and are ignored: both need a document-ordered index" << std::endl;
+        }
+
+        // MaxScore: на коротких запросах не хуже Block-Max WAND, а на длинных (заголовки
+        // новостей из 8-12 частых слов) быстрее его в разы - см. DynamicPruningBench
+        const QueryStrategy rankingStrategy = QueryStrategy::MaxScore;
 
         std::string query;
         std::cout << "> ";
         while (std::getline(std::cin, query) && query != "exit")
         {
-            std::vector<std::string> terms = queryParser.parseTerms(query);
-            std::vector<SearchResult> results = Scorer::search(terms, invertedIndex, nullptr);
+            std::vector<SearchResult> results;
+            SearchStats stats;
+            if (queryParser.hasBooleanOperators(query) && !invertedIndex.isImpactOrdered())
+            {
+                // Фильтр, затем ранжирование: булево выражение дает поток кандидатов,
+                // скор - по словам без отрицания, за один проход по постингам
+                BooleanNode parsed = queryParser.parseBooleanQuery(query);
+                std::vector<std::string> terms = BooleanPlanner::rankingTerms(parsed);
+                BooleanNode plan = BooleanPlanner::plan(std::move(parsed), invertedIndex);
+                if (explainPlans)
+                    std::cout << BooleanPlanner::explain(plan);
+                DocIdIteratorPtr candidates = openBooleanIterator(plan, invertedIndex);
+                if (invertedIndex.hasImpacts())
+                {
+                    results = BasicScorer<ImpactScoring>::search(terms, invertedIndex, *candidates, 10);
+                    for (auto &result : results)
+                        result.score *= invertedIndex.getImpactScale();
+                }
+                else
+                {
+                    results = Scorer::search(terms, invertedIndex, *candidates, 10, nullptr, Bm25Scoring(bm25K1, bm25B));
+                }
+            }
+            else if (invertedIndex.hasImpacts())
+            {
+                // Вклады уже посчитаны при индексации: складываем целые и переводим в единицы BM25
+                std::vector<std::string> terms = queryParser.parseTerms(query);
+                if (invertedIndex.isImpactOrdered())
+                    results = AnytimeScorer::search(terms, invertedIndex, 10, anytimeBudget);
+                else if (conjunctiveRanking)
+                    results = BasicScorer<ImpactScoring>::searchConjunctive(terms, invertedIndex, 10, rankingStrategy,
+                                                                            &stats);
+                else
+                    results = BasicScorer<ImpactScoring>::search(terms, invertedIndex, nullptr, 10, rankingStrategy);
+                for (auto &result : results)
+                    result.score *= invertedIndex.getImpactScale();
+            }
+            else if (conjunctiveRanking)
+            {
+                std::vector<std::string> terms = queryParser.parseTerms(query);
+                results = Scorer::searchConjunctive(terms, invertedIndex, 10, rankingStrategy,
+                                                    &stats, Bm25Scoring(bm25K1, bm25B));
+            }
+            else
+            {
+                std::vector<std::string> terms = queryParser.parseTerms(query);
+                results = Scorer::search(terms, invertedIndex, nullptr, 10, rankingStrategy,
+                                         nullptr, Bm25Scoring(bm25K1, bm25B));
+            }
+
+            if (stats.conjunctiveFallback && !results.empty())
+                std::cout << "Fewer than 10 documents contain all words; showing documents with any of them." << std::endl;
 
             if (results.empty())
                 std::cout << "Nothing found." << std::endl;
             else
             {
-                for (size_t i = 0; i < std::min(results.size(), (size_t)10); ++i)
+                for (size_t i = 0; i < results.size(); ++i)
                 {
                     uint32_t id = results[i].docId;
                     std::string url = (id < docUrls.size()) ? docUrls[id] : "UNKNOWN";
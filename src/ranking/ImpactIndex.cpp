@@ -0,0 +1,50 @@
+#include "ranking/ImpactIndex.hpp"
+#include "core/IndexFile.hpp"
+#include "core/MappedIndex.hpp"
+#include <algorithm>
+#include <cmath>
+
+bool ImpactIndex::build(const std::string &sourceFile, const std::string &targetFile, uint32_t bits,
+                        BlockCodec codec, const Bm25Scoring &bm25, IndexLayout layout)
+{
+    if (bits < kMinBits || bits > kMaxBits)
+        return false;
+
+    MappedIndex source;
+    if (!source.open(sourceFile) || source.hasImpacts())
+        return false;
+    source.adviseSequential();
+
+    Bm25Scoring scoring = bm25;
+    scoring.prepare(source);
+
+    // Квант - по верхней границе вклада: ее знает словарь, постинги читать не нужно
+    double maxImpact = 0;
+    for (uint32_t termId = 0; termId < source.getTermCount(); ++termId)
+        maxImpact = std::max(maxImpact, scoring.maxScore(source.getEntry(termId).maxTf, source.getIdf(termId)));
+
+    const uint32_t maxLevel = (1u << bits) - 1;
+    const double scale = maxImpact > 0 ? maxImpact / maxLevel : 1.0;
+
+    IndexFileWriter writer;
+    if (!writer.open(targetFile, source.getTotalDocs(), codec))
+        return false;
+    writer.setImpactQuantization(bits, scale);
+    writer.setLayout(layout);
+
+    PostingsList postings;
+    for (uint32_t termId = 0; termId < source.getTermCount(); ++termId)
+    {
+        double idf = source.getIdf(termId);
+        source.decodePostings(termId, postings);
+        for (auto &posting : postings)
+        {
+            // Ноль не годится: документ со словом должен остаться в выдаче
+            double level = std::round(scoring.score(posting.docId, posting.termFrequency, idf) / scale);
+            posting.termFrequency = static_cast<uint32_t>(std::clamp(level, 1.0, (double)maxLevel));
+        }
+        writer.writeTerm(source.getTerm(termId), postings);
+    }
+
+    return writer.close() && source.getDocumentStats().save(DocumentStats::pathFor(targetFile));
+}
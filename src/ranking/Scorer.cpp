@@ -1,53 +1,885 @@
 #include "ranking/Scorer.hpp"
+#include "ranking/ScoreAccumulator.hpp"
+#include <limits>
+#include <chrono>
 
-std::vector<SearchResult> Scorer::search(
-    const std::vector<std::string> &queryTerms,
-    InvertedIndex &index,
-    const std::vector<uint32_t> *allowedDocIds)
+namespace
 {
-    HashMap<uint32_t, double> docScores;
-    size_t N = index.getTotalDocs();
+    // Порядок выдачи: по убыванию скора, при равенстве - по возрастанию docId
+    bool rankedBefore(const SearchResult &a, const SearchResult &b)
+    {
+        return a.score != b.score ? a.score > b.score : a.docId < b.docId;
+    }
 
-    for (const auto &term : queryTerms)
+    // k лучших документов (k == Scorer::kAllResults - все), упорядоченные rankedBefore.
+    // Для k лучших держим кучу из k элементов с худшим наверху: O(n log k) вместо O(n log n).
+    // Все документы должны приходить по возрастанию docId: тогда равные скоры упорядочивает
+    // устойчивая сортировка по одному скору, что в разы быстрее сравнения по двум ключам.
+    class TopKCollector
     {
-        auto postings = index.getPostings(term);
-        if (!postings)
-            continue;
+    private:
+        size_t k;
+        std::vector<SearchResult> results;
 
-        double idf = std::log((double)N / (double)postings->size());
+    public:
+        explicit TopKCollector(size_t topK) : k(topK) {}
 
-        for (const auto &p : *postings)
+        void push(uint32_t docId, double score)
         {
-            if (allowedDocIds != nullptr)
+            SearchResult candidate{docId, score};
+            if (k == Scorer::kAllResults)
+            {
+                results.push_back(candidate);
+            }
+            else if (results.size() < k)
+            {
+                results.push_back(candidate);
+                std::push_heap(results.begin(), results.end(), rankedBefore);
+            }
+            else if (rankedBefore(candidate, results.front()))
             {
-                if (!std::binary_search(allowedDocIds->begin(), allowedDocIds->end(), p.docId))
+                std::pop_heap(results.begin(), results.end(), rankedBefore);
+                results.back() = candidate;
+                std::push_heap(results.begin(), results.end(), rankedBefore);
+            }
+        }
+
+        // Скор, который нужно превзойти, чтобы попасть в top-k (пока куча не полна - любой)
+        double threshold() const
+        {
+            if (k == Scorer::kAllResults || results.size() < k)
+                return -std::numeric_limits<double>::infinity();
+            return results.front().score;
+        }
+
+        std::vector<SearchResult> finish()
+        {
+            if (k == Scorer::kAllResults)
+                std::stable_sort(results.begin(), results.end(), [](const SearchResult &a, const SearchResult &b)
+                                 { return a.score > b.score; });
+            else
+                std::sort(results.begin(), results.end(), rankedBefore);
+            return std::move(results);
+        }
+    };
+
+    struct QueryTerm
+    {
+        PostingCursor cursor;
+        double idf;
+        size_t allowedPos = 0;   // Докуда дошли по списку фильтра
+        double upperBound = 0;   // Наибольший возможный вклад термина
+    };
+
+    // Документы, большие этой границы, считаются по диапазонам docId такого размера:
+    // массив скоров диапазона (16 байт на документ) остается в L2
+    constexpr uint32_t kPartitionDocs = 1u << 15;
+
+    // Аккумулятор в типе скора модели: double или uint32_t для квантованных вкладов
+    template <typename Scoring>
+    using Accumulator = ScoreAccumulator<typename Scoring::Score>;
+
+    // Фильтр считается редким, если на разрешенный документ приходится больше
+    // стольких постингов: тогда дешевле прыгать по разрешенным, чем проверять каждый постинг
+    constexpr size_t kSparseFilterRatio = 16;
+
+    // Прибавляет вклад термина для документов [base, end) в accumulator (по смещению от base)
+    template <typename Scoring>
+    void accumulate(QueryTerm &term, Accumulator<Scoring> &accumulator, uint32_t base, uint32_t end,
+                    const DocIdFilter *filter, const Scoring &scoring, size_t &scored)
+    {
+        PostingCursor &cursor = term.cursor;
+        if (filter == nullptr)
+        {
+            for (; cursor.docId() < end; cursor.next())
+            {
+                accumulator.add(cursor.docId() - base, scoring.score(cursor.docId(), cursor.tf(), term.idf));
+                ++scored;
+            }
+            return;
+        }
+
+        if (filter->size() * kSparseFilterRatio >= cursor.size())
+        {
+            // Плотный фильтр: постинги подряд, для каждого - проверка бита
+            for (; cursor.docId() < end; cursor.next())
+            {
+                if (!filter->contains(cursor.docId()))
+                    continue;
+                accumulator.add(cursor.docId() - base, scoring.score(cursor.docId(), cursor.tf(), term.idf));
+                ++scored;
+            }
+            return;
+        }
+
+        // Редкий фильтр: идем по обоим спискам вперед, блоки постингов без
+        // разрешенных документов пропускаются по таблице пропусков
+        while (cursor.docId() < end)
+        {
+            term.allowedPos = filter->seek(cursor.docId(), term.allowedPos);
+            uint32_t allowed = filter->at(term.allowedPos);
+            if (allowed == DocIdFilter::kEnd)
+            {
+                cursor.advance(PostingCursor::kEndDoc);
+                break;
+            }
+
+            if (allowed != cursor.docId())
+            {
+                cursor.advance(allowed);
+                continue;
+            }
+
+            accumulator.add(cursor.docId() - base, scoring.score(cursor.docId(), cursor.tf(), term.idf));
+            ++scored;
+            cursor.next();
+        }
+    }
+
+    template <typename Score>
+    void collect(ScoreAccumulator<Score> &accumulator, uint32_t base, TopKCollector &top, size_t topK)
+    {
+        auto push = [&](uint32_t offset, Score score)
+        { top.push(base + offset, (double)score); };
+
+        if (topK == Scorer::kAllResults)
+            accumulator.traverseInDocOrder(push);
+        else
+            accumulator.traverse(push);
+    }
+
+    // Границы скора считаются в другом порядке сложения, чем сам скор; запас
+    // в миллиардную долю не дает округлению отсечь документ с равным границе скором
+    constexpr double kBoundSlack = 1.0 + 1e-9;
+
+    void advanceTerms(std::vector<QueryTerm *> &order, size_t count, uint32_t target)
+    {
+        for (size_t i = 0; i < count; ++i)
+            order[i]->cursor.advance(target);
+    }
+
+    // Документ за документом (WAND; с blockMax - Block-Max WAND). Курсоры упорядочены
+    // по текущему docId. pivot - первый курсор, на котором сумма верхних границ
+    // терминов превышает порог top-k: документы левее pivotDoc заведомо не проходят,
+    // и курсоры перед pivot сразу прыгают на него. Block-Max WAND дополнительно
+    // проверяет границы блоков, в которые попадает pivotDoc, и, если их мало,
+    // пропускает документы до конца ближайшего из этих блоков.
+    // Документы приходят по возрастанию docId, поэтому документ с равным порогу
+    // скором в top-k уже не попадет - отсекать по "<= порога" точно.
+    template <typename Scoring>
+    std::vector<SearchResult> scoreDocumentAtATime(std::vector<QueryTerm> &terms,
+                                                   const DocIdFilter *filter,
+                                                   size_t topK, bool blockMax, const Scoring &scoring, size_t &scored)
+    {
+        std::vector<QueryTerm *> order;
+        order.reserve(terms.size());
+        for (auto &term : terms)
+        {
+            term.upperBound = scoring.maxScore(term.cursor.maxTf(), term.idf) * kBoundSlack;
+            order.push_back(&term);
+        }
+
+        auto byDocId = [](const QueryTerm *a, const QueryTerm *b)
+        { return a->cursor.docId() < b->cursor.docId(); };
+
+        TopKCollector top(topK);
+        size_t allowedPos = 0;
+        while (true)
+        {
+            // Сдвинулись лишь несколько курсоров - порядок почти готов, хватает вставками
+            for (size_t i = 1; i < order.size(); ++i)
+                for (size_t j = i; j > 0 && byDocId(order[j], order[j - 1]); --j)
+                    std::swap(order[j], order[j - 1]);
+            double threshold = top.threshold();
+
+            size_t pivot = order.size();
+            double bound = 0;
+            for (size_t i = 0; i < order.size() && !order[i]->cursor.atEnd(); ++i)
+            {
+                bound += order[i]->upperBound;
+                if (bound > threshold)
                 {
+                    pivot = i;
+                    break;
+                }
+            }
+            if (pivot == order.size())
+                break;
+
+            // Все курсоры, стоящие на pivotDoc, участвуют в его скоре
+            uint32_t pivotDoc = order[pivot]->cursor.docId();
+            while (pivot + 1 < order.size() && order[pivot + 1]->cursor.docId() == pivotDoc)
+                ++pivot;
+
+            if (filter && !filter->contains(pivotDoc))
+            {
+                allowedPos = filter->seek(pivotDoc, allowedPos);
+                uint32_t allowed = filter->at(allowedPos);
+                if (allowed == DocIdFilter::kEnd)
+                    break;
+                advanceTerms(order, pivot + 1, allowed);
+                continue;
+            }
+
+            if (blockMax)
+            {
+                double blockBound = 0;
+                uint32_t nextCandidate = pivot + 1 < order.size() ? order[pivot + 1]->cursor.docId() : PostingCursor::kEndDoc;
+                for (size_t i = 0; i <= pivot; ++i)
+                {
+                    PostingCursor::BlockBound block = order[i]->cursor.blockBound(pivotDoc);
+                    blockBound += scoring.maxScore(block.maxTf, order[i]->idf) * kBoundSlack;
+                    nextCandidate = std::min(nextCandidate, block.lastDocId + 1);
+                }
+
+                if (blockBound <= threshold)
+                {
+                    advanceTerms(order, pivot + 1, nextCandidate);
                     continue;
                 }
             }
 
-            double tf = (double)p.termFrequency;
-            double score = tf * idf;
+            if (order[0]->cursor.docId() != pivotDoc)
+            {
+                advanceTerms(order, pivot, pivotDoc);
+                continue;
+            }
 
-            double *currentScore = docScores.get(p.docId);
-            if (currentScore)
+            // Скор складываем в порядке слов запроса - как при обходе термин за термином
+            typename Scoring::Score score = 0;
+            for (auto &term : terms)
             {
-                *currentScore += score;
+                if (term.cursor.docId() != pivotDoc)
+                    continue;
+                score += scoring.score(pivotDoc, term.cursor.tf(), term.idf);
+                ++scored;
+                term.cursor.next();
             }
-            else
+            top.push(pivotDoc, (double)score);
+        }
+
+        return top.finish();
+    }
+
+    // Скор документа по терминам, для которых matched(i): вклады складываются в порядке
+    // слов запроса - как при обходе термин за термином, поэтому скор одного документа
+    // совпадает до бита у всех стратегий
+    template <typename Scoring, typename Matched>
+    typename Scoring::Score scoreInQueryOrder(const std::vector<QueryTerm> &terms, uint32_t docId,
+                                              const Scoring &scoring, Matched matched)
+    {
+        typename Scoring::Score score = 0;
+        for (size_t t = 0; t < terms.size(); ++t)
+        {
+            if (matched(t))
+                score += scoring.score(docId, terms[t].cursor.tf(), terms[t].idf);
+        }
+        return score;
+    }
+
+    // Разбиение MaxScore: термины по возрастанию верхней границы делятся на несущественные -
+    // префикс, сумма границ которого не превышает порога top-k, - и существенные.
+    // Документ без существенных терминов в top-k не попадет, а несущественные
+    // проверяются через advance по убыванию границы и лишь пока кандидат еще может
+    // пройти порог. С ростом порога несущественных становится больше.
+    // Общее для MaxScore и ранжирования кандидатов булева фильтра
+    template <typename Scoring>
+    class MaxScoreTerms
+    {
+    private:
+        std::vector<QueryTerm> &terms;
+        const Scoring &scoring;
+        std::vector<QueryTerm *> order;
+        std::vector<double> prefixBound; // prefixBound[i] - сумма границ order[0..i-1]
+        std::vector<char> hit;
+        size_t firstEssential = 0;
+
+    public:
+        MaxScoreTerms(std::vector<QueryTerm> &queryTerms, const Scoring &model)
+            : terms(queryTerms), scoring(model), prefixBound(queryTerms.size() + 1, 0), hit(queryTerms.size(), 0)
+        {
+            order.reserve(terms.size());
+            for (auto &term : terms)
+            {
+                term.upperBound = scoring.maxScore(term.cursor.maxTf(), term.idf) * kBoundSlack;
+                order.push_back(&term);
+            }
+            std::sort(order.begin(), order.end(), [](const QueryTerm *a, const QueryTerm *b)
+                      { return a->upperBound < b->upperBound; });
+
+            for (size_t i = 0; i < order.size(); ++i)
+                prefixBound[i + 1] = prefixBound[i] + order[i]->upperBound;
+        }
+
+        // Переносит границу существенных под порог; false - существенных не осталось
+        bool updateThreshold(double threshold)
+        {
+            while (firstEssential < order.size() && prefixBound[firstEssential + 1] <= threshold)
+                ++firstEssential;
+            return firstEssential < order.size();
+        }
+
+        // Наименьший docId существенных курсоров, предварительно сдвинутых к target
+        uint32_t advanceEssential(uint32_t target)
+        {
+            uint32_t nearest = PostingCursor::kEndDoc;
+            for (size_t i = firstEssential; i < order.size(); ++i)
+            {
+                order[i]->cursor.advance(target);
+                nearest = std::min(nearest, order[i]->cursor.docId());
+            }
+            return nearest;
+        }
+
+        // Скор кандидата; существенные курсоры должны стоять не левее него.
+        // false - кандидат не пройдет порог, и до конца скор не считается
+        bool score(uint32_t candidate, double threshold, typename Scoring::Score &score, size_t &scored)
+        {
+            std::fill(hit.begin(), hit.end(), 0);
+            double partial = 0;
+            for (size_t i = firstEssential; i < order.size(); ++i)
+            {
+                if (order[i]->cursor.docId() == candidate)
+                {
+                    partial += scoring.score(candidate, order[i]->cursor.tf(), order[i]->idf);
+                    hit[order[i] - terms.data()] = 1;
+                    ++scored;
+                }
+            }
+
+            // Несущественные - от самого весомого, пока кандидат может пройти порог
+            for (size_t i = firstEssential; i-- > 0;)
+            {
+                if (partial * kBoundSlack + prefixBound[i + 1] <= threshold)
+                    return false;
+                PostingCursor &cursor = order[i]->cursor;
+                cursor.advance(candidate);
+                if (cursor.docId() == candidate)
+                {
+                    partial += scoring.score(candidate, cursor.tf(), order[i]->idf);
+                    hit[order[i] - terms.data()] = 1;
+                    ++scored;
+                }
+            }
+
+            score = scoreInQueryOrder(terms, candidate, scoring, [&](size_t t)
+                                      { return hit[t] != 0; });
+            return true;
+        }
+
+        // Существенные курсоры, стоящие на docId, - на следующий документ
+        void nextEssential(uint32_t docId)
+        {
+            for (size_t i = firstEssential; i < order.size(); ++i)
+            {
+                if (order[i]->cursor.docId() == docId)
+                    order[i]->cursor.next();
+            }
+        }
+    };
+
+    // MaxScore: кандидаты берутся только из существенных списков (MaxScoreTerms).
+    // Хорошо работает на длинных запросах, где большинство слов частые и мало весят.
+    template <typename Scoring>
+    std::vector<SearchResult> scoreMaxScore(std::vector<QueryTerm> &terms,
+                                            const DocIdFilter *filter,
+                                            size_t topK, const Scoring &scoring, size_t &scored)
+    {
+        MaxScoreTerms<Scoring> split(terms, scoring);
+        TopKCollector top(topK);
+        size_t allowedPos = 0;
+        while (true)
+        {
+            double threshold = top.threshold();
+            if (!split.updateThreshold(threshold))
+                break;
+
+            uint32_t candidate = split.advanceEssential(0);
+            if (candidate == PostingCursor::kEndDoc)
+                break;
+
+            if (filter && !filter->contains(candidate))
+            {
+                allowedPos = filter->seek(candidate, allowedPos);
+                uint32_t allowed = filter->at(allowedPos);
+                if (allowed == DocIdFilter::kEnd)
+                    break;
+                split.advanceEssential(allowed);
+                continue;
+            }
+
+            typename Scoring::Score score = 0;
+            if (split.score(candidate, threshold, score, scored))
+                top.push(candidate, (double)score);
+            split.nextEssential(candidate);
+        }
+
+        return top.finish();
+    }
+
+    // Кандидаты булева фильтра по возрастанию docId, термины разбиты как в MaxScore.
+    // Пока top-k не полон, скор нужен каждому кандидату, даже без слов запроса:
+    // курсоры слов догоняют его через advance. Когда полон, документ без существенных
+    // слов порог не пройдет: фильтр и существенные курсоры прыгают друг к другу
+    // (leapfrog), пока не сойдутся на одном docId.
+    template <typename Scoring>
+    std::vector<SearchResult> scoreCandidates(std::vector<QueryTerm> &terms,
+                                              DocIdIterator &candidates,
+                                              size_t topK, const Scoring &scoring, size_t &scored)
+    {
+        MaxScoreTerms<Scoring> split(terms, scoring);
+        TopKCollector top(topK);
+        while (!candidates.atEnd())
+        {
+            double threshold = top.threshold();
+            const bool full = threshold > -std::numeric_limits<double>::infinity();
+            if (!split.updateThreshold(threshold) && full)
+                break;
+
+            uint32_t candidate = candidates.docId();
+            uint32_t nearest = split.advanceEssential(candidate);
+            if (full && nearest != candidate)
             {
-                docScores.insert(p.docId, score);
+                if (nearest == PostingCursor::kEndDoc)
+                    break;
+                candidates.advance(nearest);
+                continue;
             }
+
+            typename Scoring::Score score = 0;
+            if (split.score(candidate, threshold, score, scored))
+                top.push(candidate, (double)score);
+            candidates.next();
         }
+
+        return top.finish();
     }
 
-    std::vector<SearchResult> results;
+    // Пересечение документ за документом: ведущий - самый короткий список, остальные
+    // по возрастанию длины догоняют кандидата через advance. Первый не совпавший
+    // список сразу сдвигает ведущего на свой docId, так что документы, которых нет
+    // в редком списке, дальше не проверяются. Когда top-k полон, вклад уже совпавших
+    // списков плюс верхние границы оставшихся сравнивается с порогом: кандидат, который
+    // порог не превысит, бросается, не дочитывая остальные списки
+    template <typename Scoring>
+    std::vector<SearchResult> scoreConjunctive(std::vector<QueryTerm> &terms,
+                                               size_t topK, const Scoring &scoring, size_t &scored)
+    {
+        TopKCollector top(topK);
+        if (terms.empty())
+            return top.finish();
+
+        std::vector<QueryTerm *> order;
+        order.reserve(terms.size());
+        for (auto &term : terms)
+        {
+            term.upperBound = scoring.maxScore(term.cursor.maxTf(), term.idf) * kBoundSlack;
+            order.push_back(&term);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const QueryTerm *a, const QueryTerm *b)
+                         { return a->cursor.size() < b->cursor.size(); });
+
+        // suffixBound[i] - сумма границ order[i..]
+        std::vector<double> suffixBound(order.size() + 1, 0);
+        for (size_t i = order.size(); i-- > 0;)
+            suffixBound[i] = suffixBound[i + 1] + order[i]->upperBound;
+
+        PostingCursor &leader = order[0]->cursor;
+        while (!leader.atEnd())
+        {
+            double threshold = top.threshold();
+            if (suffixBound[0] <= threshold)
+                break;
+
+            // Пока top-k не полон, отсекать нечего: частичные вклады не считаем
+            const bool pruning = threshold > -std::numeric_limits<double>::infinity();
+            uint32_t candidate = leader.docId();
+            double partial = 0;
+            if (pruning)
+            {
+                partial = scoring.score(candidate, leader.tf(), order[0]->idf);
+                ++scored;
+            }
+
+            bool agreed = true;
+            bool pruned = false;
+            for (size_t i = 1; i < order.size(); ++i)
+            {
+                if (pruning && partial * kBoundSlack + suffixBound[i] <= threshold)
+                {
+                    pruned = true;
+                    break;
+                }
+                PostingCursor &cursor = order[i]->cursor;
+                cursor.advance(candidate);
+                if (cursor.docId() != candidate)
+                {
+                    leader.advance(cursor.docId());
+                    agreed = false;
+                    break;
+                }
+                if (pruning)
+                {
+                    partial += scoring.score(candidate, cursor.tf(), order[i]->idf);
+                    ++scored;
+                }
+            }
+            if (!agreed)
+                continue;
+
+            if (!pruned)
+            {
+                typename Scoring::Score score = scoreInQueryOrder(terms, candidate, scoring, [](size_t)
+                                                                  { return true; });
+                if (!pruning)
+                    scored += terms.size();
+                top.push(candidate, (double)score);
+            }
+            leader.next();
+        }
+
+        return top.finish();
+    }
 
-    docScores.traverse([&](const uint32_t &docId, const double &score)
-                       { results.push_back({docId, score}); });
+    // Курсоры слов запроса, которые есть в индексе; scoring уже подготовлен к индексу
+    template <typename Scoring, typename Index>
+    std::vector<QueryTerm> openTerms(const std::vector<std::string> &queryTerms, const Index &index,
+                                     const Scoring &scoring)
+    {
+        std::vector<QueryTerm> terms;
+        terms.reserve(queryTerms.size());
+
+        for (const auto &term : queryTerms)
+        {
+            uint32_t termId = index.getTermId(term);
+            if (termId == Index::kNoTerm)
+                continue;
+
+            PostingCursor cursor = index.openCursor(termId);
+            if (cursor.size() == 0)
+                continue;
+
+            terms.push_back({cursor, scoring.idf(index, termId)});
+        }
+        return terms;
+    }
+
+    // Index - InvertedIndex или MappedIndex: getTermId(), openCursor(), getTotalDocs(),
+    // а также то, что нужно модели Scoring (см. ScoringModel.hpp).
+    // Постинги не распаковываются в списки, а читаются курсором прямо из сжатых данных.
+    template <typename Scoring, typename Index>
+    std::vector<SearchResult> scoreTerms(
+        const std::vector<std::string> &queryTerms,
+        const Index &index,
+        const DocIdFilter *filter,
+        DocIdIterator *candidates,
+        size_t topK,
+        QueryStrategy strategy,
+        Scoring scoring,
+        size_t &scored)
+    {
+        // Квантованные вклады и TF взаимозаменяемы только по типу: в чужом индексе не ищем
+        if (index.hasImpacts() != Scoring::kImpactIndex)
+            return {};
+
+        size_t N = index.getTotalDocs();
+        scoring.prepare(index);
+        std::vector<QueryTerm> terms = openTerms(queryTerms, index, scoring);
+
+        if (candidates)
+            return scoreCandidates(terms, *candidates, topK, scoring, scored);
+
+        if (topK != Scorer::kAllResults)
+        {
+            if (strategy == QueryStrategy::Wand || strategy == QueryStrategy::BlockMaxWand)
+                return scoreDocumentAtATime(terms, filter, topK, strategy == QueryStrategy::BlockMaxWand, scoring, scored);
+            if (strategy == QueryStrategy::MaxScore)
+                return scoreMaxScore(terms, filter, topK, scoring, scored);
+        }
+
+        // Массив скоров свой у каждого потока и переиспользуется между запросами
+        thread_local Accumulator<Scoring> accumulator;
+        TopKCollector top(topK);
+
+        if (terms.size() < 2 || N <= kPartitionDocs)
+        {
+            // Весь диапазон docId за один проход по каждому термину
+            accumulator.reset(N);
+            for (auto &term : terms)
+                accumulate(term, accumulator, 0, PostingCursor::kEndDoc, filter, scoring, scored);
+
+            collect(accumulator, 0, top, topK);
+            return top.finish();
+        }
+
+        // Большая коллекция: считаем по диапазонам docId, пропуская пустые
+        while (true)
+        {
+            uint32_t first = PostingCursor::kEndDoc;
+            for (const auto &term : terms)
+                first = std::min(first, term.cursor.docId());
+            if (first == PostingCursor::kEndDoc)
+                break;
+
+            uint32_t base = first - first % kPartitionDocs;
+            uint32_t end = static_cast<uint32_t>(std::min<uint64_t>((uint64_t)base + kPartitionDocs, PostingCursor::kEndDoc));
+
+            accumulator.reset(kPartitionDocs);
+            for (auto &term : terms)
+                accumulate(term, accumulator, base, end, filter, scoring, scored);
+
+            collect(accumulator, base, top, topK);
+        }
+
+        return top.finish();
+    }
+
+    template <typename Scoring, typename Index>
+    std::vector<SearchResult> searchWithStats(
+        const std::vector<std::string> &queryTerms,
+        const Index &index,
+        const DocIdFilter *filter,
+        DocIdIterator *candidates,
+        size_t topK,
+        QueryStrategy strategy,
+        SearchStats *stats,
+        const Scoring &scoring)
+    {
+        size_t scored = 0;
+        std::vector<SearchResult> results = scoreTerms(queryTerms, index, filter, candidates, topK, strategy, scoring, scored);
+        if (stats)
+            stats->postingsScored = scored;
+        return results;
+    }
+
+    template <typename Scoring, typename Index>
+    std::vector<SearchResult> searchConjunctiveWithStats(
+        const std::vector<std::string> &queryTerms,
+        const Index &index,
+        size_t topK,
+        QueryStrategy fallback,
+        SearchStats *stats,
+        const Scoring &scoring)
+    {
+        if (index.hasImpacts() != Scoring::kImpactIndex)
+            return {};
 
-    std::sort(results.begin(), results.end(), [](const SearchResult &a, const SearchResult &b)
-              { return a.score > b.score; });
+        size_t scored = 0;
+        Scoring prepared = scoring;
+        prepared.prepare(index);
+        std::vector<QueryTerm> terms = openTerms(queryTerms, index, prepared);
 
-    return results;
-}
\ No newline at end of file
+        // Слова, которого нет в индексе, нет ни в одном документе: AND заведомо пуст
+        std::vector<SearchResult> results;
+        if (!terms.empty() && terms.size() == queryTerms.size())
+            results = scoreConjunctive(terms, topK, prepared, scored);
+
+        bool fallbackToOr = results.size() < (topK == Scorer::kAllResults ? 1 : topK);
+        if (fallbackToOr)
+            results = scoreTerms(queryTerms, index, nullptr, nullptr, topK, fallback, scoring, scored);
+
+        if (stats)
+        {
+            stats->postingsScored = scored;
+            stats->conjunctiveFallback = fallbackToOr;
+        }
+        return results;
+    }
+
+    // Фильтр из списка docId: память фильтра своя у каждого потока и переиспользуется
+    const DocIdFilter *filterFor(const std::vector<uint32_t> *allowedDocIds)
+    {
+        if (allowedDocIds == nullptr)
+            return nullptr;
+
+        thread_local DocIdFilter filter;
+        filter.assign(allowedDocIds->data(), allowedDocIds->size());
+        return &filter;
+    }
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::search(
+    const std::vector<std::string> &queryTerms,
+    InvertedIndex &index,
+    const std::vector<uint32_t> *allowedDocIds,
+    size_t topK,
+    QueryStrategy strategy,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchWithStats(queryTerms, index, filterFor(allowedDocIds), nullptr, topK, strategy, stats, scoring);
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::search(
+    const std::vector<std::string> &queryTerms,
+    const MappedIndex &index,
+    const std::vector<uint32_t> *allowedDocIds,
+    size_t topK,
+    QueryStrategy strategy,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchWithStats(queryTerms, index, filterFor(allowedDocIds), nullptr, topK, strategy, stats, scoring);
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::search(
+    const std::vector<std::string> &queryTerms,
+    InvertedIndex &index,
+    const DocIdFilter &filter,
+    size_t topK,
+    QueryStrategy strategy,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchWithStats(queryTerms, index, &filter, nullptr, topK, strategy, stats, scoring);
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::search(
+    const std::vector<std::string> &queryTerms,
+    const MappedIndex &index,
+    const DocIdFilter &filter,
+    size_t topK,
+    QueryStrategy strategy,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchWithStats(queryTerms, index, &filter, nullptr, topK, strategy, stats, scoring);
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::search(
+    const std::vector<std::string> &queryTerms,
+    InvertedIndex &index,
+    DocIdIterator &candidates,
+    size_t topK,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchWithStats(queryTerms, index, nullptr, &candidates, topK, QueryStrategy::MaxScore, stats, scoring);
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::search(
+    const std::vector<std::string> &queryTerms,
+    const MappedIndex &index,
+    DocIdIterator &candidates,
+    size_t topK,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchWithStats(queryTerms, index, nullptr, &candidates, topK, QueryStrategy::MaxScore, stats, scoring);
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::searchConjunctive(
+    const std::vector<std::string> &queryTerms,
+    InvertedIndex &index,
+    size_t topK,
+    QueryStrategy fallback,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchConjunctiveWithStats(queryTerms, index, topK, fallback, stats, scoring);
+}
+
+template <typename Scoring>
+std::vector<SearchResult> BasicScorer<Scoring>::searchConjunctive(
+    const std::vector<std::string> &queryTerms,
+    const MappedIndex &index,
+    size_t topK,
+    QueryStrategy fallback,
+    SearchStats *stats,
+    const Scoring &scoring)
+{
+    return searchConjunctiveWithStats(queryTerms, index, topK, fallback, stats, scoring);
+}
+
+template class BasicScorer<TfIdfScoring>;
+template class BasicScorer<Bm25Scoring>;
+template class BasicScorer<ImpactScoring>;
+
+std::vector<SearchResult> AnytimeScorer::search(
+    const std::vector<std::string> &queryTerms,
+    const MappedIndex &index,
+    size_t topK,
+    const AnytimeBudget &budget,
+    SearchStats *stats)
+{
+    if (stats)
+        *stats = SearchStats();
+    if (!index.isImpactOrdered())
+        return {};
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+
+    struct Segment
+    {
+        const ImpactSegments *segments;
+        uint32_t index;
+        uint32_t impact;
+    };
+
+    std::vector<ImpactSegments> terms;
+    terms.reserve(queryTerms.size());
+    for (const auto &term : queryTerms)
+    {
+        uint32_t termId = index.getTermId(term);
+        if (termId != MappedIndex::kNoTerm)
+            terms.push_back(index.openSegments(termId));
+    }
+
+    // Сегменты всех слов - по убыванию вклада; при равном вкладе - в порядке слов запроса
+    std::vector<Segment> order;
+    for (const auto &segments : terms)
+    {
+        for (uint32_t i = 0; i < segments.size(); ++i)
+            order.push_back({&segments, i, segments.segment(i).impact});
+    }
+    std::stable_sort(order.begin(), order.end(), [](const Segment &a, const Segment &b)
+                     { return a.impact > b.impact; });
+
+    const size_t postingLimit = budget.maxPostings ? budget.maxPostings : std::numeric_limits<size_t>::max();
+    const auto timeLimit = std::chrono::duration<double, std::milli>(budget.maxMilliseconds);
+
+    thread_local ScoreAccumulator<uint32_t> accumulator;
+    accumulator.reset(index.getTotalDocs());
+    size_t scored = 0;
+    bool exhausted = false;
+
+    for (const auto &segment : order)
+    {
+        // Время сверяем поблочно: вызов часов заметно дороже сложения вклада
+        segment.segments->forEachBlock(segment.index, [&](const uint32_t *docIds, uint32_t count)
+                                       {
+            if (scored == postingLimit || (budget.maxMilliseconds > 0 && Clock::now() - start >= timeLimit))
+            {
+                exhausted = true;
+                return false;
+            }
+
+            uint32_t allowed = static_cast<uint32_t>(std::min<size_t>(count, postingLimit - scored));
+            for (uint32_t i = 0; i < allowed; ++i)
+                accumulator.add(docIds[i], segment.impact);
+            scored += allowed;
+
+            exhausted = allowed < count;
+            return !exhausted; });
+
+        if (exhausted)
+            break;
+    }
+
+    TopKCollector top(topK);
+    collect(accumulator, 0, top, topK);
+    if (stats)
+    {
+        stats->postingsScored = scored;
+        stats->budgetExhausted = exhausted;
+    }
+    return top.finish();
+}
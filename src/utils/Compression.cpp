@@ -0,0 +1,392 @@
+#include "utils/Compression.hpp"
+#include <algorithm>
+#include <cstring>
+#include <array>
+#include <utility>
+
+// COMPRESSION_NO_SIMD отключает SIMD-пути (проверка скалярных на x86)
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(COMPRESSION_NO_SIMD)
+#include <immintrin.h>
+#define COMPRESSION_X86 1
+#endif
+
+// Кодеки блоков. Везде, где есть SIMD-путь, рядом лежит скалярный: он же
+// используется на других архитектурах и для хвостов, к которым нельзя
+// безопасно прочитать 16 байт.
+
+namespace
+{
+    // ---------- Stream VByte ----------
+    // [управляющие байты: по 2 бита (длина - 1) на число] [байты чисел, little-endian]
+
+    uint32_t byteLength(uint32_t value)
+    {
+        if (value < (1u << 8))
+            return 1;
+        if (value < (1u << 16))
+            return 2;
+        if (value < (1u << 24))
+            return 3;
+        return 4;
+    }
+
+    void encodeStreamVByte(const uint32_t *values, size_t n, std::vector<uint8_t> &out)
+    {
+        size_t controlPos = out.size();
+        out.resize(out.size() + (n + 3) / 4, 0);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint32_t length = byteLength(values[i]);
+            out[controlPos + i / 4] |= static_cast<uint8_t>((length - 1) << (2 * (i % 4)));
+            for (uint32_t k = 0; k < length; ++k)
+                out.push_back(static_cast<uint8_t>(values[i] >> (8 * k)));
+        }
+    }
+
+    // Одно число; false, если данные кончились
+    bool decodeStreamVByteValue(const uint8_t *control, const uint8_t *input, size_t end, size_t &pos,
+                                size_t i, uint32_t &value)
+    {
+        uint32_t length = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        if (pos + length > end)
+            return false;
+
+        value = 0;
+        for (uint32_t k = 0; k < length; ++k)
+            value |= static_cast<uint32_t>(input[pos + k]) << (8 * k);
+        pos += length;
+        return true;
+    }
+
+#ifdef COMPRESSION_X86
+    // Маски pshufb для каждого управляющего байта и суммарная длина четверки
+    struct StreamVByteTables
+    {
+        alignas(16) uint8_t shuffle[256][16];
+        uint8_t length[256];
+
+        StreamVByteTables()
+        {
+            for (int control = 0; control < 256; ++control)
+            {
+                uint8_t offset = 0;
+                for (int j = 0; j < 4; ++j)
+                {
+                    int len = ((control >> (2 * j)) & 3) + 1;
+                    for (int k = 0; k < 4; ++k)
+                        shuffle[control][4 * j + k] = k < len ? static_cast<uint8_t>(offset + k) : 0x80;
+                    offset += len;
+                }
+                length[control] = offset;
+            }
+        }
+    };
+
+    const StreamVByteTables &streamVByteTables()
+    {
+        static const StreamVByteTables tables;
+        return tables;
+    }
+
+    bool hasSsse3()
+    {
+        static const bool supported = __builtin_cpu_supports("ssse3");
+        return supported;
+    }
+
+    // Четверки чисел, пока за ними гарантированно есть 16 байт; возвращает, сколько чисел прочитано
+    __attribute__((target("ssse3"))) size_t decodeStreamVByteSsse3(const uint8_t *control, const uint8_t *input,
+                                                                  size_t end, size_t &pos, uint32_t *values, size_t n)
+    {
+        const StreamVByteTables &tables = streamVByteTables();
+        size_t i = 0;
+        for (; i + 4 <= n && pos + 16 <= end; i += 4)
+        {
+            uint8_t c = control[i / 4];
+            __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + pos));
+            __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i *>(tables.shuffle[c]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(values + i), _mm_shuffle_epi8(data, mask));
+            pos += tables.length[c];
+        }
+        return i;
+    }
+#endif
+
+    void decodeStreamVByte(const uint8_t *input, size_t size, size_t &pos, uint32_t *values, size_t n)
+    {
+        size_t controlBytes = (n + 3) / 4;
+        if (pos + controlBytes > size)
+        {
+            std::fill(values, values + n, 0);
+            pos = size;
+            return;
+        }
+
+        const uint8_t *control = input + pos;
+        pos += controlBytes;
+
+        size_t i = 0;
+#ifdef COMPRESSION_X86
+        if (hasSsse3())
+            i = decodeStreamVByteSsse3(control, input, size, pos, values, n);
+#endif
+        for (; i < n; ++i)
+        {
+            if (!decodeStreamVByteValue(control, input, size, pos, i, values[i]))
+            {
+                std::fill(values + i, values + n, 0);
+                pos = size;
+                return;
+            }
+        }
+    }
+
+    // ---------- Битовая упаковка ----------
+    // [ширина b] затем:
+    //   полный блок (128 чисел) - вертикальная раскладка SIMD-BP128: число i лежит в
+    //   "дорожке" i % 4, дорожки - потоки по b бит, их 32-битные слова перемежаются;
+    //   неполный блок - обычный поток по b бит, младшие биты первыми.
+
+    constexpr size_t kLanes = 4;
+    constexpr size_t kPackedBlock = Compression::kMaxBlockValues;
+
+    uint32_t bitWidth(const uint32_t *values, size_t n)
+    {
+        uint32_t all = 0;
+        for (size_t i = 0; i < n; ++i)
+            all |= values[i];
+
+        uint32_t bits = 0;
+        while (bits < 32 && (all >> bits) != 0)
+            bits++;
+        return bits;
+    }
+
+    uint32_t lowMask(uint32_t bits) { return bits == 32 ? UINT32_MAX : (1u << bits) - 1; }
+
+    size_t verticalBytes(uint32_t bits) { return bits * kLanes * sizeof(uint32_t); }
+    size_t horizontalBytes(uint32_t bits, size_t n) { return (bits * n + 7) / 8; }
+
+    void packVertical(const uint32_t *values, uint32_t bits, std::vector<uint8_t> &out)
+    {
+        if (bits == 0)
+            return;
+
+        std::vector<uint32_t> words(bits * kLanes, 0);
+        for (size_t row = 0; row < kPackedBlock / kLanes; ++row)
+        {
+            size_t bit = row * bits;
+            size_t word = bit / 32;
+            uint32_t shift = bit % 32;
+            for (size_t lane = 0; lane < kLanes; ++lane)
+            {
+                uint32_t value = values[row * kLanes + lane];
+                words[word * kLanes + lane] |= value << shift;
+                if (shift + bits > 32)
+                    words[(word + 1) * kLanes + lane] |= value >> (32 - shift);
+            }
+        }
+
+        size_t start = out.size();
+        out.resize(start + words.size() * sizeof(uint32_t));
+        std::memcpy(out.data() + start, words.data(), words.size() * sizeof(uint32_t));
+    }
+
+#ifndef COMPRESSION_X86
+    void unpackVerticalScalar(const uint8_t *input, uint32_t bits, uint32_t *values)
+    {
+        const uint32_t mask = lowMask(bits);
+        auto word = [&](size_t index)
+        {
+            uint32_t w;
+            std::memcpy(&w, input + index * sizeof(uint32_t), sizeof(w));
+            return w;
+        };
+
+        for (size_t row = 0; row < kPackedBlock / kLanes; ++row)
+        {
+            size_t bit = row * bits;
+            size_t w = bit / 32;
+            uint32_t shift = bit % 32;
+            for (size_t lane = 0; lane < kLanes; ++lane)
+            {
+                uint32_t value = word(w * kLanes + lane) >> shift;
+                if (shift + bits > 32)
+                    value |= word((w + 1) * kLanes + lane) << (32 - shift);
+                values[row * kLanes + lane] = value & mask;
+            }
+        }
+    }
+#endif
+
+#ifdef COMPRESSION_X86
+    // SSE2 есть на любом x86-64: четыре дорожки распаковываются одной командой.
+    // Ширина - параметр шаблона, чтобы сдвиги и ветки стали константами
+    template <uint32_t Bits>
+    void unpackVerticalSse2(const uint8_t *input, uint32_t *values)
+    {
+        const __m128i mask = _mm_set1_epi32(static_cast<int>(lowMask(Bits)));
+        const __m128i *words = reinterpret_cast<const __m128i *>(input);
+
+        for (size_t row = 0; row < kPackedBlock / kLanes; ++row)
+        {
+            const size_t bit = row * Bits;
+            const size_t w = bit / 32;
+            const uint32_t shift = bit % 32;
+
+            __m128i value = _mm_srli_epi32(_mm_loadu_si128(words + w), shift);
+            if (shift + Bits > 32)
+                value = _mm_or_si128(value, _mm_slli_epi32(_mm_loadu_si128(words + w + 1), 32 - shift));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(values + row * kLanes), _mm_and_si128(value, mask));
+        }
+    }
+
+    using UnpackFunction = void (*)(const uint8_t *, uint32_t *);
+
+    template <uint32_t... Bits>
+    constexpr std::array<UnpackFunction, sizeof...(Bits)> makeUnpackTable(std::integer_sequence<uint32_t, Bits...>)
+    {
+        return {&unpackVerticalSse2<Bits>...};
+    }
+
+    // Индекс - ширина 1..32 (ширина 0 обрабатывается отдельно)
+    constexpr auto kUnpackVertical = makeUnpackTable(std::make_integer_sequence<uint32_t, 33>{});
+#endif
+
+    void packHorizontal(const uint32_t *values, size_t n, uint32_t bits, std::vector<uint8_t> &out)
+    {
+        size_t start = out.size();
+        out.resize(start + horizontalBytes(bits, n), 0);
+        uint8_t *dest = out.data() + start;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t value = values[i];
+            size_t bit = i * bits;
+            for (uint32_t done = 0; done < bits;)
+            {
+                size_t byte = (bit + done) / 8;
+                uint32_t offset = (bit + done) % 8;
+                dest[byte] |= static_cast<uint8_t>((value >> done) << offset);
+                done += 8 - offset;
+            }
+        }
+    }
+
+    void unpackHorizontal(const uint8_t *input, size_t n, uint32_t bits, uint32_t *values)
+    {
+        const uint32_t mask = lowMask(bits);
+        const size_t bytes = horizontalBytes(bits, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            size_t bit = i * bits;
+            size_t first = bit / 8;
+            uint64_t chunk = 0;
+            for (size_t k = 0; k < 5 && first + k < bytes; ++k)
+                chunk |= static_cast<uint64_t>(input[first + k]) << (8 * k);
+            values[i] = static_cast<uint32_t>(chunk >> (bit % 8)) & mask;
+        }
+    }
+
+    void encodeBitPacking(const uint32_t *values, size_t n, std::vector<uint8_t> &out)
+    {
+        uint32_t bits = bitWidth(values, n);
+        out.push_back(static_cast<uint8_t>(bits));
+        if (n == kPackedBlock)
+            packVertical(values, bits, out);
+        else
+            packHorizontal(values, n, bits, out);
+    }
+
+    void decodeBitPacking(const uint8_t *input, size_t size, size_t &pos, uint32_t *values, size_t n)
+    {
+        uint32_t bits = pos < size ? input[pos] : 33;
+        size_t bytes = n == kPackedBlock ? verticalBytes(bits) : horizontalBytes(bits, n);
+        if (bits > 32 || pos + 1 + bytes > size)
+        {
+            std::fill(values, values + n, 0);
+            pos = size;
+            return;
+        }
+
+        const uint8_t *packed = input + pos + 1;
+        pos += 1 + bytes;
+        if (bits == 0)
+        {
+            std::fill(values, values + n, 0);
+            return;
+        }
+        if (n != kPackedBlock)
+        {
+            unpackHorizontal(packed, n, bits, values);
+            return;
+        }
+
+#ifdef COMPRESSION_X86
+        kUnpackVertical[bits](packed, values);
+#else
+        unpackVerticalScalar(packed, bits, values);
+#endif
+    }
+}
+
+void Compression::encodeBlock(BlockCodec codec, const uint32_t *values, size_t n, std::vector<uint8_t> &out)
+{
+    switch (codec)
+    {
+    case BlockCodec::StreamVByte:
+        encodeStreamVByte(values, n, out);
+        break;
+    case BlockCodec::BitPacking:
+        encodeBitPacking(values, n, out);
+        break;
+    default:
+        for (size_t i = 0; i < n; ++i)
+            encodeVarByte(values[i], out);
+        break;
+    }
+}
+
+void Compression::decodeBlock(BlockCodec codec, const uint8_t *input, size_t size, size_t &pos, uint32_t *values, size_t n)
+{
+    switch (codec)
+    {
+    case BlockCodec::StreamVByte:
+        decodeStreamVByte(input, size, pos, values, n);
+        break;
+    case BlockCodec::BitPacking:
+        decodeBitPacking(input, size, pos, values, n);
+        break;
+    default:
+        for (size_t i = 0; i < n; ++i)
+            values[i] = decodeVarByte(input, size, pos);
+        break;
+    }
+}
+
+const char *Compression::codecName(BlockCodec codec)
+{
+    switch (codec)
+    {
+    case BlockCodec::StreamVByte:
+        return "streamvbyte";
+    case BlockCodec::BitPacking:
+        return "bp128";
+    default:
+        return "varbyte";
+    }
+}
+
+bool Compression::parseCodec(std::string_view name, BlockCodec &codec)
+{
+    for (BlockCodec candidate : {BlockCodec::VarByte, BlockCodec::StreamVByte, BlockCodec::BitPacking})
+    {
+        if (name == codecName(candidate))
+        {
+            codec = candidate;
+            return true;
+        }
+    }
+    return false;
+}
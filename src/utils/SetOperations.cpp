@@ -0,0 +1,419 @@
+#include "utils/SetOperations.hpp"
+#include <algorithm>
+#include <cstring>
+
+// SET_OPERATIONS_NO_SIMD отключает SIMD-пути (проверка скалярных на x86)
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(SET_OPERATIONS_NO_SIMD)
+#include <immintrin.h>
+#define SET_OPERATIONS_X86 1
+#endif
+
+// Векторные ядра обрабатывают входы блоками, пока в обоих списках есть целый
+// блок; хвосты доделывает скалярное слияние. Списки строго возрастают - на этом
+// держится и сравнение "все со всеми", и удаление повторов при объединении.
+
+namespace
+{
+    // ---------- Скалярные ----------
+
+    // Слияние без ветвлений по данным: сдвиги считаются из сравнений
+    size_t intersectScalar(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        size_t i = 0, j = 0, k = 0;
+        while (i < na && j < nb)
+        {
+            uint32_t x = a[i], y = b[j];
+            out[k] = x;
+            k += x == y;
+            i += x <= y;
+            j += y <= x;
+        }
+        return k;
+    }
+
+    // Первая позиция в [from, n) со значением >= target: галоп, затем бинарный поиск
+    size_t gallop(const uint32_t *values, size_t from, size_t n, uint32_t target)
+    {
+        size_t low = from;
+        size_t step = 1;
+        while (low + step < n && values[low + step] < target)
+        {
+            low += step;
+            step *= 2;
+        }
+        return std::lower_bound(values + low, values + std::min(n, low + step + 1), target) - values;
+    }
+
+    // small намного короче large: каждый его элемент ищется галопом
+    size_t intersectGalloping(const uint32_t *small, size_t ns, const uint32_t *large, size_t nl, uint32_t *out)
+    {
+        size_t j = 0, k = 0;
+        for (size_t i = 0; i < ns && j < nl; ++i)
+        {
+            j = gallop(large, j, nl, small[i]);
+            if (j < nl && large[j] == small[i])
+                out[k++] = small[i];
+        }
+        return k;
+    }
+
+    size_t uniteScalar(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        size_t i = 0, j = 0, k = 0;
+        while (i < na && j < nb)
+        {
+            uint32_t x = a[i], y = b[j];
+            out[k++] = x < y ? x : y;
+            i += x <= y;
+            j += y <= x;
+        }
+        std::memcpy(out + k, a + i, (na - i) * sizeof(uint32_t));
+        k += na - i;
+        std::memcpy(out + k, b + j, (nb - j) * sizeof(uint32_t));
+        return k + nb - j;
+    }
+
+    // small намного короче large: участки large между числами small копируются целиком
+    size_t uniteGalloping(const uint32_t *small, size_t ns, const uint32_t *large, size_t nl, uint32_t *out)
+    {
+        size_t j = 0, k = 0;
+        for (size_t i = 0; i < ns; ++i)
+        {
+            size_t next = gallop(large, j, nl, small[i]);
+            std::memcpy(out + k, large + j, (next - j) * sizeof(uint32_t));
+            k += next - j;
+            j = next;
+            out[k++] = small[i];
+            if (j < nl && large[j] == small[i])
+                ++j;
+        }
+        std::memcpy(out + k, large + j, (nl - j) * sizeof(uint32_t));
+        return k + nl - j;
+    }
+
+#ifdef SET_OPERATIONS_X86
+    // Маски перестановки: выбранные битами mask числа блока подряд в начало
+    struct ShuffleTables
+    {
+        alignas(16) uint8_t compact4[16][16];  // pshufb, блок из 4 чисел
+        alignas(32) uint32_t compact8[256][8]; // vpermd, блок из 8 чисел
+
+        ShuffleTables()
+        {
+            for (int mask = 0; mask < 16; ++mask)
+            {
+                int out = 0;
+                std::memset(compact4[mask], 0x80, 16);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    if (mask & (1 << lane))
+                    {
+                        for (int byte = 0; byte < 4; ++byte)
+                            compact4[mask][4 * out + byte] = static_cast<uint8_t>(4 * lane + byte);
+                        ++out;
+                    }
+                }
+            }
+            for (int mask = 0; mask < 256; ++mask)
+            {
+                int out = 0;
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    if (mask & (1 << lane))
+                        compact8[mask][out++] = lane;
+                }
+                while (out < 8)
+                    compact8[mask][out++] = 0;
+            }
+        }
+    };
+
+    const ShuffleTables &shuffleTables()
+    {
+        static const ShuffleTables tables;
+        return tables;
+    }
+
+    // Пересечение блоками по 4: каждое число блока a сравнивается со всеми четырьмя
+    // числами блока b (четыре циклических сдвига), совпавшие сдвигаются в начало
+    // регистра и пишутся разом. Дальше идет тот блок, чей максимум меньше
+    __attribute__((target("sse4.1"))) size_t intersectSse41(const uint32_t *a, size_t na,
+                                                            const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        const ShuffleTables &tables = shuffleTables();
+        const size_t blocksA = na & ~size_t(3);
+        const size_t blocksB = nb & ~size_t(3);
+        size_t i = 0, j = 0, k = 0;
+        if (blocksA > 0 && blocksB > 0)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            while (true)
+            {
+                __m128i equal = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+                    _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                                 _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+                int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+                __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i *>(tables.compact4[mask]));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k), _mm_shuffle_epi8(va, shuffle));
+                k += __builtin_popcount(mask);
+
+                uint32_t maxA = a[i + 3];
+                uint32_t maxB = b[j + 3];
+                if (maxA <= maxB)
+                {
+                    i += 4;
+                    if (i == blocksA)
+                        break;
+                    va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+                }
+                if (maxB <= maxA)
+                {
+                    j += 4;
+                    if (j == blocksB)
+                        break;
+                    vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + j));
+                }
+            }
+        }
+        return k + intersectScalar(a + i, na - i, b + j, nb - j, out + k);
+    }
+
+    // То же блоками по 8: восемь сдвигов блока b через vpermd
+    __attribute__((target("avx2"))) size_t intersectAvx2(const uint32_t *a, size_t na,
+                                                         const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        const ShuffleTables &tables = shuffleTables();
+        const size_t blocksA = na & ~size_t(7);
+        const size_t blocksB = nb & ~size_t(7);
+        size_t i = 0, j = 0, k = 0;
+        if (blocksA > 0 && blocksB > 0)
+        {
+            const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            while (true)
+            {
+                __m256i equal = _mm256_cmpeq_epi32(va, vb);
+                __m256i rotated = vb;
+                for (int r = 1; r < 8; ++r)
+                {
+                    rotated = _mm256_permutevar8x32_epi32(rotated, rotate);
+                    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(va, rotated));
+                }
+                int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+                __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i *>(tables.compact8[mask]));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k), _mm256_permutevar8x32_epi32(va, permutation));
+                k += __builtin_popcount(mask);
+
+                uint32_t maxA = a[i + 7];
+                uint32_t maxB = b[j + 7];
+                if (maxA <= maxB)
+                {
+                    i += 8;
+                    if (i == blocksA)
+                        break;
+                    va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+                }
+                if (maxB <= maxA)
+                {
+                    j += 8;
+                    if (j == blocksB)
+                        break;
+                    vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + j));
+                }
+            }
+        }
+        return k + intersectScalar(a + i, na - i, b + j, nb - j, out + k);
+    }
+
+    // Сортирует битоническую четверку
+    __attribute__((target("sse4.1"))) inline __m128i sortBitonic4(__m128i v)
+    {
+        __m128i swapped = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+        v = _mm_blend_epi16(_mm_min_epu32(v, swapped), _mm_max_epu32(v, swapped), 0xF0);
+        swapped = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_blend_epi16(_mm_min_epu32(v, swapped), _mm_max_epu32(v, swapped), 0xCC);
+    }
+
+    // Слияние двух упорядоченных четверок: low - четыре меньших, high - четыре больших
+    __attribute__((target("sse4.1"))) inline void merge4(__m128i &low, __m128i &high)
+    {
+        __m128i reversed = _mm_shuffle_epi32(high, _MM_SHUFFLE(0, 1, 2, 3));
+        __m128i minimum = _mm_min_epu32(low, reversed);
+        __m128i maximum = _mm_max_epu32(low, reversed);
+        low = sortBitonic4(minimum);
+        high = sortBitonic4(maximum);
+    }
+
+    // Пишет упорядоченную четверку без чисел, равных предыдущему (last - последнее записанное)
+    __attribute__((target("sse4.1"))) inline size_t storeUnique(__m128i v, uint32_t &last, uint32_t *out,
+                                                                const ShuffleTables &tables)
+    {
+        __m128i previous = _mm_alignr_epi8(v, _mm_set1_epi32(static_cast<int>(last)), 12);
+        int duplicates = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, previous)));
+        int keep = ~duplicates & 15;
+        __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i *>(tables.compact4[keep]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(v, shuffle));
+        last = static_cast<uint32_t>(_mm_extract_epi32(v, 3));
+        return __builtin_popcount(keep);
+    }
+
+    // Объединение сетью слияния: в high всегда четыре наибольших из уже взятых чисел,
+    // следующая четверка берется из того списка, чье очередное число меньше;
+    // после слияния четыре меньших гарантированно не меньше всего записанного
+    __attribute__((target("sse4.1"))) size_t uniteSse41(const uint32_t *a, size_t na,
+                                                        const uint32_t *b, size_t nb, uint32_t *out)
+    {
+        if (na < 4 || nb < 4)
+            return uniteScalar(a, na, b, nb, out);
+
+        const ShuffleTables &tables = shuffleTables();
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+        size_t i = 4, j = 4, k = 0;
+        uint32_t last = std::min(a[0], b[0]) - 1; // Заведомо не равно первому числу
+
+        merge4(low, high);
+        k += storeUnique(low, last, out + k, tables);
+        while (i + 4 <= na && j + 4 <= nb)
+        {
+            if (a[i] < b[j])
+            {
+                low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+                i += 4;
+            }
+            else
+            {
+                low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + j));
+                j += 4;
+            }
+            merge4(low, high);
+            k += storeUnique(low, last, out + k, tables);
+        }
+
+        // Хвосты: четыре отложенных числа и остатки обоих списков
+        uint32_t pending[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pending), high);
+        size_t p = 0;
+        while (p < 4 || i < na || j < nb)
+        {
+            uint32_t value;
+            if (p < 4 && (i >= na || pending[p] <= a[i]) && (j >= nb || pending[p] <= b[j]))
+                value = pending[p++];
+            else if (i < na && (j >= nb || a[i] <= b[j]))
+                value = a[i++];
+            else
+                value = b[j++];
+
+            if (value != last)
+            {
+                out[k++] = value;
+                last = value;
+            }
+        }
+        return k;
+    }
+
+    SimdLevel detectLevel()
+    {
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::Avx2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return SimdLevel::Sse41;
+        return SimdLevel::Scalar;
+    }
+#else
+    SimdLevel detectLevel()
+    {
+        return SimdLevel::Scalar;
+    }
+#endif
+}
+
+SimdLevel SetOperations::detectedLevel()
+{
+    static const SimdLevel level = detectLevel();
+    return level;
+}
+
+const char *SetOperations::levelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Avx2:
+        return "avx2";
+    case SimdLevel::Sse41:
+        return "sse4.1";
+    default:
+        return "scalar";
+    }
+}
+
+size_t SetOperations::intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out,
+                                SimdLevel level)
+{
+    if (na > nb)
+        return intersect(b, nb, a, na, out, level);
+    if (na == 0)
+        return 0;
+    if (nb / na >= kGallopingRatio)
+        return intersectGalloping(a, na, b, nb, out);
+
+    level = std::min(level, detectedLevel());
+#ifdef SET_OPERATIONS_X86
+    if (level == SimdLevel::Avx2)
+        return intersectAvx2(a, na, b, nb, out);
+    if (level == SimdLevel::Sse41)
+        return intersectSse41(a, na, b, nb, out);
+#endif
+    return intersectScalar(a, na, b, nb, out);
+}
+
+size_t SetOperations::unite(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out,
+                            SimdLevel level)
+{
+    if (na > nb)
+        return unite(b, nb, a, na, out, level);
+    if (na == 0 || nb / na >= kGallopingRatio)
+        return uniteGalloping(a, na, b, nb, out);
+
+    level = std::min(level, detectedLevel());
+#ifdef SET_OPERATIONS_X86
+    if (level >= SimdLevel::Sse41)
+        return uniteSse41(a, na, b, nb, out);
+#endif
+    return uniteScalar(a, na, b, nb, out);
+}
+
+size_t SetOperations::subtract(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+{
+    size_t i = 0, j = 0, k = 0;
+    if (na > 0 && nb / na >= kGallopingRatio)
+    {
+        // Вычитаемое намного длиннее: ищем в нем каждое число a галопом
+        for (; i < na; ++i)
+        {
+            j = gallop(b, j, nb, a[i]);
+            if (j == nb || b[j] != a[i])
+                out[k++] = a[i];
+        }
+        return k;
+    }
+
+    while (i < na && j < nb)
+    {
+        if (a[i] < b[j])
+            out[k++] = a[i++];
+        else if (b[j] < a[i])
+            ++j;
+        else
+        {
+            ++i;
+            ++j;
+        }
+    }
+    std::memcpy(out + k, a + i, (na - i) * sizeof(uint32_t));
+    return k + na - i;
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "utils/Compression.hpp"
 #include <limits>
+#include <random>
 
 // 1. Тест для маленьких чисел (< 128)
 // Они должны занимать ровно 1 байт и совпадать с самим числом (так как старший бит 0)
@@ -132,4 +133,100 @@ TEST(CompressionTest, SequentialDecodingIntegrity)
             FAIL() << "Mismatch at index " << i << ": expected " << numbers[i] << ", got " << val;
         }
     }
-}
\ No newline at end of file
+}
+
+// ==========================================
+// Блочные кодеки (VarByte, Stream VByte, BP128)
+// ==========================================
+
+const BlockCodec kAllCodecs[] = {BlockCodec::VarByte, BlockCodec::StreamVByte, BlockCodec::BitPacking};
+
+// 8. Блоки любой длины и битовой ширины восстанавливаются без потерь
+TEST(BlockCodecTest, RoundTripsAllWidthsAndLengths)
+{
+    std::mt19937 rng(1);
+    for (BlockCodec codec : kAllCodecs)
+    {
+        for (uint32_t bits = 0; bits <= 32; ++bits)
+        {
+            for (size_t n : {1u, 3u, 4u, 5u, 77u, 127u, 128u})
+            {
+                std::vector<uint32_t> values(n);
+                for (auto &v : values)
+                    v = bits == 0 ? 0 : static_cast<uint32_t>(rng()) >> (32 - bits);
+
+                // Несколько блоков подряд: позиция должна встать точно на следующий
+                std::vector<uint8_t> buffer;
+                Compression::encodeBlock(codec, values.data(), n, buffer);
+                Compression::encodeBlock(codec, values.data(), n, buffer);
+
+                std::vector<uint32_t> first(n), second(n);
+                size_t pos = 0;
+                Compression::decodeBlock(codec, buffer.data(), buffer.size(), pos, first.data(), n);
+                Compression::decodeBlock(codec, buffer.data(), buffer.size(), pos, second.data(), n);
+
+                ASSERT_EQ(first, values) << Compression::codecName(codec) << " bits " << bits << " n " << n;
+                ASSERT_EQ(second, values) << Compression::codecName(codec) << " bits " << bits << " n " << n;
+                EXPECT_EQ(pos, buffer.size());
+            }
+        }
+    }
+}
+
+// 9. Границы длин Stream VByte: 1, 2, 3 и 4 байта на число
+TEST(BlockCodecTest, StreamVByteByteBoundaries)
+{
+    std::vector<uint32_t> values = {0, 255, 256, 65535, 65536, (1u << 24) - 1, 1u << 24,
+                                    std::numeric_limits<uint32_t>::max()};
+    std::vector<uint8_t> buffer;
+    Compression::encodeBlock(BlockCodec::StreamVByte, values.data(), values.size(), buffer);
+
+    // 2 управляющих байта + 1+1+2+2+3+3+4+4 байт данных
+    EXPECT_EQ(buffer.size(), 2u + 20u);
+
+    std::vector<uint32_t> decoded(values.size());
+    size_t pos = 0;
+    Compression::decodeBlock(BlockCodec::StreamVByte, buffer.data(), buffer.size(), pos, decoded.data(), decoded.size());
+    EXPECT_EQ(decoded, values);
+}
+
+// 10. Обрезанные данные не читаются за границей буфера, недостающие числа = 0
+TEST(BlockCodecTest, TruncatedInputIsSafe)
+{
+    std::vector<uint32_t> values(128);
+    for (uint32_t i = 0; i < values.size(); ++i)
+        values[i] = i * 1000 + 7;
+
+    for (BlockCodec codec : kAllCodecs)
+    {
+        std::vector<uint8_t> buffer;
+        Compression::encodeBlock(codec, values.data(), values.size(), buffer);
+
+        for (size_t cut : {size_t(0), size_t(1), buffer.size() / 2, buffer.size() - 1})
+        {
+            std::vector<uint8_t> truncated(buffer.begin(), buffer.begin() + cut);
+            std::vector<uint32_t> decoded(values.size(), 12345);
+            size_t pos = 0;
+            Compression::decodeBlock(codec, truncated.data(), truncated.size(), pos, decoded.data(), decoded.size());
+
+            EXPECT_LE(pos, truncated.size()) << Compression::codecName(codec);
+            EXPECT_EQ(decoded.back(), 0u) << Compression::codecName(codec) << " cut " << cut;
+        }
+    }
+}
+
+// 11. Имена кодеков для командной строки
+TEST(BlockCodecTest, ParsesCodecNames)
+{
+    for (BlockCodec codec : kAllCodecs)
+    {
+        BlockCodec parsed = BlockCodec::VarByte;
+        ASSERT_TRUE(Compression::parseCodec(Compression::codecName(codec), parsed));
+        EXPECT_EQ(parsed, codec);
+        EXPECT_TRUE(Compression::isKnownCodec(static_cast<uint32_t>(codec)));
+    }
+
+    BlockCodec parsed;
+    EXPECT_FALSE(Compression::parseCodec("zip", parsed));
+    EXPECT_FALSE(Compression::isKnownCodec(7));
+}
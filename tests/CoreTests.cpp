@@ -1,6 +1,24 @@
 #include <gtest/gtest.h>
 #include "core/HashMap.hpp"
 #include "core/InvertedIndex.hpp"
+#include "core/TermDictionary.hpp"
+#include "core/ConcurrentInvertedIndex.hpp"
+#include "core/SpimiRuns.hpp"
+#include "core/MappedIndex.hpp"
+#include "core/PostingCursor.hpp"
+#include "core/DocIdIterator.hpp"
+#include "core/BooleanIndex.hpp"
+#include "core/DocIdSet.hpp"
+#include "core/BooleanQuery.hpp"
+#include "utils/SetOperations.hpp"
+#include <memory>
+#include <set>
+#include <random>
+#include <functional>
+#include <cstdio>
+#include <cstddef>
+#include <fstream>
+#include <thread>
 
 // ==========================================
 // Тесты для HashMap
@@ -181,4 +199,1215 @@ TEST(InvertedIndexTest, ReturnsNullForUnknownTerm)
 
     auto postings = index.getPostings("missing");
     EXPECT_EQ(postings, nullptr);
-}
\ No newline at end of file
+}
+
+// ==========================================
+// Тесты для HashMap: открытая адресация
+// ==========================================
+
+// 11. Поиск по std::string_view без создания временной строки
+TEST(HashMapTest, LooksUpByStringView)
+{
+    HashMap<std::string, int> map;
+    map.insert("молоко", 7);
+
+    std::string query = "молоко и хлеб";
+    std::string_view word(query.data(), std::string("молоко").size());
+
+    int *val = map.get(word);
+    ASSERT_NE(val, nullptr);
+    EXPECT_EQ(*val, 7);
+    EXPECT_FALSE(map.contains(std::string_view(query).substr(0, 4)));
+}
+
+// 12. Много строковых ключей: несколько расширений таблицы, ничего не теряется
+TEST(HashMapTest, KeepsAllStringKeysAfterGrowth)
+{
+    HashMap<std::string, size_t> map;
+    const size_t items = 50000;
+
+    for (size_t i = 0; i < items; ++i)
+        map.insert("term" + std::to_string(i), i);
+
+    ASSERT_EQ(map.size(), items);
+
+    size_t visited = 0;
+    map.traverse([&](const std::string &key, const size_t &value)
+                 {
+        EXPECT_EQ(key, "term" + std::to_string(value));
+        visited++; });
+    EXPECT_EQ(visited, items);
+
+    for (size_t i = 0; i < items; i += 997)
+    {
+        const size_t *val = map.get("term" + std::to_string(i));
+        ASSERT_NE(val, nullptr);
+        EXPECT_EQ(*val, i);
+    }
+    EXPECT_EQ(map.get("term" + std::to_string(items)), nullptr);
+}
+
+// 13. Копия и перемещённая таблица независимы и корректны
+TEST(HashMapTest, CopyAndMoveKeepContents)
+{
+    HashMap<std::string, int> map;
+    map.insert("a", 1);
+    map.insert("b", 2);
+
+    HashMap<std::string, int> copy(map);
+    copy.insert("a", 10);
+    EXPECT_EQ(*map.get("a"), 1);
+    EXPECT_EQ(*copy.get("a"), 10);
+
+    HashMap<std::string, int> moved(std::move(map));
+    ASSERT_NE(moved.get("b"), nullptr);
+    EXPECT_EQ(*moved.get("b"), 2);
+    EXPECT_EQ(moved.size(), 2);
+
+    // Перемещённой таблицей можно продолжать пользоваться
+    map.insert("c", 3);
+    EXPECT_EQ(*map.get("c"), 3);
+}
+
+// 14. try_emplace не перезаписывает существующее значение, emplace - перезаписывает
+TEST(HashMapTest, TryEmplaceKeepsExistingValue)
+{
+    HashMap<std::string, std::string> map;
+
+    auto first = map.try_emplace("key", "first");
+    EXPECT_TRUE(first.second);
+
+    auto second = map.try_emplace("key", "second");
+    EXPECT_FALSE(second.second);
+    EXPECT_EQ(*second.first, "first");
+
+    map.emplace("key", "third");
+    EXPECT_EQ(*map.get("key"), "third");
+    EXPECT_EQ(map.size(), 1);
+}
+
+// 15. getOrInsert создает значение по умолчанию и возвращает ссылку на него
+TEST(HashMapTest, GetOrInsertReturnsReference)
+{
+    HashMap<uint32_t, double> map;
+
+    map.getOrInsert(5) += 1.5;
+    map.getOrInsert(5) += 2.0;
+
+    ASSERT_NE(map.get(5), nullptr);
+    EXPECT_DOUBLE_EQ(*map.get(5), 3.5);
+    EXPECT_EQ(map.size(), 1);
+}
+
+// 16. Значения, которые нельзя копировать, переживают рехеш (узлы только перемещаются)
+TEST(HashMapTest, MovesNodesOnRehash)
+{
+    HashMap<std::string, std::unique_ptr<int>> map;
+    for (int i = 0; i < 5000; ++i)
+        map.insert("k" + std::to_string(i), std::make_unique<int>(i));
+
+    ASSERT_EQ(map.size(), 5000);
+    for (int i = 0; i < 5000; i += 101)
+    {
+        auto *val = map.get("k" + std::to_string(i));
+        ASSERT_NE(val, nullptr);
+        EXPECT_EQ(**val, i);
+    }
+}
+
+// ==========================================
+// Тесты для TermDictionary
+// ==========================================
+
+// 17. Номера терминов плотные и выдаются в порядке первого появления
+TEST(TermDictionaryTest, AssignsDenseIds)
+{
+    TermDictionary dict;
+    EXPECT_EQ(dict.getOrAdd("кот"), 0u);
+    EXPECT_EQ(dict.getOrAdd("пес"), 1u);
+    EXPECT_EQ(dict.getOrAdd("кот"), 0u);
+    EXPECT_EQ(dict.size(), 2u);
+
+    EXPECT_EQ(dict.find("пес"), 1u);
+    EXPECT_EQ(dict.find("мышь"), TermDictionary::kNoTerm);
+    EXPECT_EQ(dict.term(1), "пес");
+
+    // Пустой термин - в том числе первым, когда в арене еще нет блоков
+    TermDictionary fresh;
+    EXPECT_EQ(fresh.getOrAdd(""), 0u);
+    EXPECT_EQ(fresh.getOrAdd("кот"), 1u);
+    EXPECT_EQ(fresh.getOrAdd(""), 0u);
+    EXPECT_EQ(fresh.term(0), "");
+    EXPECT_EQ(fresh.find(""), 0u);
+}
+
+// 18. Словарь хранит свою копию строки, а не ссылку на буфер вызывающего
+TEST(TermDictionaryTest, InternsIndependentCopies)
+{
+    TermDictionary dict;
+    std::string buffer = "первое";
+    uint32_t id = dict.getOrAdd(buffer);
+    buffer = "другое";
+
+    EXPECT_EQ(dict.term(id), "первое");
+    EXPECT_EQ(dict.find("первое"), id);
+    EXPECT_EQ(dict.find("другое"), TermDictionary::kNoTerm);
+}
+
+// 19. Строки остаются на месте при росте арены (в том числе очень длинные)
+TEST(TermDictionaryTest, ViewsSurviveArenaGrowth)
+{
+    TermDictionary dict;
+    std::string_view first = dict.term(dict.getOrAdd("начало"));
+
+    for (int i = 0; i < 20000; ++i)
+        dict.getOrAdd("слово" + std::to_string(i));
+
+    std::string huge(100000, 'x');
+    uint32_t hugeId = dict.getOrAdd(huge);
+
+    EXPECT_EQ(first, "начало");
+    EXPECT_EQ(dict.term(hugeId), huge);
+    EXPECT_EQ(dict.find("слово19999"), 20000u);
+}
+
+// 20. Индекс отдает постинги и по слову, и по termId
+TEST(InvertedIndexTest, ResolvesTermIds)
+{
+    InvertedIndex index;
+    index.addTerm("alpha", 3);
+    index.addTerm("beta", 3);
+    index.addTerm("alpha", 7);
+
+    uint32_t alpha = index.getTermId("alpha");
+    ASSERT_NE(alpha, InvertedIndex::kNoTerm);
+    EXPECT_EQ(index.getTerm(alpha), "alpha");
+    EXPECT_EQ(index.getTermCount(), 2u);
+    EXPECT_EQ(index.getPostingsById(alpha).size(), 2u);
+    EXPECT_EQ(index.getPostings("alpha"), &index.getPostingsById(alpha));
+    EXPECT_EQ(index.getTermId("gamma"), InvertedIndex::kNoTerm);
+}
+
+// 21. Сохранение и загрузка сохраняют словарь и постинги
+TEST(InvertedIndexTest, SaveLoadRoundTrip)
+{
+    InvertedIndex index;
+    index.addTerm("кот", 1);
+    index.addTerm("кот", 1);
+    index.addTerm("кот", 300);
+    index.addTerm("дом", 2);
+    index.incrementDocCount();
+    index.incrementDocCount();
+
+    const std::string path = ::testing::TempDir() + "roundtrip_index.bin";
+    ASSERT_TRUE(index.save(path));
+
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.getTotalDocs(), 2u);
+    EXPECT_EQ(loaded.getTermCount(), 2u);
+
+    // Загруженный индекс хранит постинги сжатыми
+    EXPECT_TRUE(loaded.isCompressed());
+    EXPECT_EQ(loaded.getPostings("кот"), nullptr);
+
+    uint32_t catId = loaded.getTermId("кот");
+    ASSERT_NE(catId, InvertedIndex::kNoTerm);
+    PostingsList cat;
+    loaded.decodePostings(catId, cat);
+    ASSERT_EQ(cat.size(), 2u);
+    EXPECT_EQ(cat[0].docId, 1u);
+    EXPECT_EQ(cat[0].termFrequency, 2u);
+    EXPECT_EQ(cat[1].docId, 300u);
+    InvertedIndex::removeFiles(path);
+}
+
+// ==========================================
+// Тесты для ConcurrentInvertedIndex
+// ==========================================
+
+// 22. Несколько потоков дают тот же индекс, что и последовательная индексация
+TEST(ConcurrentInvertedIndexTest, MatchesSequentialIndex)
+{
+    const std::vector<std::string> vocabulary = {"кот", "пес", "дом", "лес", "мир", "сон"};
+    const uint32_t docCount = 400;
+
+    // Документ d: слова vocabulary[(d + k) % 6] для k = 0..(d % 5), первое слово повторяется
+    auto documentTerms = [&](uint32_t docId)
+    {
+        std::vector<std::string_view> terms;
+        for (uint32_t k = 0; k <= docId % 5; ++k)
+            terms.push_back(vocabulary[(docId + k) % vocabulary.size()]);
+        terms.push_back(vocabulary[docId % vocabulary.size()]);
+        return terms;
+    };
+
+    InvertedIndex sequential;
+    for (uint32_t d = 0; d < docCount; ++d)
+    {
+        for (auto term : documentTerms(d))
+            sequential.addTerm(term, d);
+        sequential.incrementDocCount();
+    }
+
+    ConcurrentInvertedIndex concurrent(8);
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < 4; ++t)
+    {
+        workers.emplace_back([&, t]()
+                             {
+            // Поток t берет документы t, t+4, ... в обратном порядке
+            for (uint32_t d = docCount; d-- > 0;)
+            {
+                if (d % 4 != t)
+                    continue;
+                concurrent.addDocument(d, documentTerms(d));
+                concurrent.incrementDocCount();
+            } });
+    }
+    for (auto &w : workers)
+        w.join();
+
+    InvertedIndex merged = concurrent.finalize();
+    EXPECT_EQ(merged.getTotalDocs(), docCount);
+    ASSERT_EQ(merged.getTermCount(), vocabulary.size());
+
+    for (const auto &term : vocabulary)
+    {
+        auto expected = sequential.getPostings(term);
+        auto actual = merged.getPostings(term);
+        ASSERT_NE(actual, nullptr);
+        ASSERT_EQ(actual->size(), expected->size());
+        for (size_t i = 0; i < expected->size(); ++i)
+        {
+            EXPECT_EQ((*actual)[i].docId, (*expected)[i].docId);
+            EXPECT_EQ((*actual)[i].termFrequency, (*expected)[i].termFrequency);
+        }
+    }
+
+    // termId выдаются в лексикографическом порядке
+    for (uint32_t id = 1; id < merged.getTermCount(); ++id)
+        EXPECT_LT(merged.getTerm(id - 1), merged.getTerm(id));
+}
+
+// ==========================================
+// Тесты для SpimiRuns
+// ==========================================
+
+// 23. Слияние прогонов с общими терминами и чередующимися docId
+TEST(SpimiRunsTest, MergesRunsIntoSingleIndex)
+{
+    const std::string dir = ::testing::TempDir() + "spimi_runs_test";
+    const std::string output = ::testing::TempDir() + "spimi_merged.bin";
+
+    SpimiRuns runs(dir);
+
+    InvertedIndex first; // Документы 0 и 2
+    first.addTerm("кот", 0);
+    first.addTerm("кот", 0);
+    first.addTerm("дом", 2);
+    first.addTerm("кот", 2);
+    first.setTotalDocs(2);
+    ASSERT_TRUE(runs.flush(first));
+    EXPECT_EQ(first.getTermCount(), 0u); // Прогон сброшен - память освобождена
+
+    InvertedIndex second; // Документы 1 и 3
+    second.addTerm("кот", 1);
+    second.addTerm("лес", 3);
+    second.setTotalDocs(2);
+    ASSERT_TRUE(runs.flush(second));
+
+    ASSERT_EQ(runs.runCount(), 2u);
+    ASSERT_TRUE(runs.mergeInto(output));
+
+    InvertedIndex merged;
+    ASSERT_TRUE(merged.load(output));
+    EXPECT_EQ(merged.getTotalDocs(), 4u);
+    EXPECT_EQ(merged.getTermCount(), 3u);
+
+    uint32_t catId = merged.getTermId("кот");
+    ASSERT_NE(catId, InvertedIndex::kNoTerm);
+    PostingsList cat;
+    merged.decodePostings(catId, cat);
+    ASSERT_EQ(cat.size(), 3u);
+    EXPECT_EQ(cat[0].docId, 0u);
+    EXPECT_EQ(cat[0].termFrequency, 2u);
+    EXPECT_EQ(cat[1].docId, 1u);
+    EXPECT_EQ(cat[2].docId, 2u);
+
+    // Временные прогоны удалены
+    EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+    // Прогон без файла длин документов не сливается
+    {
+        SpimiRuns broken(dir);
+        InvertedIndex third;
+        third.addTerm("кот", 5);
+        third.setTotalDocs(1);
+        ASSERT_TRUE(broken.flush(third));
+        for (const auto &entry : std::filesystem::directory_iterator(dir))
+        {
+            if (entry.path().extension() == ".docs")
+                std::filesystem::remove(entry.path());
+        }
+        EXPECT_FALSE(broken.mergeInto(output + ".broken"));
+    }
+
+    // Прогон, который не удалось записать, проваливает и слияние
+    {
+        const std::string lostDir = dir + "/lost";
+        SpimiRuns lost(lostDir);
+        std::filesystem::remove(lostDir);
+        InvertedIndex fourth;
+        fourth.addTerm("кот", 0);
+        fourth.setTotalDocs(1);
+        EXPECT_FALSE(lost.flush(fourth));
+        EXPECT_FALSE(lost.mergeInto(output + ".lost"));
+        EXPECT_FALSE(std::filesystem::exists(output + ".lost"));
+    }
+    EXPECT_TRUE(std::filesystem::is_empty(dir));
+    InvertedIndex::removeFiles(output);
+}
+
+// ==========================================
+// Тесты для MappedIndex
+// ==========================================
+
+// 24. Поиск термина в отображенном файле и ленивая распаковка постингов
+TEST(MappedIndexTest, LooksUpTermsLazily)
+{
+    InvertedIndex index;
+    const std::vector<std::string> words = {"яблоко", "груша", "apple", "банан", "zebra"};
+    for (uint32_t doc = 0; doc < 50; ++doc)
+    {
+        for (size_t w = 0; w < words.size(); ++w)
+        {
+            if (doc % (w + 1) == 0)
+                index.addTerm(words[w], doc);
+        }
+        index.incrementDocCount();
+    }
+    index.addTerm("груша", 49);
+
+    const std::string path = ::testing::TempDir() + "mapped_index.bin";
+    ASSERT_TRUE(index.save(path));
+
+    MappedIndex mapped;
+    ASSERT_TRUE(mapped.open(path));
+    EXPECT_EQ(mapped.getTotalDocs(), 50u);
+    EXPECT_EQ(mapped.getTermCount(), words.size());
+
+    for (const auto &word : words)
+    {
+        uint32_t termId = mapped.getTermId(word);
+        ASSERT_NE(termId, MappedIndex::kNoTerm) << word;
+        EXPECT_EQ(mapped.getTerm(termId), word);
+
+        PostingsList decoded;
+        mapped.decodePostings(termId, decoded);
+        const PostingsList &expected = *index.getPostings(word);
+        EXPECT_EQ(mapped.getDocFrequency(termId), expected.size());
+        ASSERT_EQ(decoded.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            EXPECT_EQ(decoded[i].docId, expected[i].docId);
+            EXPECT_EQ(decoded[i].termFrequency, expected[i].termFrequency);
+        }
+    }
+
+    PostingsList missing;
+    EXPECT_FALSE(mapped.getPostings("вишня", missing));
+    EXPECT_EQ(mapped.getTermId("a"), MappedIndex::kNoTerm);
+    EXPECT_EQ(mapped.getTermId("zzz"), MappedIndex::kNoTerm);
+
+    mapped.close();
+    InvertedIndex::removeFiles(path);
+}
+
+// 25. Файл в чужом формате или с испорченным словарем не открывается
+TEST(MappedIndexTest, RejectsUnknownFormat)
+{
+    const std::string path = ::testing::TempDir() + "not_an_index.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::string garbage(256, 'x');
+        out.write(garbage.data(), garbage.size());
+    }
+
+    MappedIndex mapped;
+    EXPECT_FALSE(mapped.open(path));
+    EXPECT_FALSE(mapped.isOpen());
+    EXPECT_FALSE(mapped.open(path + ".missing"));
+
+    InvertedIndex index;
+    EXPECT_FALSE(index.load(path));
+    std::remove(path.c_str());
+
+    // Испорченный словарь: строка термина за пределами области строк, число терминов
+    // с переполнением размера словаря
+    index.addTerm("кот", 0);
+    index.addTerm("пес", 1);
+    ASSERT_TRUE(index.save(path));
+    IndexFileHeader header;
+    {
+        std::ifstream in(path, std::ios::binary);
+        in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    }
+    auto patch = [&](uint64_t offset, const auto &value)
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    ASSERT_TRUE(mapped.open(path));
+    mapped.close();
+
+    const uint64_t termLengthOffset = header.dictionaryOffset + sizeof(IndexTermEntry) + offsetof(IndexTermEntry, termLength);
+    patch(termLengthOffset, uint32_t(1) << 30);
+    EXPECT_FALSE(mapped.open(path));
+    patch(termLengthOffset, uint32_t(std::string("пес").size()));
+
+    IndexFileHeader overflowing = header;
+    overflowing.termCount = UINT64_MAX / sizeof(IndexTermEntry) + 1; // Размер словаря - ровно 2^64
+    patch(0, overflowing);
+    EXPECT_FALSE(mapped.open(path));
+    patch(0, header);
+    EXPECT_TRUE(mapped.open(path));
+    EXPECT_EQ(mapped.getTerm(1), "пес");
+    mapped.close();
+    InvertedIndex::removeFiles(path);
+}
+
+// ==========================================
+// Тесты для PostingCursor
+// ==========================================
+
+// 26. Курсоры по распакованному списку и по сжатым данным проходят одни и те же постинги
+TEST(PostingCursorTest, SameWalkOverListAndCompressed)
+{
+    InvertedIndex index;
+    for (uint32_t doc = 0; doc < 1000; doc += 3)
+    {
+        index.addTerm("кот", doc);
+        if (doc % 2 == 0)
+            index.addTerm("кот", doc);
+    }
+    index.setTotalDocs(1000);
+
+    const std::string path = ::testing::TempDir() + "cursor_index.bin";
+    ASSERT_TRUE(index.save(path));
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+
+    PostingCursor plain = index.openCursor(index.getTermId("кот"));
+    PostingCursor packed = loaded.openCursor(loaded.getTermId("кот"));
+    EXPECT_EQ(plain.size(), packed.size());
+
+    size_t count = 0;
+    for (; !plain.atEnd(); plain.next(), packed.next())
+    {
+        ASSERT_FALSE(packed.atEnd());
+        EXPECT_EQ(packed.docId(), plain.docId());
+        EXPECT_EQ(packed.tf(), plain.tf());
+        count++;
+    }
+    EXPECT_TRUE(packed.atEnd());
+    EXPECT_EQ(packed.docId(), PostingCursor::kEndDoc);
+    EXPECT_EQ(count, plain.size());
+    InvertedIndex::removeFiles(path);
+}
+
+// 27. advance() встает на первый docId >= target и не ходит назад
+TEST(PostingCursorTest, AdvanceSkipsToTarget)
+{
+    PostingsList list = {{2, 1}, {5, 3}, {9, 1}, {40, 2}};
+    PostingCursor cursor(list);
+
+    cursor.advance(5);
+    EXPECT_EQ(cursor.docId(), 5u);
+    EXPECT_EQ(cursor.tf(), 3u);
+
+    cursor.advance(6);
+    EXPECT_EQ(cursor.docId(), 9u);
+
+    cursor.advance(3); // Назад не идем
+    EXPECT_EQ(cursor.docId(), 9u);
+
+    cursor.advance(41);
+    EXPECT_TRUE(cursor.atEnd());
+
+    PostingCursor empty;
+    EXPECT_TRUE(empty.atEnd());
+    EXPECT_EQ(empty.size(), 0u);
+}
+
+// 28. Загруженный индекс занимает заметно меньше памяти, чем распакованный
+TEST(InvertedIndexTest, LoadedIndexStaysCompressed)
+{
+    InvertedIndex index;
+    for (uint32_t doc = 0; doc < 20000; ++doc)
+    {
+        for (uint32_t w = 0; w < 10; ++w)
+        {
+            if (doc % (w + 1) == 0)
+                index.addTerm("слово" + std::to_string(w), doc);
+        }
+        index.incrementDocCount();
+    }
+
+    // Оценка памяти учитывает выделенное под списки, а не только занятое
+    size_t allocated = 0;
+    for (uint32_t w = 0; w < 10; ++w)
+        allocated += index.getPostingsById(index.getTermId("слово" + std::to_string(w))).capacity() * sizeof(Posting);
+    EXPECT_GE(index.memoryUsage(), allocated);
+
+    const std::string path = ::testing::TempDir() + "compressed_index.bin";
+    ASSERT_TRUE(index.save(path));
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+
+    EXPECT_LT(loaded.memoryUsage() * 2, index.memoryUsage());
+
+    // Сохранение загруженного индекса дает тот же файл
+    const std::string copy = ::testing::TempDir() + "compressed_copy.bin";
+    ASSERT_TRUE(loaded.save(copy));
+    MappedIndex original;
+    MappedIndex resaved;
+    ASSERT_TRUE(original.open(path));
+    ASSERT_TRUE(resaved.open(copy));
+    ASSERT_EQ(resaved.getTermCount(), original.getTermCount());
+    for (uint32_t termId = 0; termId < original.getTermCount(); ++termId)
+    {
+        PostingsList a;
+        PostingsList b;
+        original.decodePostings(termId, a);
+        resaved.decodePostings(termId, b);
+        ASSERT_EQ(a.size(), b.size());
+        EXPECT_TRUE(std::equal(a.begin(), a.end(), b.begin(), [](const Posting &x, const Posting &y)
+                               { return x.docId == y.docId && x.termFrequency == y.termFrequency; }));
+    }
+
+    original.close();
+    resaved.close();
+    InvertedIndex::removeFiles(path);
+    InvertedIndex::removeFiles(copy);
+}
+
+// 29. advance() по сжатому списку из многих блоков совпадает с advance() по распакованному
+TEST(PostingCursorTest, AdvanceSkipsCompressedBlocks)
+{
+    InvertedIndex index;
+    for (uint32_t doc = 0; doc < 5000; ++doc)
+    {
+        if (doc % 7 == 0 || doc % 11 == 0)
+        {
+            for (uint32_t k = 0; k <= doc % 3; ++k)
+                index.addTerm("лес", doc);
+        }
+        if (doc == 4321)
+            index.addTerm("одинокий", doc);
+    }
+    index.setTotalDocs(5000);
+
+    const std::string path = ::testing::TempDir() + "skip_index.bin";
+    ASSERT_TRUE(index.save(path));
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+
+    uint32_t termId = loaded.getTermId("лес");
+    ASSERT_GT(loaded.getDocFrequency(termId), 4 * kPostingsBlockSize);
+
+    // Цели с шагами разной длины: внутри блока, через несколько блоков, за концом
+    for (uint32_t step : {1u, 5u, 90u, 700u, 3000u})
+    {
+        PostingCursor plain = index.openCursor(index.getTermId("лес"));
+        PostingCursor packed = loaded.openCursor(termId);
+        for (uint32_t target = 0; target < 5100; target += step)
+        {
+            plain.advance(target);
+            packed.advance(target);
+            ASSERT_EQ(packed.docId(), plain.docId()) << "step " << step << " target " << target;
+            if (!plain.atEnd())
+            {
+                EXPECT_EQ(packed.tf(), plain.tf());
+            }
+        }
+        packed.advance(5100);
+        EXPECT_TRUE(packed.atEnd());
+    }
+
+    PostingCursor single = loaded.openCursor(loaded.getTermId("одинокий"));
+    single.advance(100);
+    EXPECT_EQ(single.docId(), 4321u);
+    single.advance(4322);
+    EXPECT_TRUE(single.atEnd());
+    InvertedIndex::removeFiles(path);
+}
+
+// 30. Индекс, сохраненный любым кодеком, читается одинаково
+TEST(MappedIndexTest, ReadsEveryCodec)
+{
+    InvertedIndex index;
+    for (uint32_t doc = 0; doc < 3000; ++doc)
+    {
+        index.addTerm("частое", doc);
+        for (uint32_t k = 0; k < doc % 40; ++k)
+            index.addTerm("частое", doc);
+        if (doc % 9 == 0)
+            index.addTerm("редкое", doc * 1000);
+    }
+    index.setTotalDocs(3000);
+
+    for (BlockCodec codec : {BlockCodec::VarByte, BlockCodec::StreamVByte, BlockCodec::BitPacking})
+    {
+        const std::string path = ::testing::TempDir() + "codec_index.bin";
+        ASSERT_TRUE(index.save(path, codec));
+
+        MappedIndex mapped;
+        ASSERT_TRUE(mapped.open(path));
+        EXPECT_EQ(mapped.getCodec(), codec);
+
+        for (const char *word : {"частое", "редкое"})
+        {
+            PostingsList decoded;
+            ASSERT_TRUE(mapped.getPostings(word, decoded));
+            const PostingsList &expected = *index.getPostings(word);
+            ASSERT_EQ(decoded.size(), expected.size()) << Compression::codecName(codec);
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                ASSERT_EQ(decoded[i].docId, expected[i].docId) << Compression::codecName(codec);
+                ASSERT_EQ(decoded[i].termFrequency, expected[i].termFrequency) << Compression::codecName(codec);
+            }
+        }
+
+        mapped.close();
+        InvertedIndex::removeFiles(path);
+    }
+}
+
+// 31. Границы TF блоков и термина одинаковы у списка в памяти и у сжатого, и не меньше настоящих TF
+TEST(PostingCursorTest, BlockBoundsCoverTermFrequencies)
+{
+    InvertedIndex index;
+    for (uint32_t doc = 0; doc < 3000; ++doc)
+    {
+        if (doc % 3 == 0)
+        {
+            for (uint32_t k = 0; k <= (doc * 7) % 5; ++k)
+                index.addTerm("река", doc);
+        }
+    }
+    index.setTotalDocs(3000);
+
+    const std::string path = ::testing::TempDir() + "bound_index.bin";
+    ASSERT_TRUE(index.save(path));
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+
+    PostingCursor plain = index.openCursor(index.getTermId("река"));
+    PostingCursor packed = loaded.openCursor(loaded.getTermId("река"));
+    EXPECT_EQ(plain.maxTf(), 5u);
+    EXPECT_EQ(packed.maxTf(), 5u);
+
+    for (uint32_t target = 0; target < 3000; target += 37)
+    {
+        PostingCursor::BlockBound expected = plain.blockBound(target);
+        PostingCursor::BlockBound actual = packed.blockBound(target);
+        ASSERT_EQ(actual.lastDocId, expected.lastDocId) << "target " << target;
+        ASSERT_EQ(actual.maxTf, expected.maxTf) << "target " << target;
+
+        // blockBound не сдвигает курсор
+        PostingCursor probe = loaded.openCursor(loaded.getTermId("река"));
+        probe.advance(target);
+        EXPECT_GE(actual.lastDocId, probe.docId());
+        EXPECT_GE(actual.maxTf, probe.tf());
+        EXPECT_EQ(packed.docId(), 0u);
+    }
+
+    PostingCursor::BlockBound pastEnd = packed.blockBound(2999 + 1);
+    EXPECT_EQ(pastEnd.maxTf, 0u);
+    InvertedIndex::removeFiles(path);
+}
+
+// 32. Дерево итераторов AND/OR/NOT дает те же документы, что и операции над множествами
+TEST(DocIdIteratorTest, TreeMatchesSetOperations)
+{
+    const uint32_t totalDocs = 3000;
+    BooleanIndex index;
+    index.setTotalDocs(totalDocs);
+    std::vector<std::set<uint32_t>> sets(4);
+    const std::vector<std::string> words = {"a", "b", "c", "d"};
+    const uint32_t steps[] = {2, 3, 7, 500};
+    for (size_t w = 0; w < words.size(); ++w)
+    {
+        for (uint32_t doc = w; doc < totalDocs; doc += steps[w])
+        {
+            index.addTerm(words[w], doc);
+            sets[w].insert(doc);
+        }
+    }
+
+    auto term = [&](size_t w)
+    { return index.openIterator(words[w]); };
+    auto list = [](DocIdIteratorPtr a, DocIdIteratorPtr b)
+    {
+        std::vector<DocIdIteratorPtr> operands;
+        operands.push_back(std::move(a));
+        operands.push_back(std::move(b));
+        return operands;
+    };
+    auto setAnd = [](const std::set<uint32_t> &a, const std::set<uint32_t> &b)
+    {
+        std::set<uint32_t> out;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::inserter(out, out.end()));
+        return out;
+    };
+    auto setOr = [](const std::set<uint32_t> &a, const std::set<uint32_t> &b)
+    {
+        std::set<uint32_t> out(a);
+        out.insert(b.begin(), b.end());
+        return out;
+    };
+    auto setNot = [&](const std::set<uint32_t> &a)
+    {
+        std::set<uint32_t> out;
+        for (uint32_t doc = 0; doc < totalDocs; ++doc)
+            if (!a.count(doc))
+                out.insert(doc);
+        return out;
+    };
+    auto check = [](DocIdIteratorPtr iterator, const std::set<uint32_t> &expected)
+    {
+        std::vector<uint32_t> actual = collectDocIds(*iterator);
+        EXPECT_EQ(actual, std::vector<uint32_t>(expected.begin(), expected.end()));
+    };
+
+    // (a & b & d) - вложенный AND раскрывается, первым идет самый короткий список
+    check(std::make_unique<AndIterator>(list(std::make_unique<AndIterator>(list(term(0), term(1))), term(3))),
+          setAnd(setAnd(sets[0], sets[1]), sets[3]));
+    // (a | c) & !b
+    check(std::make_unique<AndIterator>(list(std::make_unique<OrIterator>(list(term(0), term(2))),
+                                             std::make_unique<NotIterator>(term(1), totalDocs))),
+          setAnd(setOr(sets[0], sets[2]), setNot(sets[1])));
+    // !(c | d)
+    check(std::make_unique<NotIterator>(std::make_unique<OrIterator>(list(term(2), term(3))), totalDocs),
+          setNot(setOr(sets[2], sets[3])));
+    // Неизвестное слово - пустой поток, его отрицание - все документы
+    check(index.openIterator("zzz"), {});
+    check(std::make_unique<NotIterator>(index.openIterator("zzz"), totalDocs), setNot({}));
+
+    // advance на дереве не теряет документов
+    DocIdIteratorPtr tree = std::make_unique<OrIterator>(list(std::make_unique<AndIterator>(list(term(0), term(1))), term(3)));
+    std::set<uint32_t> expected = setOr(setAnd(sets[0], sets[1]), sets[3]);
+    for (uint32_t target : {0u, 5u, 6u, 1001u, 2500u, 2999u, 3000u})
+    {
+        tree->advance(target);
+        auto found = expected.lower_bound(target);
+        EXPECT_EQ(tree->docId(), found == expected.end() ? DocIdIterator::kEndDoc : *found) << "target " << target;
+    }
+}
+
+// 33. Ядра SetOperations на каждом доступном уровне совпадают с std::set_*, drain - с обходом по next
+TEST(SetOperationsTest, KernelsMatchStandardAlgorithms)
+{
+    std::mt19937 rng(33);
+    auto randomList = [&](size_t size, uint32_t universe)
+    {
+        std::set<uint32_t> values;
+        while (values.size() < size)
+            values.insert(rng() % universe);
+        return std::vector<uint32_t>(values.begin(), values.end());
+    };
+
+    std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+    if (SetOperations::detectedLevel() >= SimdLevel::Sse41)
+        levels.push_back(SimdLevel::Sse41);
+    if (SetOperations::detectedLevel() >= SimdLevel::Avx2)
+        levels.push_back(SimdLevel::Avx2);
+
+    // Пустые и короче блока списки, равные размеры, соотношения до 1:1000 (галоп)
+    const std::vector<std::pair<size_t, size_t>> sizes = {
+        {0, 0}, {0, 10}, {1, 1}, {3, 5}, {4, 4}, {7, 9}, {8, 8}, {100, 100}, {1000, 1000},
+        {37, 1000}, {10, 5000}, {5, 5000}, {2000, 3}};
+    for (const auto &[na, nb] : sizes)
+    {
+        // Плотная вселенная дает много совпадений, разреженная - почти никаких
+        for (uint32_t universe : {static_cast<uint32_t>(2 * (na + nb) + 1), 1u << 30})
+        {
+            std::vector<uint32_t> a = randomList(na, universe);
+            std::vector<uint32_t> b = randomList(nb, universe);
+            std::vector<uint32_t> expectedAnd, expectedOr, expectedNot;
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expectedAnd));
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expectedOr));
+            std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expectedNot));
+
+            for (SimdLevel level : levels)
+            {
+                SCOPED_TRACE(std::string(SetOperations::levelName(level)) + " " + std::to_string(na) + "x" +
+                             std::to_string(nb) + " universe " + std::to_string(universe));
+                std::vector<uint32_t> out(na + nb + SetOperations::kOutputPadding);
+                out.resize(SetOperations::intersect(a.data(), na, b.data(), nb, out.data(), level));
+                EXPECT_EQ(out, expectedAnd);
+
+                out.assign(na + nb + SetOperations::kOutputPadding, 0);
+                out.resize(SetOperations::unite(a.data(), na, b.data(), nb, out.data(), level));
+                EXPECT_EQ(out, expectedOr);
+            }
+            std::vector<uint32_t> out;
+            SetOperations::subtract(a, b, out);
+            EXPECT_EQ(out, expectedNot);
+        }
+    }
+
+    // Граничные значения: 0 и UINT32_MAX - 1 (kEndDoc в списках не бывает)
+    std::vector<uint32_t> a = {0, 1, 2, 3, 5, UINT32_MAX - 1};
+    std::vector<uint32_t> b = {0, 2, 4, 6, 7, 8, 9, UINT32_MAX - 1};
+    for (SimdLevel level : levels)
+    {
+        std::vector<uint32_t> out(a.size() + b.size() + SetOperations::kOutputPadding);
+        out.resize(SetOperations::unite(a.data(), a.size(), b.data(), b.size(), out.data(), level));
+        EXPECT_EQ(out, std::vector<uint32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, UINT32_MAX - 1}));
+    }
+
+    // drain после нескольких next выдает тот же остаток, что и обход по одному
+    BooleanIndex index;
+    index.setTotalDocs(5000);
+    for (uint32_t doc = 0; doc < 5000; ++doc)
+    {
+        if (doc % 3 == 0)
+            index.addTerm("x", doc);
+        if (doc % 5 == 1)
+            index.addTerm("y", doc);
+        if (doc % 11 == 2)
+            index.addTerm("z", doc);
+    }
+    auto makeTree = [&]()
+    {
+        std::vector<DocIdIteratorPtr> orOperands, andOperands;
+        orOperands.push_back(index.openIterator("x"));
+        orOperands.push_back(index.openIterator("y"));
+        andOperands.push_back(std::make_unique<OrIterator>(std::move(orOperands)));
+        andOperands.push_back(std::make_unique<NotIterator>(index.openIterator("z"), 5000));
+        andOperands.push_back(index.openIterator("x"));
+        return std::make_unique<AndIterator>(std::move(andOperands));
+    };
+    DocIdIteratorPtr stepped = makeTree();
+    DocIdIteratorPtr drained = makeTree();
+    for (int i = 0; i < 7; ++i)
+    {
+        stepped->next();
+        drained->next();
+    }
+    std::vector<uint32_t> expected;
+    for (; !stepped->atEnd(); stepped->next())
+        expected.push_back(stepped->docId());
+    std::vector<uint32_t> actual;
+    drained->drain(actual);
+    EXPECT_EQ(actual, expected);
+    EXPECT_TRUE(drained->atEnd());
+    EXPECT_FALSE(expected.empty());
+
+    // countRemaining считает тот же остаток, не сохраняя его
+    DocIdIteratorPtr counted = makeTree();
+    for (int i = 0; i < 7; ++i)
+        counted->next();
+    EXPECT_EQ(counted->countRemaining(), expected.size());
+    EXPECT_TRUE(counted->atEnd());
+    DocListIterator list(expected.data(), expected.size());
+    list.next();
+    EXPECT_EQ(list.countRemaining(), expected.size() - 1);
+    EXPECT_TRUE(list.atEnd());
+}
+
+// 34. DocIdSet: контейнер по плотности, AND/OR/ANDNOT как у std::set_*, NOT - флагом, меньше простых списков
+TEST(DocIdSetTest, ContainersMatchSetOperations)
+{
+    const uint32_t totalDocs = 300000;
+    std::mt19937 rng(34);
+    auto build = [&](auto pick)
+    {
+        std::vector<uint32_t> docs;
+        for (uint32_t doc = 0; doc < totalDocs; ++doc)
+            if (pick(doc))
+                docs.push_back(doc);
+        return docs;
+    };
+    // Редкие, плотные, отрезками и по всем трем видам вперемешку по блокам
+    std::vector<std::vector<uint32_t>> lists = {
+        build([&](uint32_t) { return rng() % 500 == 0; }),
+        build([&](uint32_t) { return rng() % 3 == 0; }),
+        build([&](uint32_t doc) { return doc % 20000 < 7000; }),
+        build([&](uint32_t doc) { return doc < 65536 ? doc % 7 == 0 : doc < 131072 ? rng() % 2 == 0 : doc % 65536 < 30000; }),
+        {},
+    };
+
+    BooleanIndex index;
+    index.setTotalDocs(totalDocs);
+    std::vector<DocIdSet> sets(lists.size());
+    for (size_t i = 0; i < lists.size(); ++i)
+    {
+        for (uint32_t doc : lists[i])
+        {
+            sets[i].add(doc);
+            index.addTerm("t" + std::to_string(i), doc);
+        }
+        EXPECT_EQ(sets[i].size(), lists[i].size());
+        sets[i].runOptimize();
+        EXPECT_EQ(sets[i].toVector(), lists[i]);
+    }
+    EXPECT_EQ(sets[0].containerType(0), DocIdSet::ContainerType::Array);
+    EXPECT_EQ(sets[1].containerType(0), DocIdSet::ContainerType::Bitmap);
+    EXPECT_EQ(sets[2].containerType(0), DocIdSet::ContainerType::Run);
+
+    // Вставка не по порядку дает то же множество
+    DocIdSet shuffled;
+    std::vector<uint32_t> order = lists[3];
+    std::shuffle(order.begin(), order.end(), rng);
+    for (uint32_t doc : order)
+        shuffled.add(doc);
+    shuffled.add(order[0]);
+    EXPECT_EQ(shuffled.toVector(), lists[3]);
+
+    auto complement = [&](const std::vector<uint32_t> &docs)
+    {
+        std::vector<uint32_t> out;
+        size_t pos = 0;
+        for (uint32_t doc = 0; doc < totalDocs; ++doc)
+        {
+            if (pos < docs.size() && docs[pos] == doc)
+                ++pos;
+            else
+                out.push_back(doc);
+        }
+        return out;
+    };
+    auto materialize = [&](const DocIdSetExpr &expr)
+    { return collectDocIds(*expr.openIterator(totalDocs)); };
+
+    for (size_t i = 0; i < lists.size(); ++i)
+    {
+        for (size_t j = 0; j < lists.size(); ++j)
+        {
+            SCOPED_TRACE(std::to_string(i) + " x " + std::to_string(j));
+            const auto &a = lists[i], &b = lists[j];
+            std::vector<uint32_t> expectedAnd, expectedOr, expectedNot;
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expectedAnd));
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expectedOr));
+            std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expectedNot));
+            EXPECT_EQ(DocIdSet::intersect(sets[i], sets[j]).toVector(), expectedAnd);
+            EXPECT_EQ(DocIdSet::unite(sets[i], sets[j]).toVector(), expectedOr);
+            EXPECT_EQ(DocIdSet::subtract(sets[i], sets[j]).toVector(), expectedNot);
+
+            // Отрицание: флаг разрешается в ANDNOT или по де Моргану
+            DocIdSetExpr x = DocIdSetExpr::reference(sets[i]), y = DocIdSetExpr::reference(sets[j]);
+            DocIdSetExpr notX = DocIdSetExpr::negation(x), notY = DocIdSetExpr::negation(y);
+            EXPECT_EQ(materialize(DocIdSetExpr::conjunction(x, notY)), expectedNot);
+            EXPECT_EQ(materialize(DocIdSetExpr::conjunction(notX, notY)), complement(expectedOr));
+            EXPECT_EQ(materialize(DocIdSetExpr::disjunction(notX, notY)), complement(expectedAnd));
+            DocIdSetExpr orNot = DocIdSetExpr::disjunction(notY, x);
+            EXPECT_TRUE(orNot.complement);
+            std::vector<uint32_t> expectedOrNot;
+            std::vector<uint32_t> notB = complement(b);
+            std::set_union(a.begin(), a.end(), notB.begin(), notB.end(), std::back_inserter(expectedOrNot));
+            EXPECT_EQ(materialize(orNot), expectedOrNot);
+            EXPECT_EQ(orNot.size(totalDocs), expectedOrNot.size());
+        }
+    }
+
+    // advance по контейнерам всех видов
+    DocIdSetIterator iterator(sets[3]);
+    for (uint32_t target : {0u, 6u, 65535u, 65536u, 100000u, 131072u, 131073u, 160000u, 229999u, 299999u, 300000u})
+    {
+        iterator.advance(target);
+        auto found = std::lower_bound(lists[3].begin(), lists[3].end(), target);
+        EXPECT_EQ(iterator.docId(), found == lists[3].end() ? DocIdIterator::kEndDoc : *found) << "target " << target;
+    }
+
+    // Контейнеры меньше простых списков
+    size_t listBytes = 0, setBytes = 0;
+    for (size_t i = 0; i < lists.size(); ++i)
+    {
+        listBytes += lists[i].size() * sizeof(uint32_t);
+        setBytes += sets[i].byteSize();
+    }
+    EXPECT_LT(setBytes, listBytes / 4);
+    for (size_t i = 0; i < lists.size(); ++i)
+        EXPECT_EQ(collectDocIds(*index.openIterator("t" + std::to_string(i))), lists[i]);
+}
+
+// 35. Планировщик: переписывания по правилам, порядок по df, результат как у запроса без плана
+TEST(BooleanPlannerTest, RewritesKeepResults)
+{
+    const uint32_t totalDocs = 2000;
+    BooleanIndex index;
+    index.setTotalDocs(totalDocs);
+    const std::vector<std::string> words = {"a", "b", "c", "rare"};
+    const uint32_t steps[] = {2, 3, 5, 97};
+    for (size_t w = 0; w < words.size(); ++w)
+        for (uint32_t doc = w; doc < totalDocs; doc += steps[w])
+            index.addTerm(words[w], doc);
+
+    using Kind = BooleanNode::Kind;
+    auto term = BooleanNode::makeTerm;
+    auto plan = [&](BooleanNode root)
+    { return BooleanPlanner::plan(std::move(root), index); };
+
+    // (a | b) & rare: редкое слово ведет, OR раскрыт в n-арный
+    BooleanNode p = plan(BooleanNode::makeAnd(BooleanNode::makeOr(BooleanNode::makeOr(term("a"), term("b")), term("c")), term("rare")));
+    ASSERT_EQ(p.kind, Kind::And);
+    EXPECT_EQ(p.children[0].term, "rare");
+    EXPECT_EQ(p.children[1].kind, Kind::Or);
+    EXPECT_EQ(p.children[1].children.size(), 3u);
+
+    // a & !b & c: отрицание - вычитаемое, первым - более редкий c
+    p = plan(BooleanNode::makeAnd(BooleanNode::makeAnd(term("a"), BooleanNode::makeNot(term("b"))), term("c")));
+    ASSERT_EQ(p.kind, Kind::And);
+    ASSERT_EQ(p.children.size(), 2u);
+    EXPECT_EQ(p.children[0].term, "c");
+    ASSERT_EQ(p.excluded.size(), 1u);
+    EXPECT_EQ(p.excluded[0].term, "b");
+
+    // !(a | b): де Морган, AND из одних отрицаний снова сворачивается в NOT(OR)
+    p = plan(BooleanNode::makeNot(BooleanNode::makeOr(term("a"), term("b"))));
+    ASSERT_EQ(p.kind, Kind::Not);
+    EXPECT_EQ(p.children[0].kind, Kind::Or);
+    EXPECT_EQ(p.estimate, totalDocs - (1000u + 667u));
+
+    // a | !b: NOT(b ANDNOT a)
+    p = plan(BooleanNode::makeOr(term("a"), BooleanNode::makeNot(term("b"))));
+    ASSERT_EQ(p.kind, Kind::Not);
+    ASSERT_EQ(p.children[0].kind, Kind::And);
+    EXPECT_EQ(p.children[0].children[0].term, "b");
+    EXPECT_EQ(p.children[0].excluded[0].term, "a");
+
+    // Повторы, двойное отрицание, x & !x и неизвестное слово
+    p = plan(BooleanNode::makeAnd(BooleanNode::makeAnd(term("a"), term("b")),
+                                  BooleanNode::makeAnd(term("b"), BooleanNode::makeNot(BooleanNode::makeNot(term("a"))))));
+    ASSERT_EQ(p.kind, Kind::And);
+    EXPECT_EQ(p.children.size(), 2u);
+    EXPECT_EQ(plan(BooleanNode::makeAnd(term("a"), BooleanNode::makeNot(term("a")))).kind, Kind::Empty);
+    EXPECT_EQ(plan(BooleanNode::makeAnd(term("a"), term("zzz"))).kind, Kind::Empty);
+    EXPECT_EQ(plan(BooleanNode::makeOr(term("a"), term("zzz"))).term, "a");
+    EXPECT_NE(BooleanPlanner::explain(p).find("TERM a"), std::string::npos);
+
+    // Случайные деревья: план (обоими исполнителями) дает то же, что дословное вычисление
+    std::mt19937 rng(35);
+    const std::vector<std::string> leaves = {"a", "b", "c", "rare", "zzz"};
+    std::function<BooleanNode(int)> randomTree = [&](int depth) -> BooleanNode
+    {
+        if (depth == 0 || rng() % 4 == 0)
+            return term(leaves[rng() % leaves.size()]);
+        switch (rng() % 3)
+        {
+        case 0:
+            return BooleanNode::makeNot(randomTree(depth - 1));
+        case 1:
+            return BooleanNode::makeAnd(randomTree(depth - 1), randomTree(depth - 1));
+        default:
+            return BooleanNode::makeOr(randomTree(depth - 1), randomTree(depth - 1));
+        }
+    };
+    std::function<std::vector<bool>(const BooleanNode &)> literal = [&](const BooleanNode &node)
+    {
+        std::vector<bool> member(totalDocs, false);
+        if (node.kind == Kind::Term)
+        {
+            for (uint32_t doc : collectDocIds(*index.openIterator(std::string_view(node.term))))
+                member[doc] = true;
+            return member;
+        }
+        std::vector<bool> left = literal(node.children[0]);
+        if (node.kind == Kind::Not)
+            left.flip();
+        else if (node.kind == Kind::And || node.kind == Kind::Or)
+        {
+            std::vector<bool> right = literal(node.children[1]);
+            for (uint32_t doc = 0; doc < totalDocs; ++doc)
+                left[doc] = node.kind == Kind::And ? left[doc] && right[doc] : left[doc] || right[doc];
+        }
+        return left;
+    };
+
+    for (int i = 0; i < 300; ++i)
+    {
+        BooleanNode tree = randomTree(4);
+        std::vector<bool> member = literal(tree);
+        std::vector<uint32_t> expected;
+        for (uint32_t doc = 0; doc < totalDocs; ++doc)
+            if (member[doc])
+                expected.push_back(doc);
+
+        BooleanNode planned = plan(tree);
+        SCOPED_TRACE(tree.key() + " -> " + planned.key());
+        DocIdSetExpr result = index.evaluate(planned);
+        EXPECT_EQ(collectDocIds(*result.openIterator(totalDocs)), expected);
+        EXPECT_EQ(result.size(totalDocs), expected.size());
+        EXPECT_EQ(collectDocIds(*index.openIterator(planned)), expected);
+    }
+}
+
+// 36. Булев запрос прямо по постингам: индекс в памяти, загруженный и отображенный - как BooleanIndex
+TEST(BooleanPlannerTest, RunsOnCompressedPostings)
+{
+    const uint32_t totalDocs = 5000;
+    InvertedIndex index;
+    BooleanIndex reference;
+    reference.setTotalDocs(totalDocs);
+    const std::vector<std::string> words = {"a", "b", "c", "rare"};
+    const uint32_t steps[] = {2, 3, 5, 97};
+    for (uint32_t doc = 0; doc < totalDocs; ++doc)
+    {
+        for (size_t w = 0; w < words.size(); ++w)
+        {
+            if (doc % steps[w] == w % steps[w])
+            {
+                for (uint32_t k = 0; k <= doc % 3; ++k) // TF булеву поиску не важен
+                    index.addTerm(words[w], doc);
+                reference.addTerm(words[w], doc);
+            }
+        }
+    }
+    index.setTotalDocs(totalDocs);
+
+    const std::string path = ::testing::TempDir() + "boolean_postings.bin";
+    ASSERT_TRUE(index.save(path, BlockCodec::BitPacking));
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    ASSERT_TRUE(loaded.isCompressed());
+    MappedIndex mapped;
+    ASSERT_TRUE(mapped.open(path, false));
+    EXPECT_EQ(mapped.documentFrequency("b"), reference.documentFrequency("b"));
+    EXPECT_EQ(mapped.documentFrequency("zzz"), 0u);
+
+    using Node = BooleanNode;
+    auto term = Node::makeTerm;
+    const std::vector<Node> queries = {
+        Node::makeAnd(Node::makeOr(term("a"), term("b")), term("rare")),
+        Node::makeAnd(Node::makeAnd(term("a"), Node::makeNot(term("b"))), term("c")),
+        Node::makeNot(Node::makeOr(term("c"), term("rare"))),
+        Node::makeOr(term("rare"), Node::makeNot(term("a"))),
+        Node::makeAnd(term("a"), term("zzz")),
+        Node::makeAnd(term("b"), Node::makeNot(term("zzz"))),
+    };
+    for (const Node &query : queries)
+    {
+        SCOPED_TRACE(query.key());
+        std::vector<uint32_t> expected = collectDocIds(*reference.evaluate(BooleanPlanner::plan(query, reference)).openIterator(totalDocs));
+        EXPECT_EQ(collectDocIds(*openBooleanIterator(BooleanPlanner::plan(query, index), index)), expected);
+        EXPECT_EQ(collectDocIds(*openBooleanIterator(BooleanPlanner::plan(query, loaded), loaded)), expected);
+        EXPECT_EQ(collectDocIds(*openBooleanIterator(BooleanPlanner::plan(query, mapped), mapped)), expected);
+    }
+
+    // advance по сжатым блокам
+    std::vector<uint32_t> docs = collectDocIds(*reference.openIterator("c"));
+    DocIdIteratorPtr iterator = mapped.openIterator("c");
+    for (uint32_t target : {0u, 3u, 1000u, 1001u, 4998u, 5000u})
+    {
+        iterator->advance(target);
+        auto found = std::lower_bound(docs.begin(), docs.end(), target);
+        EXPECT_EQ(iterator->docId(), found == docs.end() ? DocIdIterator::kEndDoc : *found) << "target " << target;
+    }
+
+    mapped.close();
+    InvertedIndex::removeFiles(path);
+}
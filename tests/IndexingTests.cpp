@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include "indexing/IndexingPipeline.hpp"
+#include "utils/BoundedQueue.hpp"
+#include <thread>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+// ==========================================
+// Тесты для BoundedQueue
+// ==========================================
+
+// 1. Элементы выходят в порядке добавления, после close() очередь дочитывается до конца
+TEST(BoundedQueueTest, DrainsAfterClose)
+{
+    BoundedQueue<int> queue(4);
+    queue.push(1);
+    queue.push(2);
+    queue.close();
+
+    int value = 0;
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 1);
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_FALSE(queue.push(3));
+}
+
+// 2. Производитель ждет, пока потребитель освободит место
+TEST(BoundedQueueTest, BlocksProducerWhenFull)
+{
+    BoundedQueue<int> queue(2);
+    std::thread producer([&]()
+                         {
+        for (int i = 0; i < 1000; ++i)
+            queue.push(i);
+        queue.close(); });
+
+    int value = 0;
+    int expected = 0;
+    while (queue.pop(value))
+    {
+        EXPECT_EQ(value, expected);
+        expected++;
+    }
+    producer.join();
+    EXPECT_EQ(expected, 1000);
+}
+
+// ==========================================
+// Тесты для IndexingPipeline
+// ==========================================
+
+// Источник из заранее заданного списка документов
+static IndexingPipeline::DocumentSource makeSource(const std::vector<std::string> &pages)
+{
+    return [pages](const std::function<void(RawDocument &)> &callback)
+    {
+        for (uint32_t i = 0; i < pages.size(); ++i)
+        {
+            RawDocument doc;
+            doc.id = i;
+            doc.url = "https://example.com/" + std::to_string(i);
+            doc.html = pages[i];
+            callback(doc);
+        }
+    };
+}
+
+// 3. Индекс не зависит от числа потоков
+TEST(IndexingPipelineTest, SameIndexForAnyThreadCount)
+{
+    std::vector<std::string> pages;
+    for (int i = 0; i < 300; ++i)
+    {
+        std::string page = "<p>common words here</p>";
+        if (i % 3 == 0)
+            page += "<div>fizz fizz</div>";
+        if (i % 5 == 0)
+            page += "<div>buzz</div>";
+        pages.push_back(page);
+    }
+    pages[7] = ""; // Пустая страница: URL есть, документа в индексе нет
+
+    std::vector<std::string> urlsSingle;
+    InvertedIndex single = IndexingPipeline(1).run(makeSource(pages), urlsSingle);
+
+    std::vector<std::string> urlsParallel;
+    InvertedIndex parallel = IndexingPipeline(4, 3).run(makeSource(pages), urlsParallel);
+
+    EXPECT_EQ(urlsParallel, urlsSingle);
+    ASSERT_EQ(urlsParallel.size(), pages.size());
+    EXPECT_EQ(urlsParallel[7], "https://example.com/7");
+
+    EXPECT_EQ(single.getTotalDocs(), pages.size() - 1);
+    EXPECT_EQ(parallel.getTotalDocs(), single.getTotalDocs());
+    ASSERT_EQ(parallel.getTermCount(), single.getTermCount());
+
+    for (uint32_t termId = 0; termId < single.getTermCount(); ++termId)
+    {
+        std::string_view term = single.getTerm(termId);
+        EXPECT_EQ(parallel.getTerm(termId), term);
+
+        const PostingsList &expected = single.getPostingsById(termId);
+        const PostingsList &actual = parallel.getPostingsById(termId);
+        ASSERT_EQ(actual.size(), expected.size()) << term;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            EXPECT_EQ(actual[i].docId, expected[i].docId);
+            EXPECT_EQ(actual[i].termFrequency, expected[i].termFrequency);
+        }
+    }
+
+    auto fizz = parallel.getPostings("fizz");
+    ASSERT_NE(fizz, nullptr);
+    EXPECT_EQ(fizz->size(), 100u);
+    EXPECT_EQ((*fizz)[0].termFrequency, 2u);
+}
+
+
+// 4. С маленьким бюджетом памяти (много прогонов SPIMI) файл индекса тот же
+TEST(IndexingPipelineTest, MemoryBudgetProducesSameIndex)
+{
+    std::vector<std::string> pages;
+    for (int i = 0; i < 200; ++i)
+        pages.push_back("<p>word" + std::to_string(i % 17) + " shared text " + std::to_string(i) + "</p>");
+
+    const std::string inMemoryFile = ::testing::TempDir() + "pipeline_memory.bin";
+    const std::string spimiFile = ::testing::TempDir() + "pipeline_spimi.bin";
+
+    std::vector<std::string> urls;
+    ASSERT_TRUE(IndexingPipeline(2).runToFile(makeSource(pages), urls, inMemoryFile));
+
+    IndexingPipeline bounded(3);
+    bounded.setMemoryBudget(3 * 4096, ::testing::TempDir() + "pipeline_runs");
+    ASSERT_TRUE(bounded.runToFile(makeSource(pages), urls, spimiFile));
+
+    InvertedIndex expected;
+    InvertedIndex actual;
+    ASSERT_TRUE(expected.load(inMemoryFile));
+    ASSERT_TRUE(actual.load(spimiFile));
+
+    EXPECT_EQ(actual.getTotalDocs(), pages.size());
+    EXPECT_EQ(actual.getTotalDocs(), expected.getTotalDocs());
+    ASSERT_EQ(actual.getTermCount(), expected.getTermCount());
+    PostingsList a;
+    PostingsList e;
+    for (uint32_t termId = 0; termId < expected.getTermCount(); ++termId)
+    {
+        ASSERT_EQ(actual.getTerm(termId), expected.getTerm(termId));
+        actual.decodePostings(termId, a);
+        expected.decodePostings(termId, e);
+        ASSERT_EQ(a.size(), e.size());
+        for (size_t i = 0; i < e.size(); ++i)
+        {
+            EXPECT_EQ(a[i].docId, e[i].docId);
+            EXPECT_EQ(a[i].termFrequency, e[i].termFrequency);
+        }
+    }
+
+    // Длины документов из прогонов складываются в ту же статистику
+    ASSERT_EQ(actual.getDocumentStats().size(), expected.getDocumentStats().size());
+    for (uint32_t doc = 0; doc < pages.size(); ++doc)
+        EXPECT_EQ(actual.getDocumentStats().length(doc), expected.getDocumentStats().length(doc));
+    EXPECT_GT(expected.getDocumentStats().length(0), 0u);
+
+    InvertedIndex::removeFiles(inMemoryFile);
+    InvertedIndex::removeFiles(spimiFile);
+}
+// 5. Частоты для закона Ципфа считаются по TF, даже если в файле индекса квантованные вклады
+TEST(IndexingPipelineTest, FrequencyStatsComeFromTermFrequencies)
+{
+    std::vector<std::string> pages;
+    for (int i = 0; i < 120; ++i)
+        pages.push_back("<p>alpha alpha beta word" + std::to_string(i % 7) + "</p>");
+
+    auto readCsv = [](const std::string &path)
+    {
+        std::ifstream in(path);
+        std::stringstream content;
+        content << in.rdbuf();
+        return content.str();
+    };
+
+    const std::string tfFile = ::testing::TempDir() + "pipeline_zipf_tf.bin";
+    const std::string tfCsv = ::testing::TempDir() + "pipeline_zipf_tf.csv";
+    std::vector<std::string> urls;
+    IndexingPipeline tfPipeline(2);
+    tfPipeline.setFrequencyStatsFile(tfCsv);
+    ASSERT_TRUE(tfPipeline.runToFile(makeSource(pages), urls, tfFile));
+    const std::string expected = readCsv(tfCsv);
+    EXPECT_NE(expected.find(",alpha,240\n"), std::string::npos);
+
+    const std::string impactFile = ::testing::TempDir() + "pipeline_zipf_impacts.bin";
+    const std::string impactCsv = ::testing::TempDir() + "pipeline_zipf_impacts.csv";
+    // В раскладке по вкладам openCursor пуст: частоты из нее были бы нулями
+    for (IndexLayout layout : {IndexLayout::DocumentOrdered, IndexLayout::ImpactOrdered})
+    {
+        std::remove(impactCsv.c_str());
+        IndexingPipeline impactPipeline(2);
+        impactPipeline.setImpactBits(8, Bm25Scoring(), layout);
+        impactPipeline.setFrequencyStatsFile(impactCsv);
+        ASSERT_TRUE(impactPipeline.runToFile(makeSource(pages), urls, impactFile));
+        EXPECT_EQ(readCsv(impactCsv), expected);
+
+        // Файл вкладов частот не хранит - выгрузка из него отказывает
+        EXPECT_FALSE(InvertedIndex::exportFrequencyStatsFromFile(impactFile, impactCsv));
+    }
+
+    for (const std::string &path : {tfFile, impactFile})
+    {
+        InvertedIndex::removeFiles(path);
+    }
+    std::remove(tfCsv.c_str());
+    std::remove(impactCsv.c_str());
+}
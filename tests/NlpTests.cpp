@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "nlp/Tokenizer.hpp"
 #include "nlp/HtmlParser.hpp"
+#include "nlp/QueryParser.hpp"
 
 // ==========================================
 // Тесты для Tokenizer
@@ -144,4 +145,47 @@ TEST(HtmlParserTest, HandlesEmptyAndPlainInput)
 
     std::string plain = "Just text";
     EXPECT_EQ(HtmlParser::getCleanText(plain), "Just text ");
-}
\ No newline at end of file
+}
+
+// ==========================================
+// Тесты для QueryParser
+// ==========================================
+
+// 11. Висящий оператор отбрасывается, а не применяется к соседнему слову
+TEST(QueryParserTest, DropsOperatorsWithoutOperand)
+{
+    Lemmatizer lemmatizer;
+    QueryParser parser(lemmatizer);
+    const std::string putin = lemmatizer.lemmatize("путин");
+
+    for (const std::string query : {"путин!", "путин !", "путин &", "| путин", "путин & !", "путин | ! |"})
+    {
+        BooleanNode node = parser.parseBooleanQuery(query);
+        EXPECT_EQ(node.kind, BooleanNode::Kind::Term) << query;
+        EXPECT_EQ(node.term, putin) << query;
+        EXPECT_FALSE(parser.hasBooleanOperators(query)) << query;
+    }
+
+    // Оператор между операндами остается: "путин | ! | газ" = путин | газ
+    BooleanNode node = parser.parseBooleanQuery("путин | ! | газ");
+    EXPECT_EQ(node.key(), BooleanNode::makeOr(BooleanNode::makeTerm(putin),
+                                              BooleanNode::makeTerm(lemmatizer.lemmatize("газ"))).key());
+    EXPECT_TRUE(parser.hasBooleanOperators("путин | ! | газ"));
+}
+
+// 12. Скобки и словесные И/НЕ в заголовке не делают запрос булевым; & | и ! перед словом - делают
+TEST(QueryParserTest, DetectsRealBooleanOperators)
+{
+    Lemmatizer lemmatizer;
+    QueryParser parser(lemmatizer);
+
+    EXPECT_FALSE(parser.hasBooleanOperators("Сбербанк (SBER) отчитался о прибыли"));
+    EXPECT_FALSE(parser.hasBooleanOperators("ЦБ не изменил ставку и прогноз"));
+    EXPECT_FALSE(parser.hasBooleanOperators("путин газ нефть"));
+    EXPECT_FALSE(parser.hasBooleanOperators("()"));
+
+    EXPECT_TRUE(parser.hasBooleanOperators("путин & (газ | нефть) !санкции"));
+    EXPECT_TRUE(parser.hasBooleanOperators("путин !санкции"));
+    EXPECT_TRUE(parser.hasBooleanOperators("газ | нефть"));
+    EXPECT_TRUE(parser.hasBooleanOperators("!(газ)"));
+}
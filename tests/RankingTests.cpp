@@ -1,18 +1,46 @@
 #include <gtest/gtest.h>
 #include "ranking/Scorer.hpp"
 #include "core/InvertedIndex.hpp"
+#include "core/MappedIndex.hpp"
+#include "ranking/ScoreAccumulator.hpp"
+#include "ranking/ImpactIndex.hpp"
+#include "core/BooleanQuery.hpp"
+#include <cstdio>
+#include <random>
 
 // Хелпер для быстрой настройки индекса
 class RankingTest : public ::testing::Test
 {
 protected:
     InvertedIndex index;
+    std::vector<std::string> indexFiles;
 
     void SetUp() override
     {
         // По умолчанию ничего не делаем, настраиваем в каждом тесте
     }
 
+    // Файлы индексов удаляются вместе с длинами документов, даже если тест прервал ASSERT
+    void TearDown() override
+    {
+        for (const auto &path : indexFiles)
+            InvertedIndex::removeFiles(path);
+    }
+
+    // Путь к файлу индекса во временном каталоге; файл удаляется после теста
+    std::string indexPath(const std::string &name)
+    {
+        indexFiles.push_back(::testing::TempDir() + name);
+        return indexFiles.back();
+    }
+
+    // Сохраняет index в файл name и отображает его в память
+    bool saveAndMap(const std::string &name, MappedIndex &mapped)
+    {
+        const std::string path = indexPath(name);
+        return index.save(path) && mapped.open(path);
+    }
+
     // Вспомогательный метод: устанавливаем N документов в индексе
     void setDocCount(size_t n)
     {
@@ -187,4 +215,802 @@ TEST_F(RankingTest, ResultsAreSortedDescending)
     // Проверка математики сортировки
     EXPECT_GT(results[0].score, results[1].score);
     EXPECT_GT(results[1].score, results[2].score);
-}
\ No newline at end of file
+}
+
+// 8. Поиск по индексу, отображенному в память, совпадает с поиском в памяти
+TEST_F(RankingTest, MappedIndexGivesSameResults)
+{
+    setDocCount(20);
+    for (uint32_t doc = 0; doc < 20; ++doc)
+    {
+        index.addTerm("common", doc);
+        if (doc % 3 == 0)
+            index.addTerm("rare", doc);
+        for (uint32_t k = 0; k < doc % 4; ++k)
+            index.addTerm("common", doc);
+    }
+
+    MappedIndex mapped;
+    ASSERT_TRUE(saveAndMap("ranking_mapped.bin", mapped));
+
+    std::vector<std::string> query = {"common", "rare", "missing"};
+    auto expected = Scorer::search(query, index);
+    auto actual = Scorer::search(query, mapped);
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(actual[i].docId, expected[i].docId);
+        EXPECT_DOUBLE_EQ(actual[i].score, expected[i].score);
+    }
+
+}
+// 9. Загруженный (сжатый) индекс ранжирует так же, как построенный в памяти
+TEST_F(RankingTest, CompressedIndexGivesSameResults)
+{
+    setDocCount(30);
+    for (uint32_t doc = 0; doc < 30; ++doc)
+    {
+        index.addTerm("кот", doc);
+        if (doc % 4 == 1)
+            index.addTerm("пес", doc);
+        for (uint32_t k = 0; k < doc % 3; ++k)
+            index.addTerm("кот", doc);
+    }
+
+    const std::string path = indexPath("ranking_compressed.bin");
+    ASSERT_TRUE(index.save(path));
+
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    ASSERT_TRUE(loaded.isCompressed());
+
+    std::vector<std::string> query = {"кот", "пес"};
+    const std::vector<uint32_t> allowed = {1, 2, 5, 9, 13, 28};
+    for (const std::vector<uint32_t> *filter : {static_cast<const std::vector<uint32_t> *>(nullptr), &allowed})
+    {
+        auto expected = Scorer::search(query, index, filter);
+        auto actual = Scorer::search(query, loaded, filter);
+
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            EXPECT_EQ(actual[i].docId, expected[i].docId);
+            EXPECT_DOUBLE_EQ(actual[i].score, expected[i].score);
+        }
+    }
+}
+
+// 10. topK возвращает ровно начало полной выдачи, при равных скорах - по docId
+TEST_F(RankingTest, TopKMatchesPrefixOfFullRanking)
+{
+    setDocCount(500);
+    for (uint32_t doc = 0; doc < 500; ++doc)
+    {
+        // Много документов с одинаковым TF - много равных скоров
+        for (uint32_t k = 0; k <= doc % 7; ++k)
+            index.addTerm("кот", doc);
+        if (doc % 5 == 0)
+            index.addTerm("дом", doc);
+    }
+
+    std::vector<std::string> query = {"кот", "дом"};
+    auto full = Scorer::search(query, index);
+    ASSERT_EQ(full.size(), 500u);
+    for (size_t i = 1; i < full.size(); ++i)
+    {
+        ASSERT_TRUE(full[i - 1].score > full[i].score ||
+                    (full[i - 1].score == full[i].score && full[i - 1].docId < full[i].docId));
+    }
+
+    for (size_t k : {1u, 10u, 77u, 499u, 500u, 1000u})
+    {
+        auto top = Scorer::search(query, index, nullptr, k);
+        ASSERT_EQ(top.size(), std::min(k, full.size()));
+        for (size_t i = 0; i < top.size(); ++i)
+        {
+            EXPECT_EQ(top[i].docId, full[i].docId) << "k " << k << " i " << i;
+            EXPECT_DOUBLE_EQ(top[i].score, full[i].score);
+        }
+    }
+}
+
+// 11. Большая коллекция считается по диапазонам docId - результат тот же, что и по определению
+TEST_F(RankingTest, PartitionedScoringMatchesDefinition)
+{
+    const uint32_t docCount = 100000;
+    setDocCount(docCount);
+    std::vector<double> tfA(docCount, 0), tfB(docCount, 0);
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        if (doc % 3 == 0)
+        {
+            index.addTerm("альфа", doc);
+            tfA[doc]++;
+        }
+        if (doc % 7 == 0 || doc > 90000)
+        {
+            for (uint32_t k = 0; k <= doc % 4; ++k)
+            {
+                index.addTerm("бета", doc);
+                tfB[doc]++;
+            }
+        }
+    }
+
+    double idfA = std::log((double)docCount / index.getPostings("альфа")->size());
+    double idfB = std::log((double)docCount / index.getPostings("бета")->size());
+
+    std::vector<uint32_t> allowedDocs;
+    for (uint32_t doc = 5; doc < docCount; doc += 11)
+        allowedDocs.push_back(doc);
+    const std::vector<uint32_t> &allowed = allowedDocs;
+
+    for (const std::vector<uint32_t> *filter : {static_cast<const std::vector<uint32_t> *>(nullptr), &allowed})
+    {
+        auto results = BasicScorer<TfIdfScoring>::search({"альфа", "бета"}, index, filter);
+
+        size_t expectedCount = 0;
+        for (uint32_t doc = 0; doc < docCount; ++doc)
+        {
+            bool passes = !filter || std::binary_search(filter->begin(), filter->end(), doc);
+            if (passes && (tfA[doc] > 0 || tfB[doc] > 0))
+                expectedCount++;
+        }
+        ASSERT_EQ(results.size(), expectedCount);
+
+        for (const auto &result : results)
+            ASSERT_NEAR(result.score, tfA[result.docId] * idfA + tfB[result.docId] * idfB, 1e-9);
+        for (size_t i = 1; i < results.size(); ++i)
+            ASSERT_FALSE(results[i].score > results[i - 1].score);
+    }
+}
+
+// 12. Аккумулятор переиспользуется между запросами без очистки массива
+TEST(ScoreAccumulatorTest, ResetForgetsPreviousQuery)
+{
+    ScoreAccumulator<float> accumulator;
+    accumulator.reset(10);
+    accumulator.add(3, 1.5f);
+    accumulator.add(3, 2.0f);
+    accumulator.add(7, 1.0f);
+    EXPECT_EQ(accumulator.size(), 2u);
+
+    accumulator.reset(10);
+    accumulator.add(7, 0.5f);
+    accumulator.add(25, 4.0f); // За пределами reset() - массив растет сам
+
+    std::vector<std::pair<uint32_t, float>> seen;
+    accumulator.traverse([&](uint32_t docId, float score)
+                         { seen.push_back({docId, score}); });
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0].first, 7u);
+    EXPECT_FLOAT_EQ(seen[0].second, 0.5f);
+    EXPECT_EQ(seen[1].first, 25u);
+    EXPECT_FLOAT_EQ(seen[1].second, 4.0f);
+}
+
+// 13. WAND, Block-Max WAND и MaxScore дают ровно тот же top-k, что и полный обход, но считают меньше постингов
+TEST_F(RankingTest, DynamicPruningMatchesExhaustiveTopK)
+{
+    const uint32_t docCount = 20000;
+    setDocCount(docCount);
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<uint32_t> tf(1, 3);
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        // Частое слово с малым TF, среднее и редкое с большим TF в отдельных документах
+        for (uint32_t k = tf(rng); k > 0; --k)
+            index.addTerm("и", doc);
+        if (doc % 9 == 0)
+            index.addTerm("кот", doc);
+        if (doc % 9 == 0 && doc % 2 == 0)
+            index.addTerm("кот", doc);
+        if (doc % 301 == 0)
+            for (uint32_t k = 0; k < 1 + doc % 5; ++k)
+                index.addTerm("тигр", doc);
+    }
+
+    const std::string path = indexPath("ranking_wand.bin");
+    ASSERT_TRUE(index.save(path));
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    MappedIndex mapped;
+    ASSERT_TRUE(mapped.open(path));
+
+    std::vector<uint32_t> allowedDocs;
+    for (uint32_t doc = 0; doc < docCount; doc += 3)
+        allowedDocs.push_back(doc);
+    const std::vector<uint32_t> &allowed = allowedDocs;
+
+    const std::vector<std::vector<std::string>> queries = {
+        {"и", "кот", "тигр"}, {"тигр", "и"}, {"кот", "кот", "и"}, {"и"}, {"тигр", "собака"}};
+    for (const auto &query : queries)
+    {
+        for (const std::vector<uint32_t> *filter : {static_cast<const std::vector<uint32_t> *>(nullptr), &allowed})
+        {
+            for (size_t k : {1u, 10u, 100u})
+            {
+                SearchStats exhaustiveStats;
+                auto expected = Scorer::search(query, index, filter, k, QueryStrategy::Exhaustive, &exhaustiveStats);
+
+                for (QueryStrategy strategy : {QueryStrategy::Wand, QueryStrategy::BlockMaxWand, QueryStrategy::MaxScore})
+                {
+                    SearchStats stats;
+                    auto fromMemory = Scorer::search(query, index, filter, k, strategy, &stats);
+                    auto fromLoaded = Scorer::search(query, loaded, filter, k, strategy);
+                    auto fromMapped = Scorer::search(query, mapped, filter, k, strategy);
+                    EXPECT_LE(stats.postingsScored, exhaustiveStats.postingsScored);
+
+                    for (const auto *actual : {&fromMemory, &fromLoaded, &fromMapped})
+                    {
+                        ASSERT_EQ(actual->size(), expected.size());
+                        for (size_t i = 0; i < expected.size(); ++i)
+                        {
+                            EXPECT_EQ((*actual)[i].docId, expected[i].docId) << query[0] << " k " << k << " i " << i
+                                                                  << " strategy " << static_cast<int>(strategy);
+                            EXPECT_EQ((*actual)[i].score, expected[i].score);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // На частом слове с редким отсечение должно пропускать большую часть постингов
+    SearchStats exhaustiveStats, blockMaxStats;
+    Scorer::search({"и", "тигр"}, mapped, nullptr, 10, QueryStrategy::Exhaustive, &exhaustiveStats);
+    Scorer::search({"и", "тигр"}, mapped, nullptr, 10, QueryStrategy::BlockMaxWand, &blockMaxStats);
+    EXPECT_LT(blockMaxStats.postingsScored * 4, exhaustiveStats.postingsScored);
+
+}
+
+// 14. Длинный запрос из частых слов и одного редкого: MaxScore почти не трогает частые списки
+TEST_F(RankingTest, MaxScoreSkipsLowImpactTerms)
+{
+    const uint32_t docCount = 10000;
+    setDocCount(docCount);
+    const std::vector<std::string> common = {"в", "на", "и", "с", "по", "из", "за", "о"};
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        for (size_t w = 0; w < common.size(); ++w)
+        {
+            if ((doc + w) % (w + 2) != 0)
+                index.addTerm(common[w], doc);
+        }
+        if (doc % 97 == 0)
+        {
+            index.addTerm("биржа", doc);
+            index.addTerm("биржа", doc);
+        }
+    }
+
+    std::vector<std::string> query = common;
+    query.push_back("биржа");
+
+    SearchStats exhaustiveStats, maxScoreStats;
+    auto expected = Scorer::search(query, index, nullptr, 10, QueryStrategy::Exhaustive, &exhaustiveStats);
+    auto actual = Scorer::search(query, index, nullptr, 10, QueryStrategy::MaxScore, &maxScoreStats);
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(actual[i].docId, expected[i].docId);
+        EXPECT_EQ(actual[i].score, expected[i].score);
+    }
+    EXPECT_LT(maxScoreStats.postingsScored * 10, exhaustiveStats.postingsScored);
+}
+
+// 15. BM25 по определению: длинный документ с тем же TF ниже короткого, k1 и b настраиваются
+TEST_F(RankingTest, Bm25NormalizesByDocumentLength)
+{
+    setDocCount(4);
+    index.addTerm("кот", 0); // Короткий документ: "кот"
+    for (int i = 0; i < 9; ++i)
+        index.addTerm("шум", 1); // Длинный: "кот" + 9 слов
+    index.addTerm("кот", 1);
+    index.addTerm("пес", 2);
+    index.addTerm("пес", 3);
+    index.addTerm("пес", 3);
+
+    const double k1 = 1.5, b = 0.6;
+    auto results = Scorer::search({"кот", "пес"}, index, nullptr, Scorer::kAllResults,
+                                  QueryStrategy::Exhaustive, nullptr, Bm25Scoring(k1, b));
+    ASSERT_EQ(results.size(), 4u);
+
+    const double lengths[4] = {1, 10, 1, 2};
+    const double average = (1 + 10 + 1 + 2) / 4.0;
+    auto bm25 = [&](double tf, double df, uint32_t doc)
+    {
+        double idf = std::log(1.0 + (4 - df + 0.5) / (df + 0.5));
+        return idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * lengths[doc] / average));
+    };
+    const double expected[4] = {bm25(1, 2, 0), bm25(1, 2, 1), bm25(1, 2, 2), bm25(2, 2, 3)};
+    for (const auto &result : results)
+        EXPECT_NEAR(result.score, expected[result.docId], 1e-12) << "doc " << result.docId;
+
+    auto scoreOf = [&](uint32_t doc)
+    {
+        for (const auto &result : results)
+            if (result.docId == doc)
+                return result.score;
+        return 0.0;
+    };
+    EXPECT_GT(scoreOf(0), scoreOf(1));
+    EXPECT_DOUBLE_EQ(index.getDocumentStats().averageLength(), average);
+    EXPECT_EQ(index.getDocumentStats().minLength(), 1u);
+
+    // Наименьшая длина - по итоговым длинам, а не по промежуточным во время индексации
+    DocumentStats grown;
+    grown.addTokens(0);
+    grown.addTokens(0, 4);
+    grown.addTokens(1, 3);
+    EXPECT_EQ(grown.minLength(), 3u);
+    grown.addTokens(2, 2);
+    EXPECT_EQ(grown.minLength(), 2u);
+    grown.recount();
+    EXPECT_EQ(grown.minLength(), 2u);
+    EXPECT_DOUBLE_EQ(grown.averageLength(), 10 / 3.0);
+
+    // b = 0: длина не учитывается
+    auto flat = Scorer::search({"кот"}, index, nullptr, Scorer::kAllResults,
+                               QueryStrategy::Exhaustive, nullptr, Bm25Scoring(k1, 0.0));
+    ASSERT_EQ(flat.size(), 2u);
+    EXPECT_DOUBLE_EQ(flat[0].score, flat[1].score);
+}
+
+// 16. Длины документов сохраняются рядом с индексом; без них BM25 считает все документы средними
+TEST_F(RankingTest, DocumentStatsPersistNextToIndex)
+{
+    setDocCount(50);
+    for (uint32_t doc = 0; doc < 50; ++doc)
+    {
+        index.addTerm("кот", doc);
+        for (uint32_t k = 0; k < doc % 13; ++k)
+            index.addTerm(doc % 2 ? "пес" : "дом", doc);
+    }
+
+    const std::string path = indexPath("ranking_docstats.bin");
+    ASSERT_TRUE(index.save(path));
+
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    ASSERT_EQ(loaded.getDocumentStats().size(), 50u);
+    for (uint32_t doc = 0; doc < 50; ++doc)
+        EXPECT_EQ(loaded.getDocumentStats().length(doc), 1 + doc % 13);
+
+    uint32_t termId = loaded.getTermId("пес");
+    EXPECT_DOUBLE_EQ(loaded.getIdf(termId), DocumentStats::idf(50, loaded.getDocFrequency(termId)));
+
+    std::vector<std::string> query = {"кот", "пес"};
+    auto expected = Scorer::search(query, index);
+    auto actual = Scorer::search(query, loaded);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(actual[i].docId, expected[i].docId);
+        EXPECT_EQ(actual[i].score, expected[i].score);
+    }
+
+    // Индекс без файла длин по-прежнему открывается
+    std::remove(DocumentStats::pathFor(path).c_str());
+    MappedIndex mapped;
+    ASSERT_TRUE(mapped.open(path));
+    EXPECT_TRUE(mapped.getDocumentStats().empty());
+    auto unnormalized = Scorer::search({"кот"}, mapped);
+    ASSERT_EQ(unnormalized.size(), 50u);
+    EXPECT_DOUBLE_EQ(unnormalized.front().score, unnormalized.back().score);
+}
+
+// 17. Индекс квантованных вкладов: целочисленный поиск близок к BM25, а стратегии совпадают между собой
+TEST_F(RankingTest, QuantizedImpactsApproximateBm25)
+{
+    const uint32_t docCount = 3000;
+    setDocCount(docCount);
+    std::mt19937 rng(17);
+    const std::vector<std::string> words = {"кот", "пес", "дом", "лес", "река"};
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        size_t length = 5 + rng() % 60;
+        for (size_t i = 0; i < length; ++i)
+            index.addTerm(words[std::min<size_t>(rng() % 16, words.size() - 1)], doc);
+    }
+
+    const std::string tfPath = indexPath("ranking_tf.bin");
+    const std::string impactPath = indexPath("ranking_impacts.bin");
+    ASSERT_TRUE(index.save(tfPath));
+    EXPECT_FALSE(ImpactIndex::build(tfPath, impactPath, 0));
+    ASSERT_TRUE(ImpactIndex::build(tfPath, impactPath, 12));
+    EXPECT_FALSE(ImpactIndex::build(impactPath, tfPath + ".again", 8)); // Уже с вкладами
+
+    MappedIndex impacts;
+    ASSERT_TRUE(impacts.open(impactPath));
+    ASSERT_TRUE(impacts.hasImpacts());
+    EXPECT_EQ(impacts.getImpactBits(), 12u);
+
+    // Вклад постинга - округленный BM25 в квантах
+    uint32_t termId = impacts.getTermId("лес");
+    PostingCursor tf = index.openCursor(index.getTermId("лес"));
+    PostingCursor impact = impacts.openCursor(termId);
+    Bm25Scoring bm25;
+    bm25.prepare(index);
+    for (; !tf.atEnd(); tf.next(), impact.next())
+    {
+        ASSERT_EQ(impact.docId(), tf.docId());
+        double exact = bm25.score(tf.docId(), tf.tf(), index.getIdf(index.getTermId("лес")));
+        EXPECT_NEAR(impact.tf() * impacts.getImpactScale(), exact, impacts.getImpactScale());
+    }
+
+    // Модель должна подходить индексу
+    std::vector<std::string> query = {"кот", "лес", "река"};
+    EXPECT_TRUE(Scorer::search(query, impacts).empty());
+    EXPECT_TRUE(BasicScorer<ImpactScoring>::search(query, index).empty());
+
+    auto exact = Scorer::search(query, index, nullptr, 20);
+    auto quantized = BasicScorer<ImpactScoring>::search(query, impacts, nullptr, 20);
+    ASSERT_EQ(quantized.size(), 20u);
+    size_t overlap = 0;
+    for (const auto &result : quantized)
+    {
+        for (const auto &reference : exact)
+            overlap += result.docId == reference.docId;
+    }
+    EXPECT_GE(overlap, 18u);
+
+    for (QueryStrategy strategy : {QueryStrategy::Wand, QueryStrategy::BlockMaxWand, QueryStrategy::MaxScore})
+    {
+        auto pruned = BasicScorer<ImpactScoring>::search(query, impacts, nullptr, 20, strategy);
+        ASSERT_EQ(pruned.size(), quantized.size());
+        for (size_t i = 0; i < pruned.size(); ++i)
+        {
+            EXPECT_EQ(pruned[i].docId, quantized[i].docId);
+            EXPECT_EQ(pruned[i].score, quantized[i].score);
+        }
+    }
+}
+
+// 18. Раскладка по вкладам: anytime-подсчет без бюджета совпадает с ImpactScoring, бюджет ограничивает работу
+TEST_F(RankingTest, ImpactOrderedAnytimeMatchesImpactScoring)
+{
+    const uint32_t docCount = 3000;
+    setDocCount(docCount);
+    std::mt19937 rng(18);
+    const std::vector<std::string> words = {"кот", "пес", "дом", "лес", "река"};
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        size_t length = 5 + rng() % 60;
+        for (size_t i = 0; i < length; ++i)
+            index.addTerm(words[std::min<size_t>(rng() % 16, words.size() - 1)], doc);
+    }
+
+    const std::string tfPath = indexPath("anytime_tf.bin");
+    const std::string impactPath = indexPath("anytime_impacts.bin");
+    const std::string orderedPath = indexPath("anytime_ordered.bin");
+    const std::string resavedPath = indexPath("anytime_resaved.bin");
+    ASSERT_TRUE(index.save(tfPath));
+    EXPECT_FALSE(index.save(orderedPath, BlockCodec::VarByte, IndexLayout::ImpactOrdered)); // Нет вкладов
+    ASSERT_TRUE(ImpactIndex::build(tfPath, impactPath, 8));
+    ASSERT_TRUE(ImpactIndex::build(tfPath, orderedPath, 8, BlockCodec::StreamVByte, Bm25Scoring(), IndexLayout::ImpactOrdered));
+
+    // Тот же индекс через InvertedIndex::save
+    InvertedIndex loaded;
+    ASSERT_TRUE(loaded.load(impactPath));
+    ASSERT_TRUE(loaded.save(resavedPath, BlockCodec::VarByte, IndexLayout::ImpactOrdered));
+    EXPECT_FALSE(InvertedIndex().load(orderedPath));
+
+    MappedIndex impacts, ordered;
+    ASSERT_TRUE(impacts.open(impactPath));
+    ASSERT_TRUE(ordered.open(orderedPath));
+    ASSERT_TRUE(ordered.isImpactOrdered());
+    EXPECT_FALSE(impacts.isImpactOrdered());
+
+    // Сегменты - по убыванию вклада, с теми же постингами, что и в обычной раскладке
+    for (uint32_t termId = 0; termId < ordered.getTermCount(); ++termId)
+    {
+        EXPECT_TRUE(ordered.openCursor(termId).atEnd());
+        std::vector<std::pair<uint32_t, uint32_t>> expected, actual;
+        for (PostingCursor cursor = impacts.openCursor(termId); !cursor.atEnd(); cursor.next())
+            expected.emplace_back(cursor.docId(), cursor.tf());
+
+        ImpactSegments segments = ordered.openSegments(termId);
+        for (uint32_t s = 0; s < segments.size(); ++s)
+        {
+            uint32_t impact = segments.segment(s).impact;
+            if (s > 0)
+            {
+                EXPECT_LT(impact, segments.segment(s - 1).impact);
+            }
+            segments.forEachBlock(s, [&](const uint32_t *docIds, uint32_t count)
+                                  {
+                for (uint32_t i = 0; i < count; ++i)
+                    actual.emplace_back(docIds[i], impact);
+                return true; });
+        }
+        std::sort(actual.begin(), actual.end());
+        EXPECT_EQ(actual, expected);
+    }
+
+    std::vector<std::string> query = {"кот", "лес", "река", "лес"};
+    EXPECT_TRUE(AnytimeScorer::search(query, impacts, 20).empty());
+    EXPECT_TRUE(BasicScorer<ImpactScoring>::search(query, ordered, nullptr, 20).empty());
+
+    size_t totalPostings = 0;
+    for (size_t topK : {AnytimeScorer::kAllResults, (size_t)20})
+    {
+        auto reference = BasicScorer<ImpactScoring>::search(query, impacts, nullptr, topK);
+        SearchStats stats;
+        auto anytime = AnytimeScorer::search(query, ordered, topK, AnytimeBudget(), &stats);
+        EXPECT_FALSE(stats.budgetExhausted);
+        ASSERT_EQ(anytime.size(), reference.size());
+        for (size_t i = 0; i < anytime.size(); ++i)
+        {
+            EXPECT_EQ(anytime[i].docId, reference[i].docId);
+            EXPECT_EQ(anytime[i].score, reference[i].score);
+        }
+        totalPostings = stats.postingsScored;
+    }
+
+    MappedIndex resaved;
+    ASSERT_TRUE(resaved.open(resavedPath));
+    auto fromSave = AnytimeScorer::search(query, resaved, 20);
+    auto fromBuild = AnytimeScorer::search(query, ordered, 20);
+    ASSERT_EQ(fromSave.size(), fromBuild.size());
+    for (size_t i = 0; i < fromSave.size(); ++i)
+        EXPECT_EQ(fromSave[i].docId, fromBuild[i].docId);
+
+    // Бюджет постингов: считается ровно столько, и первыми - самые весомые
+    AnytimeBudget budget;
+    budget.maxPostings = totalPostings / 4;
+    SearchStats stats;
+    auto partial = AnytimeScorer::search(query, ordered, AnytimeScorer::kAllResults, budget, &stats);
+    EXPECT_TRUE(stats.budgetExhausted);
+    EXPECT_EQ(stats.postingsScored, budget.maxPostings);
+    EXPECT_FALSE(partial.empty());
+    EXPECT_LT(partial.size(), docCount);
+
+    budget.maxPostings = totalPostings;
+    AnytimeScorer::search(query, ordered, 20, budget, &stats);
+    EXPECT_FALSE(stats.budgetExhausted);
+    EXPECT_EQ(stats.postingsScored, totalPostings);
+}
+
+// 19. DocIdFilter: редкий и плотный фильтры дают ту же выдачу, что и полный поиск с отбором
+TEST_F(RankingTest, DocIdFilterMatchesFilteredRanking)
+{
+    const uint32_t docCount = 5000;
+    setDocCount(docCount);
+    std::mt19937 rng(19);
+    const std::vector<std::string> words = {"кот", "пес", "дом", "лес"};
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        size_t length = 3 + rng() % 20;
+        for (size_t i = 0; i < length; ++i)
+            index.addTerm(words[std::min<size_t>(rng() % 8, words.size() - 1)], doc);
+    }
+
+    MappedIndex mapped;
+    ASSERT_TRUE(saveAndMap("ranking_filter.bin", mapped));
+
+    std::vector<std::string> query = {"кот", "лес", "дом"};
+    auto full = Scorer::search(query, mapped);
+
+    DocIdFilter filter;
+    for (uint32_t step : {1000u, 37u, 3u, 1u}) // От редкого фильтра к плотному
+    {
+        std::vector<uint32_t> allowed;
+        for (uint32_t doc = step / 2; doc < docCount; doc += step)
+            allowed.push_back(doc);
+        filter.assign(allowed.data(), allowed.size()); // Память прошлого фильтра переиспользуется
+        ASSERT_EQ(filter.size(), allowed.size());
+
+        std::vector<SearchResult> expected;
+        for (const auto &result : full)
+        {
+            if (std::binary_search(allowed.begin(), allowed.end(), result.docId))
+                expected.push_back(result);
+        }
+
+        for (size_t topK : {Scorer::kAllResults, (size_t)10})
+        {
+            for (QueryStrategy strategy : {QueryStrategy::Exhaustive, QueryStrategy::Wand,
+                                           QueryStrategy::BlockMaxWand, QueryStrategy::MaxScore})
+            {
+                auto fromFilter = Scorer::search(query, mapped, filter, topK, strategy);
+                auto fromList = Scorer::search(query, mapped, &allowed, topK, strategy);
+                size_t expectedSize = topK == Scorer::kAllResults ? expected.size() : std::min(topK, expected.size());
+                ASSERT_EQ(fromFilter.size(), expectedSize) << "step " << step;
+                ASSERT_EQ(fromList.size(), expectedSize);
+                for (size_t i = 0; i < expectedSize; ++i)
+                {
+                    EXPECT_EQ(fromFilter[i].docId, expected[i].docId);
+                    EXPECT_DOUBLE_EQ(fromFilter[i].score, expected[i].score);
+                    EXPECT_EQ(fromList[i].docId, expected[i].docId);
+                }
+            }
+        }
+
+        for (uint32_t doc = 0; doc < docCount; doc += 7)
+            EXPECT_EQ(filter.contains(doc), std::binary_search(allowed.begin(), allowed.end(), doc));
+        size_t position = 0;
+        for (uint32_t target : {0u, 1u, 500u, 2501u, 4999u, 6000u})
+        {
+            position = filter.seek(target, position);
+            auto expectedPos = std::lower_bound(allowed.begin(), allowed.end(), target) - allowed.begin();
+            EXPECT_EQ(position, (size_t)expectedPos) << "target " << target;
+        }
+    }
+
+}
+
+// 20. Фильтр, затем ранжирование: кандидаты булева запроса ранжируются так же, как
+// поиск с готовым списком разрешенных документов, но без этого списка
+TEST_F(RankingTest, BooleanCandidatesRankedLikeFilteredSearch)
+{
+    const uint32_t docCount = 5000;
+    setDocCount(docCount);
+    std::mt19937 rng(20);
+    const std::vector<std::string> words = {"путин", "газ", "нефть", "санкции"};
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        size_t length = 1 + rng() % 12;
+        for (size_t i = 0; i < length; ++i)
+            index.addTerm(words[std::min<size_t>(rng() % 7, words.size() - 1)], doc);
+    }
+
+    MappedIndex mapped;
+    ASSERT_TRUE(saveAndMap("ranking_boolean.bin", mapped));
+
+    // путин & (газ | нефть) & !санкции
+    BooleanNode query = BooleanNode::makeAnd(
+        BooleanNode::makeAnd(BooleanNode::makeTerm("путин"),
+                             BooleanNode::makeOr(BooleanNode::makeTerm("газ"), BooleanNode::makeTerm("нефть"))),
+        BooleanNode::makeNot(BooleanNode::makeTerm("санкции")));
+    std::vector<std::string> terms = BooleanPlanner::rankingTerms(query);
+    BooleanNode plan = BooleanPlanner::plan(query, mapped);
+    std::sort(terms.begin(), terms.end());
+    EXPECT_EQ(terms, (std::vector<std::string>{"газ", "нефть", "путин"}));
+
+    std::vector<uint32_t> allowed = collectDocIds(*openBooleanIterator(plan, mapped));
+    ASSERT_FALSE(allowed.empty());
+
+    for (size_t topK : {Scorer::kAllResults, (size_t)1, (size_t)10, (size_t)100})
+    {
+        auto expected = Scorer::search(terms, mapped, &allowed, topK);
+        SearchStats stats;
+        auto candidates = openBooleanIterator(plan, mapped);
+        auto ranked = Scorer::search(terms, mapped, *candidates, topK, &stats);
+        ASSERT_EQ(ranked.size(), expected.size()) << "topK " << topK;
+        for (size_t i = 0; i < ranked.size(); ++i)
+        {
+            EXPECT_EQ(ranked[i].docId, expected[i].docId);
+            EXPECT_DOUBLE_EQ(ranked[i].score, expected[i].score);
+        }
+        if (topK == Scorer::kAllResults)
+        {
+            EXPECT_EQ(ranked.size(), allowed.size()); // Каждый кандидат содержит "путин"
+        }
+        else
+            EXPECT_LT(stats.postingsScored, allowed.size() * terms.size());
+
+        // То же на индексе в памяти
+        auto inMemoryCandidates = openBooleanIterator(plan, index);
+        auto inMemory = Scorer::search(terms, index, *inMemoryCandidates, topK);
+        ASSERT_EQ(inMemory.size(), ranked.size());
+        for (size_t i = 0; i < ranked.size(); ++i)
+            EXPECT_EQ(inMemory[i].docId, ranked[i].docId);
+    }
+
+    // путин | !газ: в плане это !(газ ANDNOT путин), но "путин" остается словом для скора
+    BooleanNode either = BooleanNode::makeOr(BooleanNode::makeTerm("путин"),
+                                             BooleanNode::makeNot(BooleanNode::makeTerm("газ")));
+    std::vector<std::string> eitherTerms = BooleanPlanner::rankingTerms(either);
+    EXPECT_EQ(eitherTerms, std::vector<std::string>{"путин"});
+    BooleanNode eitherPlan = BooleanPlanner::plan(either, mapped);
+    EXPECT_EQ(eitherPlan.kind, BooleanNode::Kind::Not);
+    EXPECT_EQ(BooleanPlanner::rankingTerms(eitherPlan), eitherTerms);
+    {
+        auto candidates = openBooleanIterator(eitherPlan, mapped);
+        std::vector<uint32_t> allowed = collectDocIds(*openBooleanIterator(eitherPlan, mapped));
+        auto expected = Scorer::search(eitherTerms, mapped, &allowed, 10);
+        auto ranked = Scorer::search(eitherTerms, mapped, *candidates, 10);
+        ASSERT_EQ(ranked.size(), expected.size());
+        ASSERT_FALSE(ranked.empty());
+        EXPECT_GT(ranked[0].score, 0);
+        for (size_t i = 0; i < ranked.size(); ++i)
+            EXPECT_EQ(ranked[i].docId, expected[i].docId);
+    }
+
+    // Только отрицание: слов для скора нет, кандидаты идут по docId со скором 0
+    BooleanNode negativeQuery = BooleanNode::makeNot(BooleanNode::makeTerm("путин"));
+    EXPECT_TRUE(BooleanPlanner::rankingTerms(negativeQuery).empty());
+    BooleanNode negative = BooleanPlanner::plan(negativeQuery, mapped);
+    std::vector<uint32_t> withoutPutin = collectDocIds(*openBooleanIterator(negative, mapped));
+    auto candidates = openBooleanIterator(negative, mapped);
+    auto ranked = Scorer::search({}, mapped, *candidates, 10);
+    ASSERT_EQ(ranked.size(), std::min<size_t>(10, withoutPutin.size()));
+    for (size_t i = 0; i < ranked.size(); ++i)
+    {
+        EXPECT_EQ(ranked[i].docId, withoutPutin[i]);
+        EXPECT_EQ(ranked[i].score, 0);
+    }
+
+}
+
+// 21. Ранжированный AND: выдача - документы со всеми словами в порядке полного поиска,
+// при нехватке документов - обычная выдача OR
+TEST_F(RankingTest, ConjunctiveSearchRanksDocumentsWithAllTerms)
+{
+    const uint32_t docCount = 5000;
+    setDocCount(docCount);
+    std::mt19937 rng(21);
+    const std::vector<std::string> words = {"частое", "среднее", "редкое"};
+    std::vector<std::vector<bool>> has(words.size(), std::vector<bool>(docCount, false));
+    for (uint32_t doc = 0; doc < docCount; ++doc)
+    {
+        // Вероятности 1/2, 1/5 и 1/50: пересечение заметно меньше каждого списка
+        const uint32_t periods[] = {2, 5, 50};
+        for (size_t w = 0; w < words.size(); ++w)
+        {
+            if (rng() % periods[w] != 0)
+                continue;
+            for (size_t tf = 1 + rng() % 3; tf > 0; --tf)
+                index.addTerm(words[w], doc);
+            has[w][doc] = true;
+        }
+    }
+
+    MappedIndex mapped;
+    ASSERT_TRUE(saveAndMap("ranking_conjunctive.bin", mapped));
+
+    std::vector<std::string> query = {"частое", "редкое", "среднее"};
+    std::vector<SearchResult> expected;
+    for (const auto &result : Scorer::search(query, mapped))
+    {
+        if (has[0][result.docId] && has[1][result.docId] && has[2][result.docId])
+            expected.push_back(result);
+    }
+    ASSERT_GE(expected.size(), 10u);
+
+    for (size_t topK : {Scorer::kAllResults, (size_t)1, (size_t)10})
+    {
+        SearchStats stats;
+        auto results = Scorer::searchConjunctive(query, mapped, topK, QueryStrategy::MaxScore, &stats);
+        EXPECT_FALSE(stats.conjunctiveFallback);
+        size_t expectedSize = topK == Scorer::kAllResults ? expected.size() : topK;
+        ASSERT_EQ(results.size(), expectedSize);
+        for (size_t i = 0; i < expectedSize; ++i)
+        {
+            EXPECT_EQ(results[i].docId, expected[i].docId);
+            EXPECT_DOUBLE_EQ(results[i].score, expected[i].score);
+        }
+        // Полная выдача: скор считается только документам из пересечения
+        if (topK == Scorer::kAllResults)
+        {
+            EXPECT_EQ(stats.postingsScored, expected.size() * query.size());
+        }
+
+        auto inMemory = Scorer::searchConjunctive(query, index, topK);
+        ASSERT_EQ(inMemory.size(), results.size());
+        for (size_t i = 0; i < results.size(); ++i)
+            EXPECT_EQ(inMemory[i].docId, results[i].docId);
+    }
+
+    // Пересечение меньше topK или слова нет в индексе: выдача OR
+    for (const auto &fallbackQuery : {std::vector<std::string>{"частое", "редкое", "среднее"},
+                                      std::vector<std::string>{"частое", "нет"}})
+    {
+        size_t topK = fallbackQuery.size() == 2 ? 10 : expected.size() + 1;
+        SearchStats stats;
+        auto results = Scorer::searchConjunctive(fallbackQuery, mapped, topK, QueryStrategy::BlockMaxWand, &stats);
+        auto disjunctive = Scorer::search(fallbackQuery, mapped, nullptr, topK);
+        EXPECT_TRUE(stats.conjunctiveFallback);
+        ASSERT_EQ(results.size(), disjunctive.size());
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            EXPECT_EQ(results[i].docId, disjunctive[i].docId);
+            EXPECT_DOUBLE_EQ(results[i].score, disjunctive[i].score);
+        }
+    }
+    EXPECT_TRUE(Scorer::searchConjunctive({"нет"}, mapped, 10).empty());
+
+}